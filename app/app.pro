@@ -0,0 +1,144 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2017-10-11T21:38:41
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport concurrent
+
+TARGET = ImageProcessingKit
+TEMPLATE = app
+CONFIG += c++11
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which has been marked as deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if you use deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# the kernels, see core/core.pro
+INCLUDEPATH += $$PWD/../core
+DEPENDPATH += $$PWD/../core
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../core/release/ -lipkcore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../core/debug/ -lipkcore
+else:unix: LIBS += -L$$OUT_PWD/../core/ -lipkcore
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/libipkcore.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/libipkcore.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/ipkcore.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/ipkcore.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../core/libipkcore.a
+
+
+SOURCES += \
+        main.cpp \
+        im.cpp \
+    qgraphicssceneplus.cpp \
+    dialogadjusthsv.cpp \
+    dialoglineartransform.cpp \
+    dialogpiecewiselineartransformation.cpp \
+    dialogavaragefilter.cpp \
+    dialogmedianfilter.cpp \
+    dialogmaximumfilter.cpp \
+    dialogminimumfilter.cpp \
+    dialogcustomfilter.cpp \
+    dialogresize.cpp \
+    dialogmanualthreshold.cpp \
+    dialogerode.cpp \
+    dialogregiongrowth.cpp \
+    dialogdilate.cpp \
+    dialogopening.cpp \
+    dialogclosing.cpp \
+    dialogidealhighpassfilter.cpp \
+    dialogideallowpassfilter.cpp \
+    dialogbutterworthlowpassfilter.cpp \
+    dialogbutterworthhighpassfilter.cpp \
+    dialoghomomorphicfilter.cpp \
+    qcustomplot.cpp \
+    dialogmotionblur.cpp \
+    dialoginversefilter.cpp \
+    dialoggaussiannoise.cpp \
+    dialogatmosphericcirculation.cpp \
+    dialogwienerfilter.cpp \
+    dialogifft.cpp \
+    batch.cpp \
+    livepreview.cpp \
+    performancepanel.cpp \
+    tiledimageitem.cpp
+
+HEADERS += \
+        im.h \
+    qgraphicssceneplus.h \
+    dialogadjusthsv.h \
+    dialoglineartransform.h \
+    dialogpiecewiselineartransformation.h \
+    dialogavaragefilter.h \
+    dialogmedianfilter.h \
+    dialogmaximumfilter.h \
+    dialogminimumfilter.h \
+    dialogcustomfilter.h \
+    dialogresize.h \
+    dialogmanualthreshold.h \
+    dialogerode.h \
+    dialogregiongrowth.h \
+    dialogdilate.h \
+    dialogopening.h \
+    dialogclosing.h \
+    dialogidealhighpassfilter.h \
+    dialogideallowpassfilter.h \
+    dialogbutterworthlowpassfilter.h \
+    dialogbutterworthhighpassfilter.h \
+    dialoghomomorphicfilter.h \
+    qcustomplot.h \
+    dialogmotionblur.h \
+    dialoginversefilter.h \
+    dialoggaussiannoise.h \
+    dialogatmosphericcirculation.h \
+    dialogwienerfilter.h \
+    dialogifft.h \
+    batch.h \
+    livepreview.h \
+    performancepanel.h \
+    tiledimageitem.h
+
+FORMS += \
+        im.ui \
+    dialogadjusthsv.ui \
+    dialoglineartransform.ui \
+    dialogpiecewiselineartransformation.ui \
+    dialogavaragefilter.ui \
+    dialogmedianfilter.ui \
+    dialogmaximumfilter.ui \
+    dialogminimumfilter.ui \
+    dialogcustomfilter.ui \
+    dialogresize.ui \
+    dialogmanualthreshold.ui \
+    dialogerode.ui \
+    dialogregiongrowth.ui \
+    dialogdilate.ui \
+    dialogopening.ui \
+    dialogclosing.ui \
+    dialogidealhighpassfilter.ui \
+    dialogideallowpassfilter.ui \
+    dialogbutterworthlowpassfilter.ui \
+    dialogbutterworthhighpassfilter.ui \
+    dialoghomomorphicfilter.ui \
+    dialogmotionblur.ui \
+    dialoginversefilter.ui \
+    dialoggaussiannoise.ui \
+    dialogatmosphericcirculation.ui \
+    dialogwienerfilter.ui \
+    dialogifft.ui
+
+unix: LIBS += -lX11
+win32: LIBS += -lgdi32
+# resident set of ipkcore, see memory.cpp
+win32: LIBS += -lpsapi
@@ -0,0 +1,359 @@
+#include "batch.h"
+#include "bufferpool.h"
+#include "frequency.h"
+#include "imageio.h"
+#include "mappedimage.h"
+#include "memory.h"
+#include "operations.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include "synthetic.h"
+#include "tiled.h"
+#include "trace.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double milliseconds(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+void listOperations()
+{
+    for (const ipk::Operation &op : ipk::operations()) {
+        QString usage = QString(op.name) + (op.parameters[0] ? QString(":") + op.parameters : QString());
+        std::printf("  %-36s %s\n", qPrintable(usage), op.description);
+    }
+}
+
+} // namespace
+
+bool isBatchCommandLine(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--op") == 0 || std::strncmp(argv[i], "--op=", 5) == 0
+                || std::strcmp(argv[i], "--pipeline") == 0 || std::strncmp(argv[i], "--pipeline=", 11) == 0
+                || std::strcmp(argv[i], "--list-ops") == 0
+                || std::strcmp(argv[i], "--generate") == 0 || std::strncmp(argv[i], "--generate=", 11) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int runBatch(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Apply operations to image files, without any window.");
+    parser.addHelpOption();
+    QCommandLineOption opOption("op", "Operation, name or name:p1,p2,..., applied in order.", "operation");
+    QCommandLineOption pipelineOption("pipeline", "Pipeline file, one operation per line, applied before any --op.", "file");
+    QCommandLineOption savePipelineOption("save-pipeline", "Save all the operations as a pipeline file.", "file");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory.", "directory");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+                                  "Number of files processed at once, all hardware threads by default. The "
+                                  "memory peaks printed for a file include what the others take meanwhile.", "n");
+    QCommandLineOption tiledOption("tiled", "Run band by band through memory-mapped files, for images bigger than "
+                                   "memory. Local operations, resize and scale only. Outputs named *.ipk are "
+                                   "written as mapped image files, anything else is saved as usual at the end.");
+    QCommandLineOption sampleOption("samples", "Samples of *.ipk outputs: u8 (default), u16, u32 or float.", "type");
+    QCommandLineOption hugePageOption("huge-pages", "Transparent huge pages for the large blocks of the buffer pool "
+                                      "the frequency domain operations use, Linux only.");
+    QCommandLineOption precisionOption("fft-precision", "Planes of the frequency domain operations: float (default) "
+                                       "or double.", "type");
+    QCommandLineOption listOption("list-ops", "List the operations.");
+    QStringList patterns;
+    for (const std::string &name : ipk::syntheticPatternNames()) {
+        patterns << QString::fromStdString(name);
+    }
+    QCommandLineOption generateOption("generate", QString("Synthetic input, made in memory, as well as or instead of "
+                                      "files: %1. The output is named pattern-WxH.png, .ipk with --samples, which "
+                                      "keeps all the bits of the samples when there are no operations.")
+                                      .arg(patterns.join(", ")), "pattern");
+    QCommandLineOption sizeOption("size", "Size of --generate inputs, 1024x1024 by default.", "WxH");
+    QCommandLineOption channelOption("channels", "Channels of --generate inputs, 1 to 4, 3 by default.", "n");
+    QCommandLineOption seedOption("seed", "Seed of --generate inputs, 0 by default.", "n");
+    parser.addOption(opOption);
+    parser.addOption(pipelineOption);
+    parser.addOption(savePipelineOption);
+    parser.addOption(outputOption);
+    parser.addOption(jobsOption);
+    parser.addOption(tiledOption);
+    parser.addOption(sampleOption);
+    parser.addOption(hugePageOption);
+    parser.addOption(precisionOption);
+    parser.addOption(listOption);
+    parser.addOption(generateOption);
+    parser.addOption(sizeOption);
+    parser.addOption(channelOption);
+    parser.addOption(seedOption);
+    parser.addPositionalArgument("files", "Input image files.", "files...");
+    parser.process(arguments);
+
+    if (parser.isSet(listOption)) {
+        listOperations();
+        return 0;
+    }
+
+    ipk::Pipeline pipeline;
+    try {
+        if (parser.isSet(pipelineOption)) {
+            QFile file(parser.value(pipelineOption));
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                std::fprintf(stderr, "can't read %s\n", qPrintable(file.fileName()));
+                return 2;
+            }
+            pipeline = ipk::Pipeline::fromString(file.readAll().toStdString());
+        }
+        for (const QString &text : parser.values(opOption)) {
+            pipeline.append(ipk::parseOperation(text.toStdString()));
+        }
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+
+    // a grayscale first step is done as image files are read, straight
+    // from their decoded scanlines, the steps after it run as usual
+    ipk::GrayWeights grayWeights = ipk::GrayDefault;
+    bool readGray = false;
+    ipk::Pipeline afterGray;
+    try {
+        readGray = !pipeline.isEmpty() && ipk::grayscaleWeights(pipeline.steps().front(), grayWeights);
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+    for (std::size_t i = 1; readGray && i < pipeline.steps().size(); ++i) {
+        afterGray.append(pipeline.steps()[i]);
+    }
+
+    if (parser.isSet(savePipelineOption)) {
+        QFile file(parser.value(savePipelineOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)
+                || file.write(pipeline.toString().c_str()) < 0) {
+            std::fprintf(stderr, "can't write %s\n", qPrintable(file.fileName()));
+            return 2;
+        }
+    }
+
+    const QStringList files = parser.positionalArguments();
+    const QStringList generated = parser.values(generateOption);
+    // saving the pipeline alone is fine
+    if (files.isEmpty() && generated.isEmpty() && parser.isSet(savePipelineOption)) {
+        return 0;
+    }
+    if ((files.isEmpty() && generated.isEmpty()) || !parser.isSet(outputOption)) {
+        std::fprintf(stderr, "input files or --generate, and an output directory (-o) are required\n");
+        return 2;
+    }
+
+    int width = 1024, height = 1024, channels = 3;
+    if (parser.isSet(sizeOption)) {
+        const QStringList size = parser.value(sizeOption).split('x');
+        width = size.size() == 2 ? size[0].toInt() : 0;
+        height = size.size() == 2 ? size[1].toInt() : 0;
+    }
+    if (parser.isSet(channelOption)) {
+        channels = parser.value(channelOption).toInt();
+    }
+    if (width < 1 || height < 1 || channels < 1 || channels > 4) {
+        std::fprintf(stderr, "--size is WxH, --channels 1 to 4\n");
+        return 2;
+    }
+    for (const QString &pattern : generated) {
+        if (!patterns.contains(pattern)) {
+            std::fprintf(stderr, "unknown pattern %s\n", qPrintable(pattern));
+            return 2;
+        }
+    }
+    const std::uint32_t seed = parser.value(seedOption).toUInt();
+
+    QDir output(parser.value(outputOption));
+    if (!output.mkpath(".")) {
+        std::fprintf(stderr, "can't create %s\n", qPrintable(output.path()));
+        return 2;
+    }
+
+    // files run in parallel, and the kernels of each file share what is left
+    // generated inputs come after the files
+    const int inputCount = files.size() + generated.size();
+    int jobs = parser.isSet(jobsOption) ? parser.value(jobsOption).toInt() : ipk::threadCount();
+    jobs = std::max(1, std::min(jobs, inputCount));
+    const int threadsPerJob = std::max(1, ipk::threadCount()/jobs);
+
+    const QStringList sampleNames = QStringList() << "u8" << "u16" << "u32" << "float";
+    const int samples = parser.isSet(sampleOption) ? sampleNames.indexOf(parser.value(sampleOption)) : 0;
+    if (samples < 0) {
+        std::fprintf(stderr, "unknown sample type %s\n", qPrintable(parser.value(sampleOption)));
+        return 2;
+    }
+    const ipk::SampleType sampleType = static_cast<ipk::SampleType>(samples);
+
+    ipk::setHugePages(parser.isSet(hugePageOption));
+    if (parser.isSet(precisionOption)) {
+        const QString precision = parser.value(precisionOption);
+        if (precision != "float" && precision != "double") {
+            std::fprintf(stderr, "unknown precision %s\n", qPrintable(precision));
+            return 2;
+        }
+        ipk::setFftPrecision(precision == "float" ? ipk::FftFloat : ipk::FftDouble);
+    }
+    const bool tiled = parser.isSet(tiledOption);
+    if (tiled) {
+        for (const ipk::OperationStep &step : pipeline.steps()) {
+            if (!ipk::isTileable(step)) {
+                std::fprintf(stderr, "%s can't run with --tiled\n", step.operation->name);
+                return 2;
+            }
+        }
+    }
+
+    // where each input goes, by its file name, two of the same name
+    // would overwrite each other's result
+    QStringList inputNames, outNames;
+    for (int i = 0; i < inputCount; ++i) {
+        const bool synthetic = i >= files.size();
+        const QString fileName = synthetic ? QString("%1-%2x%3.%4").arg(generated[i - files.size()])
+                                             .arg(width).arg(height)
+                                             .arg(parser.isSet(sampleOption) ? "ipk" : "png")
+                                           : files[i];
+        const QString outName = output.filePath(QFileInfo(fileName).fileName());
+        const int other = outNames.indexOf(outName);
+        if (other >= 0) {
+            std::fprintf(stderr, "%s and %s would both be written to %s\n", qPrintable(inputNames[other]),
+                         qPrintable(fileName), qPrintable(outName));
+            return 2;
+        }
+        inputNames << fileName;
+        outNames << outName;
+    }
+
+    std::atomic<int> next(0);
+    std::atomic<int> failed(0);
+    std::mutex printMutex;
+    const Clock::time_point start = Clock::now();
+
+    auto worker = [&]() {
+        ipk::setThreadCount(threadsPerJob);
+        ipk::setTraceThreadName("batch job");
+        for (int i = next++; i < inputCount; i = next++) {
+            const bool synthetic = i >= files.size();
+            const ipk::SyntheticPattern pattern = synthetic ? ipk::syntheticPattern(
+                                                                  generated[i - files.size()].toStdString())
+                                                            : ipk::SyntheticScene;
+            const QString &fileName = inputNames.at(i);
+            ipk::TraceScope trace(fileName.toStdString(), "file");
+            const QString &outName = outNames.at(i);
+            QString error;
+            // image buffers above what was live, and the resident set, see memory.h
+            ipk::MemoryWatermark memory;
+            memory.start();
+            Clock::time_point t0 = Clock::now(), t1 = t0, t2 = t0, t3 = t0;
+
+            // mapped files are read as the pixels are needed,
+            // wider samples are converted into a temporary mapped file
+            // with no operations, synthetic ones go straight into an ipk
+            // output, so wide samples keep all their bits
+            const bool direct = synthetic && pipeline.isEmpty() && QFileInfo(outName).suffix() == "ipk";
+            ipk::Image img;
+            const ipk::Pipeline *steps = &pipeline;
+            if (direct) {
+                std::size_t stride = 0;
+                std::shared_ptr<unsigned char> samples = ipk::createMappedSamples(outName, width, height, channels,
+                                                                                  sampleType, stride);
+                if (samples) {
+                    ipk::fillSynthetic(samples.get(), stride, width, height, channels, sampleType, pattern, seed);
+                } else {
+                    error = "can't write " + outName;
+                }
+            } else if (synthetic) {
+                img = ipk::syntheticImage(width, height, channels, pattern, seed);
+            } else if (tiled && ipk::isMappedImageFile(fileName)) {
+                img = ipk::mapImage(fileName, output.path());
+            } else if (readGray) {
+                img = ipk::loadGrayscale(fileName, grayWeights);
+                steps = &afterGray;
+            } else {
+                img = ipk::loadImage(fileName);
+            }
+            t1 = Clock::now();
+            if (direct) {
+                t2 = t3 = t1;
+            } else if (img.isNull()) {
+                error = "can't read";
+            } else {
+                try {
+                    const bool ipkOutput = QFileInfo(outName).suffix() == "ipk";
+                    // the last pass writes the output itself, if it needs no conversion
+                    const bool mapped = tiled && ipkOutput && sampleType == ipk::SampleUInt8;
+                    if (ipkOutput && !synthetic && QFileInfo(outName) == QFileInfo(fileName)) {
+                        // the input is still mapped
+                        throw std::invalid_argument("the output would overwrite the input");
+                    }
+                    if (tiled) {
+                        // passes before the last one go to temporary files next to the output
+                        img = ipk::runTiled(*steps, img, [&](int width, int height, int channels, bool final) {
+                            return final && mapped ? ipk::createMappedImage(outName, width, height, channels)
+                                                   : ipk::createTemporaryMappedImage(output.path(), width, height, channels);
+                        });
+                    } else {
+                        img = steps->run(img);
+                    }
+                    t2 = Clock::now();
+                    if (!mapped && !(ipkOutput ? ipk::saveMappedImage(img, outName, sampleType)
+                                            : ipk::saveImage(img, outName))) {
+                        error = "can't write " + outName;
+                    }
+                    t3 = Clock::now();
+                } catch (const std::exception &e) {
+                    error = e.what();
+                }
+            }
+
+            memory.finish();
+
+            std::lock_guard<std::mutex> lock(printMutex);
+            if (error.isEmpty()) {
+                std::printf("%s: %.1f ms (load %.1f, ops %.1f, save %.1f), peak %.1f MB, RSS %.1f MB\n",
+                            qPrintable(fileName), milliseconds(t0, t3), milliseconds(t0, t1), milliseconds(t1, t2),
+                            milliseconds(t2, t3), memory.peakBytes()/1048576.0, memory.peakResident()/1048576.0);
+            } else {
+                ++failed;
+                std::fprintf(stderr, "%s: %s\n", qPrintable(fileName), qPrintable(error));
+            }
+            std::fflush(stdout);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < jobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    std::printf("%d files, %d failed, %.1f ms, %d jobs\n", inputCount, failed.load(),
+                milliseconds(start, Clock::now()), jobs);
+
+    return failed ? 1 : 0;
+}
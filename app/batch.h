@@ -0,0 +1,22 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <QStringList>
+
+// headless batch mode
+// ImageProcessingKit --op median:5 --op otsu in/*.png -o out/
+// ImageProcessingKit --pipeline steps.txt in/*.png -o out/
+// ImageProcessingKit --tiled --op median:5 --op scale:0.5 huge.ipk -o out/
+// every file goes through the operations in order and is saved in the
+// output directory under the same name, files are processed in parallel
+// by a bounded number of workers, each one reporting its timing
+// with --tiled, images go band by band between memory-mapped files,
+// so they needn't fit in memory
+
+// true if the command line asks for the batch mode, so that
+// main() knows not to create any widget
+bool isBatchCommandLine(int argc, char *argv[]);
+// QCoreApplication must exist, returns the process exit code
+int runBatch(const QStringList &arguments);
+
+#endif // BATCH_H
@@ -14,15 +14,21 @@ DialogAdjustHsv::~DialogAdjustHsv()
     delete ui;
 }
 
-void DialogAdjustHsv::on_buttonBox_accepted()
+void DialogAdjustHsv::hsvValues(int &h, float &s, float &v) const
 {
-    int h = ui->horizontalSlider_H->value();
-    qreal s, v;
     float sliderRange = 100.0f;
     float lambdaRange = 4.0f;
 
+    h = ui->horizontalSlider_H->value();
     s = ui->horizontalSlider_S->value()/sliderRange*lambdaRange;
     v = ui->horizontalSlider_V->value()/sliderRange*lambdaRange;
+}
+
+void DialogAdjustHsv::on_buttonBox_accepted()
+{
+    int h;
+    float s, v;
+    hsvValues(h, s, v);
 
     emit sendHsvData(h, s, v);
 }
@@ -30,6 +36,11 @@ void DialogAdjustHsv::on_buttonBox_accepted()
 void DialogAdjustHsv::on_horizontalSlider_H_valueChanged(int value)
 {
     ui->label_H_Value->setText(tr("%1").arg(value));
+
+    int h;
+    float s, v;
+    hsvValues(h, s, v);
+    emit previewHsvData(h, s, v);
 }
 
 void DialogAdjustHsv::on_horizontalSlider_S_valueChanged(int value)
@@ -43,6 +54,11 @@ void DialogAdjustHsv::on_horizontalSlider_S_valueChanged(int value)
     float lambda = value/sliderRange*lambdaRange;
 
     ui->label_S_Value->setText(QString::number(lambda));
+
+    int h;
+    float s, v;
+    hsvValues(h, s, v);
+    emit previewHsvData(h, s, v);
 }
 
 void DialogAdjustHsv::on_horizontalSlider_V_valueChanged(int value)
@@ -53,4 +69,9 @@ void DialogAdjustHsv::on_horizontalSlider_V_valueChanged(int value)
     float lambda = value/sliderRange*lambdaRange;
 
     ui->label_V_Value->setText(QString::number(lambda));
+
+    int h;
+    float s, v;
+    hsvValues(h, s, v);
+    emit previewHsvData(h, s, v);
 }
@@ -18,8 +18,13 @@ public:
 private:
     Ui::DialogAdjustHsv *ui;
 
+    // h, s & v as set by the sliders
+    void hsvValues(int &h, float &s, float &v) const;
+
 signals:
     void sendHsvData(const int &h, const float &s, const float &v);
+    // on every change, for a live preview
+    void previewHsvData(const int &h, const float &s, const float &v);
 
 private slots:
     void on_buttonBox_accepted();
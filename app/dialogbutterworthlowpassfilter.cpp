@@ -17,3 +17,13 @@ void DialogButterworthLowPassFilter::on_buttonBox_accepted()
 {
     emit sendData(ui->spinBoxOrder->value(), ui->spinBoxFrequency->value());
 }
+
+void DialogButterworthLowPassFilter::on_spinBoxOrder_valueChanged(int value)
+{
+    emit previewData(value, ui->spinBoxFrequency->value());
+}
+
+void DialogButterworthLowPassFilter::on_spinBoxFrequency_valueChanged(int value)
+{
+    emit previewData(ui->spinBoxOrder->value(), value);
+}
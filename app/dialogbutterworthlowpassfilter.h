@@ -17,10 +17,16 @@ public:
 
 signals:
     void sendData(const int &Order, const int &D0);
+    // on every change, for a live preview
+    void previewData(const int &Order, const int &D0);
 
 private slots:
     void on_buttonBox_accepted();
 
+    void on_spinBoxOrder_valueChanged(int value);
+
+    void on_spinBoxFrequency_valueChanged(int value);
+
 private:
     Ui::DialogButterworthLowPassFilter *ui;
 };
@@ -42,11 +42,13 @@ void DialogLinearTransform::plotTranformationFunction(const double &k, const dou
 void DialogLinearTransform::on_doubleSpinBox_k_valueChanged(double arg1)
 {
     plotTranformationFunction(arg1, ui->doubleSpinBox_b->value());
+    emit previewData(arg1, ui->doubleSpinBox_b->value());
 }
 
 void DialogLinearTransform::on_doubleSpinBox_b_valueChanged(double arg1)
 {
     plotTranformationFunction(ui->doubleSpinBox_k->value(), arg1);
+    emit previewData(ui->doubleSpinBox_k->value(), arg1);
 }
 
 void DialogLinearTransform::on_buttonBox_accepted()
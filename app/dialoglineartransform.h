@@ -17,6 +17,8 @@ public:
 
 signals:
     void sendData(const double &k, const double &b);
+    // on every change, for a live preview
+    void previewData(const double &k, const double &b);
 
 private slots:
     void on_doubleSpinBox_k_valueChanged(double arg1);
@@ -22,6 +22,8 @@ private slots:
 
 signals:
     void sendData(const int &threshold);
+    // on every change, for a live preview
+    void previewData(const int &threshold);
 private:
     Ui::DialogManualThreshold *ui;
 };
@@ -1,5 +1,6 @@
 #include "dialogresize.h"
 #include "ui_dialogresize.h"
+#include "resample.h"
 
 DialogResize::DialogResize(QWidget *parent) :
     QDialog(parent),
@@ -16,15 +17,21 @@ DialogResize::~DialogResize()
 void DialogResize::on_buttonBox_accepted()
 {
     // default interpolation type is Bilinear Interpolation
-    int interpolationType = 3;
+    int interpolationType = ipk::ResampleBilinear;
     if (ui->radioButtonNearest->isChecked()) {
-        interpolationType = 1;
+        interpolationType = ipk::ResampleNearest;
     }
     if (ui->radioButtonBilinear->isChecked()) {
-        interpolationType = 3;
+        interpolationType = ipk::ResampleBilinear;
     }
     if (ui->radioButtonCubic->isChecked()) {
-        interpolationType = 5;
+        interpolationType = ipk::ResampleBicubic;
+    }
+    if (ui->radioButtonLanczos->isChecked()) {
+        interpolationType = ipk::ResampleLanczos3;
+    }
+    if (ui->radioButtonArea->isChecked()) {
+        interpolationType = ipk::ResampleArea;
     }
     sendData(ui->doubleSpinBoxWidth->value(), ui->doubleSpinBoxHeight->value(), interpolationType);
 }
@@ -19,6 +19,7 @@ private:
     Ui::DialogResize *ui;
 
 signals:
+    // interpolationType is one of ipk::ResampleFilter
     void sendData(const double &wFacotr, const double &hFactor, const int &interpolationType);
 private slots:
     void on_buttonBox_accepted();
@@ -0,0 +1,1877 @@
+#include "im.h"
+#include "ui_im.h"
+#include <QDebug>
+#include <QColor>
+#include <QRgb>
+#include <algorithm>
+#include "qcustomplot.h"
+#include <QtGlobal>
+#include <QtMath>
+#include <QStack>
+#include <QPoint>
+#include <QFileInfo>
+#include <QRegExp>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include "arithmetic.h"
+#include "bufferpool.h"
+#include "colortransform.h"
+#include "filters.h"
+#include "frequency.h"
+#include "grayscale.h"
+#include "histogram.h"
+#include "imageio.h"
+#include "operations.h"
+#include "profiler.h"
+#include "resample.h"
+#include "trace.h"
+#include "warp.h"
+
+namespace {
+
+// a pipeline step, as the command line writes it: name:p1,p2,...
+QString stepText(const QString &name, const QList<double> &parameters = QList<double>())
+{
+    QStringList items;
+    for (double value : parameters) {
+        items << QString::number(value, 'g', 12);
+    }
+
+    return items.isEmpty() ? name : name + ":" + items.join(',');
+}
+
+// what the buffer pool keeps at most for the largest images, its default
+const std::size_t maxPoolBytes = std::size_t(1) << 30;
+
+QList<double> elementValues(const unsigned char element[9])
+{
+    QList<double> values;
+    for (int k = 0; k < 9; ++k) {
+        values << element[k];
+    }
+
+    return values;
+}
+
+} // namespace
+
+im::im(QWidget *parent) :
+    QMainWindow(parent),
+    ui(new Ui::im),
+    inputId(0)
+{
+    ui->setupUi(this);
+
+    // TOTO:
+    // set mouse tracking, by default, mouse tracking is only enable the mouse button is pressed
+    // however, I could not figure out why it doesn't work here.
+    if (!hasMouseTracking()) {
+        setMouseTracking(true);
+    }
+
+    // create new QGraphicsScene obeject, and binding to ui widget.
+    inScene = new QGraphicsScenePlus;
+    outScene = new QGraphicsScenePlus;
+    ui->graphicsView_in->setScene(inScene);
+    ui->graphicsView_out->setScene(outScene);
+
+    // the image items stay in the scenes, only their images change
+    inItem = new TiledImageItem;
+    outItem = new TiledImageItem;
+    inScene->addItem(inItem);
+    outScene->addItem(outItem);
+    previewItem = outScene->addPixmap(QPixmap());
+    previewItem->setZValue(1);
+    previewItem->hide();
+
+    // connect signal and slot
+    // once coord change, we emit a sinal from mouseMoveEvent
+    // and then a slot is called to show the color value
+    connect(inScene, SIGNAL(coordChanged(const QPointF&)), this, SLOT(showColorValue(const QPointF&)));
+    // shift + drag on the input image restricts operations to a rectangle
+    connect(inScene, SIGNAL(roiSelected(const QRect&)), this, SLOT(setRoi(const QRect&)));
+    // use bmp for compatiable for Windows
+#ifdef Q_OS_WIN
+      resultFileName = "tmp.bmp";
+      sourceFileName = "source.bmp";
+#else
+    resultFileName = "tmp.png";
+    sourceFileName = "source.png";
+#endif
+
+    livePreview = new LivePreview(this);
+    connect(livePreview, SIGNAL(ready(QImage)), this, SLOT(showPreview(QImage)));
+
+    // the docks are listed in the pipeline menu, so they can be shown again
+    performancePanel = new PerformancePanel(this);
+    addDockWidget(Qt::RightDockWidgetArea, performancePanel);
+    performancePanel->hide();
+    ui->menuPipeline->addSeparator();
+    ui->menuPipeline->addAction(ui->dockWidget_Pipeline->toggleViewAction());
+    ui->menuPipeline->addAction(performancePanel->toggleViewAction());
+
+    // a trace started by IPK_TRACE (see main.cpp) is stopped here as well
+    traceAction = ui->menuPipeline->addAction(tr("Record &Trace..."));
+    traceAction->setCheckable(true);
+    traceAction->setToolTip(tr("Record what every thread does, for chrome://tracing or Perfetto"));
+    if (ipk::isTracing()) {
+        traceFileName = QString::fromLocal8Bit(qgetenv("IPK_TRACE"));
+        traceAction->setChecked(true);
+    }
+    connect(traceAction, SIGNAL(triggered(bool)), this, SLOT(recordTrace(bool)));
+
+    // float by default, double is what the filters always computed in
+    ui->menuFrequency_Filter->addSeparator();
+    QAction *precisionAction = ui->menuFrequency_Filter->addAction(tr("&Double Precision"));
+    precisionAction->setCheckable(true);
+    precisionAction->setChecked(ipk::fftPrecision() == ipk::FftDouble);
+    precisionAction->setToolTip(tr("Compute the frequency filters in double rather than float"));
+    connect(precisionAction, SIGNAL(toggled(bool)), this, SLOT(setDoublePrecision(bool)));
+}
+
+im::~im()
+{
+    if (ipk::isTracing()) {
+        ipk::stopTracing(traceFileName);
+    }
+    delete ui;
+}
+
+// clear image diplayed in scene
+void im::cleanImage()
+{
+    inScene->clearRoi();
+    roi = QRect();
+    inItem->setPyramid(ipk::ImagePyramid());
+    outItem->setPyramid(ipk::ImagePyramid());
+    // blocks sized for the image closed, the kernels' or the previews'
+    ipk::trimBufferPool();
+}
+
+void im::on_action_Quit_triggered()
+{
+    QApplication::quit();
+}
+
+void im::on_action_Open_triggered()
+{
+    QString imagePath = QFileDialog::getOpenFileName(
+                this, tr("Open file"), QDir::homePath(), imageFormat);
+
+    // check if file is valid
+    if (!imagePath.isEmpty()) {
+        QFile file(imagePath);
+
+        if(!file.open(QIODevice::ReadOnly)) {
+            QMessageBox::critical(this, tr("Error"), tr("Unable to read image!"));
+            return;
+        }
+        ipk::OperationTimer timer("open");
+
+        // reopening the result continues the pipeline with the steps shown,
+        // anything else starts a new one
+        const bool isResult = QFileInfo(imagePath) == QFileInfo(resultFileName);
+        if (isResult && !pendingSteps.isEmpty()) {
+            pipeline.append(ipk::Pipeline::fromString(pendingSteps.toStdString()));
+            pendingSteps.clear();
+        } else {
+            startPipeline(imagePath);
+        }
+
+        showInput(imagePath);
+
+        // the result is the current image of the history already,
+        // anything else starts a new history
+        if (!isResult || history.isEmpty()) {
+            history.clear();
+            historyNotes.clear();
+            history.push(inputImage());
+        }
+        inputId = history.currentId();
+        updateHistoryActions();
+        updatePipelineDock();
+
+        timer.setPixels(static_cast<std::uint64_t>(inputImage().width())*inputImage().height());
+        performancePanel->addProfile(timer.finish());
+    }
+}
+
+void im::startPipeline(const QString &imagePath)
+{
+    pipeline.clear();
+    pendingSteps.clear();
+    pipelineSource = imagePath;
+
+    // the result file is overwritten by the next step, so keep a copy
+    if (QFileInfo(imagePath) == QFileInfo(resultFileName)) {
+        QFile::remove(sourceFileName);
+        pipelineSource = QFile::copy(imagePath, sourceFileName) ? sourceFileName : QString();
+    }
+}
+
+void im::showInput(const QString &imagePath)
+{
+    // clear previouly showed image
+    cleanImage();
+
+    // show image
+    // the pyramid is made once, for the view and the previews
+    ipk::ScopedTimer timer("display");
+    inItem->setPyramid(ipk::ImagePyramid(readImage(imagePath)));
+    inScene->setSceneRect(inItem->boundingRect());
+
+    // the pool keeps the planes of kernels run again at this size, four
+    // doubles a sample for the deblurring filters, and as much again for
+    // the previews and the regions of interest, not a whole gigabyte
+    const ipk::Image img = inputImage();
+    const std::size_t samples = static_cast<std::size_t>(img.width())*img.height()*img.channels();
+    ipk::setBufferPoolLimit(std::min(maxPoolBytes, 2*4*sizeof(double)*samples));
+
+    // save fileName for later use
+    setFileName(imagePath);
+}
+
+void im::on_action_Save_As_triggered()
+{
+    QString savePath = QFileDialog::getSaveFileName(this, tr("Save image"), QDir::homePath(), imageFormat);
+
+    if (!savePath.isEmpty()) {
+        QFile file(savePath);
+
+        if (!file.open(QIODevice::WriteOnly)) {
+            QMessageBox::critical(this, tr("Error"), tr("Unable to save image!"));
+            return;
+        }
+
+        // save output image to file
+        ipk::saveImage(outItem->image(), savePath);
+        // update saveFileName, so that one could just save it
+        setSaveFileName(savePath);
+    }
+}
+
+void im::on_action_Close_triggered()
+{
+    cleanImage();
+    // also set fileName to empty
+    setFileName("");
+}
+
+void im::showColorValue(const QPointF &position)
+{
+    // the input image is at hand, no need to read the file again
+    ipk::Image img = inItem->image();
+
+    if (img.isNull()) {
+        return;
+    }
+
+    // map position from scene to current item
+    QPointF pos = inItem->mapFromScene(position);
+    QPoint pixel(qFloor(pos.x()), qFloor(pos.y()));
+    if (!QRect(0, 0, img.width(), img.height()).contains(pixel)) {
+        return;
+    }
+
+    const unsigned char *value = img.scanLine(pixel.y()) + pixel.x()*img.channels();
+    ui->label_coord->setText(tr("coord: %1, %2").arg(pixel.x()).arg(pixel.y()));
+    if (img.isRGB()) {
+        int gray = qGray(value[0], value[1], value[2]);
+        ui->label_color_value->setText(tr("R: %1\tG: %2\tB: %3\tgray: %4").arg(value[0]).arg(value[1]).arg(value[2]).arg(gray));
+    } else {
+        ui->label_color_value->setText(tr("gray: %4").arg(value[0]));
+    }
+}
+
+void im::adjustHsv(const int &h, const float &s, const float &v)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isRGB()) {
+        // for RGB image, convert to HSV, adjust HSV
+        // and then convert back to RGB, all in one pass
+        runKernel("hsv", [&]() { return mergeRoi(img, ipk::adjustHsv(roiView(img), h, s, v)); },
+                  stepText("hsv", QList<double>() << h << s << v));
+    } else if (img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not an RGB image."));
+        return;
+    } else {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+}
+
+void im::linearTransformation(const double &k, const double &b)
+{
+    ipk::Image img = inputImage();
+
+    // grayscale image, just do it
+    // RGB image, adjust V of HSV
+    if (img.isGrayscale() || img.isRGB()) {
+        runKernel("linear", [&]() { return mergeRoi(img, ipk::linearTransformation(roiView(img), k, b)); },
+                  stepText("linear", QList<double>() << k << b));
+    } else {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+}
+
+void im::piecewiseLinearTransformation(const double &r1, const double &s1, const double &r2, const double &s2)
+{
+    ipk::Image img = inputImage();
+
+    // for grayscale image, just do the transformation
+    // for RGB image, adjust Y of YUV
+    // why not HSV, and adjust V?
+    // V range (0, 100%), Y range (0, 255)
+    // the transformation assume gray range (0, 255)
+    if (img.isGrayscale() || img.isRGB()) {
+        runKernel("piecewise", [&]() {
+            return mergeRoi(img, ipk::piecewiseLinearTransformation(roiView(img), r1, s1, r2, s2));
+        }, stepText("piecewise", QList<double>() << r1 << s1 << r2 << s2));
+    } else {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+}
+
+void im::averageFilter(const int &size)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("average", [&]() { return mergeRoi(img, ipk::averageFilter(roiView(img), size)); },
+              stepText("average", QList<double>() << size));
+}
+
+void im::medianFilter(const int &size)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("median", [&]() { return mergeRoi(img, ipk::medianFilter(roiView(img), size)); },
+              stepText("median", QList<double>() << size));
+}
+
+// maximum filter
+// replace every pixel with the maximum of the size x size window
+// around it, done as a row pass and a column pass
+void im::maximumFilter(const int &size)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("max", [&]() { return mergeRoi(img, ipk::maximumFilter(roiView(img), size)); },
+              stepText("max", QList<double>() << size));
+}
+
+// minimum filter, just like maximum filter
+// but use minimum instead of maximum
+void im::minimumFilter(const int &size)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("min", [&]() { return mergeRoi(img, ipk::minimumFilter(roiView(img), size)); },
+              stepText("min", QList<double>() << size));
+}
+
+void im::invertFilter(const int &noiseType,
+                      const int &D0,
+                      const double &variance,
+                      const int &length,
+                      const int &angle)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("inverse", [&]() {
+        return ipk::inverseFilter(img, static_cast<ipk::NoiseType>(noiseType), D0, variance, length, angle);
+    }, noiseType == ipk::NoiseNone   // random noise can't be replayed
+       ? stepText("inverse", QList<double>() << noiseType << D0 << variance << length << angle) : QString());
+}
+
+void im::customFilter(const int &w00, const int &w01, const int &w02, const int &w10, const int &w11, const int &w12, const int &w20, const int &w21, const int &w22)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    // if sum of all weights is not zero, they're divided by 9
+    const int weights[9] = { w00, w01, w02, w10, w11, w12, w20, w21, w22 };
+    runKernel("custom", [&]() { return mergeRoi(img, ipk::customFilter(roiView(img), weights)); },
+              stepText("custom", QList<double>() << w00 << w01 << w02 << w10 << w11 << w12 << w20 << w21 << w22));
+}
+
+void im::resize(const double &wFactor, const double &hFactor, const int &interpolationType)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    int width = std::max(1, static_cast<int>(round(img.width()*wFactor)));
+    int height = std::max(1, static_cast<int>(round(img.height()*hFactor)));
+    QString step = wFactor == hFactor
+            ? stepText("scale", QList<double>() << wFactor << interpolationType)
+            : stepText("resize", QList<double>() << width << height << interpolationType);
+    runKernel("resize", [&]() {
+        return ipk::resize(img, width, height, static_cast<ipk::ResampleFilter>(interpolationType));
+    }, step);
+}
+
+void im::threshold(const int &threshold)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error"), tr("Non-grayscale image."));
+        return;
+    }
+
+    runKernel("threshold", [&]() { return mergeRoi(img, ipk::threshold(roiView(img), threshold)); },
+              stepText("threshold", QList<double>() << threshold));
+}
+
+void im::erode(unsigned char structureElement[3][3])
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    unsigned char element[9];
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 3; ++x) {
+            element[y*3 + x] = structureElement[x][y];
+        }
+    }
+
+    runKernel("erode", [&]() { return mergeRoi(img, ipk::erode(roiView(img), element)); },
+              stepText("erode", elementValues(element)));
+}
+
+void im::regionGrowth(const QPoint &seed, const int &threshold)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    // grow on the gray levels
+    if (img.isRGB()) {
+        img = ipk::toGrayscale(img);
+    }
+
+    runKernel("region-growth", [&]() { return ipk::regionGrowth(img, seed.x(), seed.y(), threshold); });
+}
+
+void im::dilate(unsigned char structureElement[3][3])
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    unsigned char element[9];
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 3; ++x) {
+            element[y*3 + x] = structureElement[x][y];
+        }
+    }
+
+    runKernel("dilate", [&]() { return mergeRoi(img, ipk::dilate(roiView(img), element)); },
+              stepText("dilate", elementValues(element)));
+}
+
+void im::opening(unsigned char structureElement[3][3])
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    unsigned char element[9];
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 3; ++x) {
+            element[y*3 + x] = structureElement[x][y];
+        }
+    }
+
+    runKernel("opening", [&]() { return mergeRoi(img, ipk::opening(roiView(img), element)); },
+              stepText("opening", elementValues(element)));
+}
+
+void im::closing(unsigned char structureElement[3][3])
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    unsigned char element[9];
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 3; ++x) {
+            element[y*3 + x] = structureElement[x][y];
+        }
+    }
+
+    runKernel("closing", [&]() { return mergeRoi(img, ipk::closing(roiView(img), element)); },
+              stepText("closing", elementValues(element)));
+}
+
+void im::idealHighPassFilter(const int &D0)
+{
+    ipk::Image img = inputImage();
+
+    // only deal with grayscale image
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Non-grayscale image!"));
+        return;
+    }
+
+    runKernel("ideal-highpass", [&]() { return ipk::idealHighPassFilter(img, D0); },
+              stepText("ideal-highpass", QList<double>() << D0));
+}
+
+void im::idealLowPassFilter(const int &D0)
+{
+    ipk::Image img = inputImage();
+
+    // only deal with grayscale image
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Non-grayscale image!"));
+        return;
+    }
+
+    runKernel("ideal-lowpass", [&]() { return ipk::idealLowPassFilter(img, D0); },
+              stepText("ideal-lowpass", QList<double>() << D0));
+}
+
+void im::butterworthLowPassFilter(const int &Order, const int &D0)
+{
+    ipk::Image img = inputImage();
+
+    // only deal with grayscale image
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Non-grayscale image!"));
+        return;
+    }
+
+    runKernel("butterworth-lowpass", [&]() { return ipk::butterworthLowPassFilter(img, Order, D0); },
+              stepText("butterworth-lowpass", QList<double>() << Order << D0));
+}
+
+void im::butterworthHighPassFilter(const int &Order, const int &D0)
+{
+    ipk::Image img = inputImage();
+
+    // only deal with grayscale image
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Non-grayscale image!"));
+        return;
+    }
+
+    runKernel("butterworth-highpass", [&]() { return ipk::butterworthHighPassFilter(img, Order, D0); },
+              stepText("butterworth-highpass", QList<double>() << Order << D0));
+}
+
+void im::homomorphicFilter(const double &gammaL, const double &gammaH, const double &c, const int &D0)
+{
+    ipk::Image img = inputImage();
+
+    // only deal with grayscale image
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Non-grayscale image!"));
+        return;
+    }
+
+    runKernel("homomorphic", [&]() { return ipk::homomorphicFilter(img, gammaL, gammaH, c, D0); },
+              stepText("homomorphic", QList<double>() << gammaL << gammaH << c << D0));
+}
+
+void im::motionBlur(const int &length, const int &angle)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("motion-blur", [&]() { return ipk::motionBlur(img, length, angle); },
+              stepText("motion-blur", QList<double>() << length << angle));
+}
+
+void im::gaussianNoise(const double &variance)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    // random noise can't be replayed, so it isn't a step of the pipeline
+    runKernel("gaussian-noise", [&]() { return ipk::gaussianNoise(img, variance); });
+}
+
+void im::atmosphericCirculationBlur(const double &k)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("atmospheric", [&]() { return ipk::atmosphericCirculationBlur(img, k); },
+              stepText("atmospheric", QList<double>() << k));
+}
+
+void im::wienerFilter(const int &noiseType,
+                  const double &variance,
+                  const int &length,
+                  const int &angle,
+                  const double &k)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("wiener", [&]() {
+        return ipk::wienerFilter(img, static_cast<ipk::NoiseType>(noiseType), variance, length, angle, k);
+    }, noiseType == ipk::NoiseNone
+       ? stepText("wiener", QList<double>() << noiseType << variance << length << angle << k) : QString());
+}
+
+void im::ifft(const int &ifftType)
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("ifft", [&]() { return ipk::ifft(img, static_cast<ipk::IfftPart>(ifftType)); },
+              stepText("ifft", QList<double>() << ifftType));
+}
+
+void im::setFileName(const QString &fileName)
+{
+    this->fileName = fileName;
+}
+
+void im::setSaveFileName(const QString &saveFileName)
+{
+    this->saveFileName = saveFileName;
+}
+
+void im::updateOutScene(const ipk::Image &img)
+{
+    ipk::ScopedTimer timer("display");
+    outItem->setPyramid(ipk::ImagePyramid(img));
+    outScene->setSceneRect(outItem->boundingRect());
+}
+
+ipk::Image im::readImage(const QString &fileName)
+{
+    return ipk::loadImage(fileName);
+}
+
+ipk::Image im::inputImage() const
+{
+    return inItem->image();
+}
+
+void im::setRoi(const QRect &rect)
+{
+    roi = rect;
+
+    if (roi.isEmpty()) {
+        statusBar()->clearMessage();
+    } else {
+        statusBar()->showMessage(tr("region of interest: %1, %2, %3 x %4")
+                                 .arg(roi.x()).arg(roi.y()).arg(roi.width()).arg(roi.height()));
+    }
+}
+
+ipk::ImageView im::roiView(const ipk::Image &img) const
+{
+    if (roi.isEmpty()) {
+        return img;
+    }
+
+    ipk::ImageView view = ipk::ImageView(img).cropped(roi.x(), roi.y(), roi.width(), roi.height());
+    // a stale rectangle outside the image falls back to the whole image
+    return view.isNull() ? ipk::ImageView(img) : view;
+}
+
+ipk::Image im::mergeRoi(const ipk::Image &img, const ipk::Image &result) const
+{
+    if (result.width() == img.width() && result.height() == img.height()) {
+        return result;
+    }
+
+    ipk::Image merged = img.copy();
+    ipk::copyPixels(result, roiView(merged));
+
+    return merged;
+}
+
+void im::showResult(const ipk::Image &img, const QString &steps)
+{
+    {
+        ipk::ScopedTimer timer("save result");
+        ipk::saveImage(img, resultFileName);
+    }
+    updateOutScene(img);
+    // steps on a region of interest can't be replayed on other images
+    pendingSteps = roi.isEmpty() ? steps : QString();
+    updatePipelineDock();
+
+    // the history replays the steps only from the input image itself
+    ipk::Pipeline replay;
+    if (history.currentId() == inputId) {
+        replay = ipk::Pipeline::fromString(pendingSteps.toStdString());
+    }
+    {
+        ipk::ScopedTimer timer("history");
+        history.push(img, replay);
+    }
+    historyNotes[history.currentId()] = qMakePair(inputId, pendingSteps);
+    updateHistoryActions();
+}
+
+void im::showHistoryImage(const ipk::Image &img)
+{
+    ipk::saveImage(img, resultFileName);
+    updateOutScene(img);
+
+    // the steps shown still hold if they were from the same input image
+    QPair<quint64, QString> note = historyNotes.value(history.currentId());
+    pendingSteps = note.first == inputId ? note.second : QString();
+    updatePipelineDock();
+    updateHistoryActions();
+}
+
+void im::updateHistoryActions()
+{
+    ui->action_Undo->setEnabled(history.canUndo());
+    ui->action_Redo->setEnabled(history.canRedo());
+    statusBar()->showMessage(tr("history: %1 of %2, %3 MB")
+                             .arg(history.index() + 1).arg(history.count())
+                             .arg(history.memoryUsage() >> 20));
+}
+
+void im::on_action_Undo_triggered()
+{
+    if (history.canUndo()) {
+        showHistoryImage(history.undo());
+    }
+}
+
+void im::on_action_Redo_triggered()
+{
+    if (history.canRedo()) {
+        showHistoryImage(history.redo());
+    }
+}
+
+void im::on_action_History_Budget_triggered()
+{
+    bool ok;
+    int budget = QInputDialog::getInt(this, tr("History"), tr("Memory for undo (MB):"),
+                                      static_cast<int>(history.budget() >> 20), 0, 1 << 20, 64, &ok);
+    if (ok) {
+        history.setBudget(static_cast<std::size_t>(budget) << 20);
+        updateHistoryActions();
+    }
+}
+
+void im::recordTrace(bool checked)
+{
+    if (checked) {
+        QString path = QFileDialog::getSaveFileName(this, tr("Record trace"), QDir::homePath(), traceFormat);
+        if (path.isEmpty()) {
+            traceAction->setChecked(false);
+            return;
+        }
+
+        traceFileName = path;
+        ipk::startTracing();
+        ipk::setTraceThreadName("main");
+        statusBar()->showMessage(tr("recording a trace to %1").arg(traceFileName));
+    } else if (ipk::isTracing()) {
+        if (ipk::stopTracing(traceFileName)) {
+            statusBar()->showMessage(tr("trace written to %1").arg(traceFileName));
+        } else {
+            QMessageBox::critical(this, tr("Error"), tr("Unable to write %1").arg(traceFileName));
+        }
+    }
+}
+
+void im::setDoublePrecision(bool checked)
+{
+    ipk::setFftPrecision(checked ? ipk::FftDouble : ipk::FftFloat);
+    statusBar()->showMessage(checked ? tr("frequency filters in double precision")
+                                     : tr("frequency filters in single precision"));
+}
+
+void im::runKernel(const QString &name, const std::function<ipk::Image()> &kernel, const QString &steps)
+{
+    ipk::Image img = inputImage();
+    const ipk::ImageView input = roiView(img);
+    ipk::OperationTimer timer(name.toStdString(), static_cast<std::uint64_t>(input.width())*input.height());
+
+    try {
+        ipk::Image result;
+        {
+            ipk::ScopedTimer kernelTimer("kernel");
+            result = kernel();
+        }
+        showResult(result, steps);
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, tr("Error!"), QString::fromLocal8Bit(e.what()));
+        return;
+    }
+
+    performancePanel->addProfile(timer.finish());
+}
+
+ipk::Image im::readOperand(const QString &fileName)
+{
+    ipk::Image img = readImage(fileName);
+
+    if (img.isNull()) {
+        throw std::invalid_argument(tr("Unable to read %1").arg(fileName).toStdString());
+    }
+
+    return img;
+}
+
+void im::on_action_Adjust_HSV_triggered()
+{
+    dialogAdjustHsv = new DialogAdjustHsv;
+    dialogAdjustHsv->setModal(true);
+    dialogAdjustHsv->show();
+
+    connect(dialogAdjustHsv, SIGNAL(sendHsvData(int, float, float)), this, SLOT(adjustHsv(int, float, float)));
+    connect(dialogAdjustHsv, SIGNAL(previewHsvData(int, float, float)), this, SLOT(previewHsv(int, float, float)));
+    startPreview(dialogAdjustHsv);
+}
+
+void im::on_action_Grayscale_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    } else if (!img.isRGB()) {
+        // for grayscale image, do nothing
+        QMessageBox::critical(this, tr("Error!"), tr("Not an RGB image!"));
+        return;
+    }
+
+    QStringList items;
+    items << tr("Default: (11*R + 16*G + 5*B)/32")
+          << tr("ITU-R BT.601: 0.299*R + 0.587*G + 0.114*B")
+          << tr("ITU-R BT.709: 0.2126*R + 0.7152*G + 0.0722*B");
+    bool ok;
+    QString item = QInputDialog::getItem(this, tr("Grayscale"), tr("RGB weights:"), items, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    // convert RGB to gray scale in a single pass
+    ipk::GrayWeights weights = static_cast<ipk::GrayWeights>(items.indexOf(item));
+    runKernel("grayscale", [&]() {
+        const ipk::ImageView input = roiView(img);
+        ipk::Image gray = ipk::toGrayscale(input, weights);
+        if (gray.width() == img.width() && gray.height() == img.height()) {
+            return gray;
+        }
+        // a region of interest keeps the image RGB, its gray levels go to every channel
+        return mergeRoi(img, ipk::conformTo(gray, input));
+    }, stepText("grayscale", QList<double>() << weights));
+}
+
+void im::on_action_Linear_Transformation_triggered()
+{
+    dialogLinearTransform = new DialogLinearTransform;
+    dialogLinearTransform->setModal(true);
+    dialogLinearTransform->show();
+
+    connect(dialogLinearTransform, SIGNAL(sendData(double,double)), this, SLOT(linearTransformation(double,double)));
+    connect(dialogLinearTransform, SIGNAL(previewData(double,double)), this, SLOT(previewLinearTransformation(double,double)));
+    startPreview(dialogLinearTransform);
+}
+
+void im::on_action_Histogram_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        return;
+    }
+
+    // get histogam, from the input in memory, the file might not be one CImg reads
+    const std::vector<std::uint64_t> bins = ipk::histogram(img);
+    CImg<float> hist(static_cast<unsigned int>(bins.size()));
+    for (std::size_t i = 0; i < bins.size(); ++i) {
+        hist[i] = static_cast<float>(bins[i]);
+    }
+    // set title
+    QString title = "Histogram of " + fileName;
+    // create an object to show window
+    CImgDisplay display(800, 600, title.toStdString().data());
+    // show histogram
+    hist.display_graph(display, 3);
+}
+
+void im::on_action_Histogram_Equalization_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not a grayscale image."));
+        return;
+    }
+
+    runKernel("histogram-equalization", [&]() { return ipk::histogramEqualization(img); });
+}
+
+void im::on_action_Histogram_Specification_triggered()
+{
+    ipk::Image img = inputImage();
+    // for non-grayscale image, do nothing, just return
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not a grayscale image."));
+        return;
+    }
+    // open reference file
+    QString refPath = QFileDialog::getOpenFileName(
+                this, tr("Choose reference image file"), QDir::homePath(), imageFormat);
+
+    if (refPath.isEmpty()) {
+        return;
+    }
+
+    ipk::Image ref = readImage(refPath);
+
+    if (ref.isNull()) {
+        QMessageBox::critical(this, tr("Error"), tr("Unable to read reference image!"));
+        return;
+    }
+    // refernce image shall be grayscale too
+    if (!ref.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not a grayscale image."));
+        return;
+    }
+
+    runKernel("histogram-specification", [&]() { return ipk::histogramSpecification(img, ref); });
+}
+
+void im::on_action_Piecewise_Linear_Transformation_triggered()
+{
+    dlgPiecewiseLinearTranformation = new DialogPiecewiseLinearTransformation;
+    dlgPiecewiseLinearTranformation->setModal(true);
+    dlgPiecewiseLinearTranformation->show();
+
+    connect(dlgPiecewiseLinearTranformation, SIGNAL(sendData(double, double, double, double)), this, SLOT(piecewiseLinearTransformation(double, double, double, double)));
+}
+
+void im::on_action_Average_Filter_triggered()
+{
+    dlgAverageFilter = new DialogAvarageFilter;
+    dlgAverageFilter->setModal(true);
+    dlgAverageFilter->show();
+
+    connect(dlgAverageFilter, SIGNAL(sendData(int)), this, SLOT(averageFilter(int)));
+}
+
+void im::on_action_Laplacian_Filter_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("laplacian", [&]() { return mergeRoi(img, ipk::laplacianFilter(roiView(img))); }, stepText("laplacian"));
+}
+
+void im::on_action_Median_Filter_triggered()
+{
+    dlgMedianFilter = new DialogMedianFilter;
+    dlgMedianFilter->setModal(true);
+    dlgMedianFilter->show();
+
+    connect(dlgMedianFilter, SIGNAL(sendData(int)), this, SLOT(medianFilter(int)));
+}
+
+void im::on_action_Maximum_Filter_triggered()
+{
+    dlgMaximumFilter = new DialogMaximumFilter;
+    dlgMaximumFilter->setModal(true);;
+    dlgMaximumFilter->show();
+
+    connect(dlgMaximumFilter, SIGNAL(sendData(int)), this, SLOT(maximumFilter(int)));
+}
+
+void im::on_action_Minimum_Filter_triggered()
+{
+    dlgMinimumFilter = new DialogMinimumFilter;
+    dlgMinimumFilter->setModal(true);
+    dlgMinimumFilter->show();
+
+    connect(dlgMinimumFilter, SIGNAL(sendData(int)), this, SLOT(minimumFilter(int)));
+
+}
+
+void im::on_action_Custom_Filter_triggered()
+{
+    dlgCustomFilter = new DialogCustomFilter;
+    dlgCustomFilter->setModal(true);
+    dlgCustomFilter->show();
+
+    connect(dlgCustomFilter, SIGNAL(sendData(int,int,int,int,int,int,int,int,int)),
+            this, SLOT(customFilter(int,int,int,int,int,int,int,int,int)));
+}
+
+void im::on_action_Pseudocolor_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("pseudocolor", [&]() { return ipk::pseudocolor(img); });
+}
+
+void im::on_action_Save_triggered()
+{
+    if (!saveFileName.isEmpty()) {
+        // if saveFileName is not empty
+        // just save output image to saveFileName
+        ipk::saveImage(outItem->image(), saveFileName);
+    } else {
+        // else call save as function
+        on_action_Save_As_triggered();
+    }
+}
+
+// about Qt
+// just call QApplication::aboutQt()
+// to show some information
+void im::on_action_About_Qt_triggered()
+{
+    QApplication::aboutQt();
+}
+
+// about dialog
+void im::on_action_About_ImageProcessingKit_triggered()
+{
+    QMessageBox::about(this, tr("About - ImageProcessingKit"), tr("<H1>ImageProcessingKit</H1> Power by Qt."));
+}
+
+void im::on_action_Addition_triggered()
+{
+    QStringList tmpFiles = QFileDialog::getOpenFileNames(this, tr("Open File(s)"), QDir::homePath(), imageFormat);
+
+    if (tmpFiles.isEmpty()) {
+        return;
+    }
+
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("addition", [&]() {
+        for (int i = 0; i < tmpFiles.count(); ++i) {
+            // resize image before operation
+            img = ipk::addition(img, ipk::conformTo(readOperand(tmpFiles.at(i)), img));
+        }
+        return img;
+    });
+}
+
+void im::on_action_Subtraction_triggered()
+{
+    QString tmpFile = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::homePath(), imageFormat);
+
+    if (tmpFile.isEmpty()) {
+        return;
+    }
+
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    // resize image before operation
+    runKernel("subtraction", [&]() { return ipk::subtraction(img, ipk::conformTo(readOperand(tmpFile), img)); });
+}
+
+void im::on_action_Multiplication_triggered()
+{
+    QString tmpFile = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::homePath(), imageFormat);
+
+    if (tmpFile.isEmpty()) {
+        return;
+    }
+
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    // resize image before operation
+    runKernel("multiplication", [&]() { return ipk::multiplication(img, ipk::conformTo(readOperand(tmpFile), img)); });
+}
+
+void im::on_action_Division_triggered()
+{
+    QString tmpFile = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::homePath(), imageFormat);
+
+    if (tmpFile.isEmpty()) {
+        return;
+    }
+
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    // resize image before operation
+    runKernel("division", [&]() { return ipk::division(img, ipk::conformTo(readOperand(tmpFile), img)); });
+}
+
+void im::on_action_Negative_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("negative", [&]() { return mergeRoi(img, ipk::negative(roiView(img))); }, stepText("negative"));
+}
+
+void im::on_action_XOR_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (!ipk::isBinary(img)) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not binary image"));
+        return;
+    }
+
+    QString tmpFile = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::homePath(), imageFormat);
+
+    if (tmpFile.isEmpty()) {
+        return;
+    }
+
+    ipk::Image tmpImg = readImage(tmpFile);
+
+    if (!ipk::isBinary(tmpImg)) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not binary image"));
+        return;
+    }
+
+    runKernel("xor", [&]() { return ipk::bitwiseXor(img, ipk::conformTo(tmpImg, img)); });
+}
+
+void im::on_action_AND_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (!ipk::isBinary(img)) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not binary image"));
+        return;
+    }
+
+    QString tmpFile = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::homePath(), imageFormat);
+
+    if (tmpFile.isEmpty()) {
+        return;
+    }
+
+    ipk::Image tmpImg = readImage(tmpFile);
+
+    if (!ipk::isBinary(tmpImg)) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not binary image"));
+        return;
+    }
+
+    runKernel("and", [&]() { return ipk::bitwiseAnd(img, ipk::conformTo(tmpImg, img)); });
+}
+
+void im::on_action_OR_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (!ipk::isBinary(img)) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not binary image"));
+        return;
+    }
+
+    QString tmpFile = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::homePath(), imageFormat);
+
+    if (tmpFile.isEmpty()) {
+        return;
+    }
+
+    ipk::Image tmpImg = readImage(tmpFile);
+
+    if (!ipk::isBinary(tmpImg)) {
+        QMessageBox::critical(this, tr("Error!"), tr("Not binary image"));
+        return;
+    }
+
+    runKernel("or", [&]() { return ipk::bitwiseOr(img, ipk::conformTo(tmpImg, img)); });
+}
+
+void im::on_action_FFT_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("fft", [&]() { return ipk::spectrum(img); }, stepText("spectrum"));
+}
+
+void im::on_action_IFFT_triggered()
+{
+    dlgIFFT = new DialogIFFT;
+
+    dlgIFFT->setModal(true);
+    dlgIFFT->show();
+    connect(dlgIFFT, SIGNAL(sendData(int)), this, SLOT(ifft(int)));
+}
+
+void im::on_action_Resize_triggered()
+{
+    dlgResize = new DialogResize;
+
+    dlgResize->setModal(true);
+    dlgResize->show();
+    connect(dlgResize, SIGNAL(sendData(double, double, int)), this, SLOT(resize(double, double, int)));
+}
+
+// mirror and flip are just views, the only copy is the result itself
+void im::on_action_Mirror_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("mirror", [&]() { return mergeRoi(img, roiView(img).mirrored().toImage()); }, stepText("mirror"));
+}
+
+void im::on_action_Flip_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    runKernel("flip", [&]() { return mergeRoi(img, roiView(img).flipped().toImage()); }, stepText("flip"));
+}
+
+void im::on_action_Rotate_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    bool ok;
+    double degree = QInputDialog::getDouble(this, tr("Rotate"), tr("Angle (degree, counterclockwise):"),
+                                            0.0, -360.0, 360.0, 2, &ok);
+    if (!ok) {
+        return;
+    }
+
+    runKernel("rotate", [&]() { return ipk::rotate(img, degree, ipk::WarpBilinear); },
+              stepText("rotate", QList<double>() << degree << ipk::WarpBilinear));
+}
+
+// the matrix maps input coordinates to output coordinates, row by row,
+// 6 values for an affine warp, 9 for a perspective one
+void im::on_action_Warp_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    bool ok;
+    QString text = QInputDialog::getText(this, tr("Warp"), tr("Matrix (a b c d e f [g h i]):"),
+                                         QLineEdit::Normal, "1 0 0 0 1 0", &ok);
+    if (!ok) {
+        return;
+    }
+
+    QStringList items = text.split(QRegExp("[\\s,;]+"), QString::SkipEmptyParts);
+    double m[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    bool valid = items.size() == 6 || items.size() == 9;
+    for (int i = 0; valid && i < items.size(); ++i) {
+        m[i] = items[i].toDouble(&valid);
+    }
+    if (!valid) {
+        QMessageBox::critical(this, tr("Error"), tr("6 or 9 numbers expected."));
+        return;
+    }
+
+    ipk::Transform transform(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8]);
+    runKernel("warp", [&]() {
+        try {
+            return ipk::warp(img, transform, img.width(), img.height(), ipk::WarpBilinear);
+        } catch (const std::invalid_argument &) {
+            throw std::invalid_argument(tr("The matrix is not invertible.").toStdString());
+        }
+    });
+}
+
+void im::on_action_Inverse_Filter_triggered()
+{
+    dlgInverseFilter = new DialogInverseFilter;
+
+    dlgInverseFilter->setModal(true);
+    dlgInverseFilter->show();
+
+    connect(dlgInverseFilter,
+            SIGNAL(sendData(int, int, double, int, int)),
+            this,
+            SLOT(invertFilter(int, int, double, int, int)));
+}
+
+void im::on_action_Manual_Threshold_triggered()
+{
+    dlgManualThreshold = new DialogManualThreshold;
+    dlgManualThreshold->setModal(true);
+    dlgManualThreshold->show();
+    connect(dlgManualThreshold, SIGNAL(sendData(int)), this, SLOT(threshold(int)));
+    connect(dlgManualThreshold, SIGNAL(previewData(int)), this, SLOT(previewThreshold(int)));
+    startPreview(dlgManualThreshold);
+}
+
+// see http://blog.csdn.net/dcrmg/article/details/52216622 for details
+void im::on_action_Ostu_method_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    if (!img.isGrayscale()) {
+        QMessageBox::critical(this, tr("Error"), tr("Non-grayscale image."));
+        return;
+    }
+
+    // threshold maximizing the between class variance
+    // of the region of interest, if there is one
+    int threshold = ipk::otsuThreshold(roiView(img));
+    runKernel("otsu", [&]() { return mergeRoi(img, ipk::threshold(roiView(img), threshold)); }, stepText("otsu"));
+}
+
+void im::on_action_Region_Growth_triggered()
+{
+    dlgRegionGrowth = new DialogRegionGrowth;
+    dlgRegionGrowth->setModal(false);
+    dlgRegionGrowth->show();
+
+    connect(inScene,
+            SIGNAL(seedSetted(QPoint)),
+            dlgRegionGrowth,
+            SLOT(setSeedCoord(QPoint)));
+    connect(dlgRegionGrowth,
+            SIGNAL(sendData(QPoint,int)),
+            this,
+            SLOT(regionGrowth(QPoint,int)));
+
+//    CImg<int> img(fileName.toStdString().data());
+//    CImg<int> result(img.width(), img.height(), img.depth(), img.spectrum(), 255);
+//    int T = 10;
+//    int x, y;
+//    QStack<QPoint> seed;
+//    QPoint currentSeed;
+//    seed.push(QPoint(90, 90));
+//    result(90, 90) = 0;
+
+//    while(!seed.isEmpty()) {
+//        currentSeed = seed.pop();
+//        x = currentSeed.x();
+//        y = currentSeed.y();
+//        for (int i = -1; i < 2; ++i) {
+//            for (int j = -1; j < 2; ++j) {
+//                if (isInsideImage(QPoint(x + i, y + j), img)) {
+//                    if (result(x + i, y + j) != 0) {
+//                        if (abs(img(x + i, y + j) - img(x, y)) < T) {
+//                            seed.push(QPoint(x + i, y + j));
+//                            result(x + i, y + j) = 0;
+//                        }
+//                    }
+//                }
+//            }
+//        }
+//    }
+
+//    //qDebug() << img(100, 100) << endl;
+//    //qDebug() << img(101, 100) << endl;
+
+//    result.save("tmp.png");
+//    updateOutScene("tmp.png");
+}
+
+void im::on_action_Erode_triggered()
+{
+    dlgErode = new DialogErode;
+
+    dlgErode->setModal(true);;
+    dlgErode->show();
+
+    connect(dlgErode,
+            SIGNAL(sendData(unsigned char[3][3])),
+            this,
+            SLOT(erode(unsigned char[3][3])));
+}
+
+void im::on_action_Dilate_triggered()
+{
+    dlgDilate = new DialogDilate;
+
+    dlgDilate->setModal(true);
+    dlgDilate->show();
+
+    connect(dlgDilate,
+            SIGNAL(sendData(unsigned char[3][3])),
+            this,
+            SLOT(dilate(unsigned char[3][3])));
+}
+
+void im::on_action_Opening_triggered()
+{
+    dlgOpening = new DialogOpening;
+
+    dlgOpening->setModal(true);
+    dlgOpening->show();
+
+    connect(dlgOpening,
+            SIGNAL(sendData(unsigned char[3][3])),
+            this,
+            SLOT(opening(unsigned char[3][3])));
+}
+
+void im::on_action_Closing_triggered()
+{
+    dlgClosing = new DialogClosing;
+
+    dlgClosing->setModal(true);
+    dlgClosing->show();
+
+    connect(dlgClosing,
+            SIGNAL(sendData(unsigned char[3][3])),
+            this,
+            SLOT(closing(unsigned char[3][3])));
+}
+
+void im::on_action_Ideal_High_Pass_Filter_triggered()
+{
+    dlgIdealHighPassFilter = new DialogIdealHighPassFilter;
+
+    dlgIdealHighPassFilter->setModal(true);
+    dlgIdealHighPassFilter->show();
+
+    connect(dlgIdealHighPassFilter,
+            SIGNAL(sendData(int)),
+            this,
+            SLOT(idealHighPassFilter(int)));
+}
+
+void im::on_action_Ideal_Low_Pass_Filter_triggered()
+{
+    dlgIdealLowPassFilter = new DialogIdealLowPassFilter;
+
+    dlgIdealLowPassFilter->setModal(true);
+    dlgIdealLowPassFilter->show();
+
+    connect(dlgIdealLowPassFilter,
+            SIGNAL(sendData(int)),
+            this,
+            SLOT(idealLowPassFilter(int)));
+}
+
+void im::on_action_Butterworth_Low_Pass_Filter_triggered()
+{
+    dlgButterworthLowPassFilter = new DialogButterworthLowPassFilter;
+
+    dlgButterworthLowPassFilter->setModal(true);
+    dlgButterworthLowPassFilter->show();
+
+    connect(dlgButterworthLowPassFilter,
+            SIGNAL(sendData(int, int)),
+            this,
+            SLOT(butterworthLowPassFilter(int, int)));
+    connect(dlgButterworthLowPassFilter,
+            SIGNAL(previewData(int, int)),
+            this,
+            SLOT(previewButterworthLowPassFilter(int, int)));
+    startPreview(dlgButterworthLowPassFilter);
+}
+
+void im::on_action_Butterworth_High_Pass_Filter_triggered()
+{
+    dlgButterworthHighPassFilter = new DialogButterworthHighPassFilter;
+
+    dlgButterworthHighPassFilter->setModal(true);;
+    dlgButterworthHighPassFilter->show();
+
+    connect(dlgButterworthHighPassFilter,
+            SIGNAL(sendData(int, int)),
+            this,
+            SLOT(butterworthHighPassFilter(int, int)));
+}
+
+void im::on_action_Homomorphic_Filter_triggered()
+{
+    dlgHomomorphicFilter = new DialogHomomorphicFilter;
+
+    dlgHomomorphicFilter->setModal(true);
+    dlgHomomorphicFilter->show();
+
+    connect(dlgHomomorphicFilter,
+            SIGNAL(sendData(double, double, double, int)),
+            this,
+            SLOT(homomorphicFilter(double, double, double, int)));
+}
+
+void im::on_action_Motion_Blur_triggered()
+{
+    dlgMotionBlur = new DialogMotionBlur;
+
+    dlgMotionBlur->setModal(true);
+    dlgMotionBlur->show();
+
+    connect(dlgMotionBlur, SIGNAL(sendData(int, int)), this, SLOT(motionBlur(int, int)));
+}
+
+void im::on_action_Gaussian_Noise_triggered()
+{
+    dlgGaussianNoise = new DialogGaussianNoise;
+
+    dlgGaussianNoise->setModal(true);
+    dlgGaussianNoise->show();
+
+    connect(dlgGaussianNoise, SIGNAL(sendData(double)), this, SLOT(gaussianNoise(double)));
+}
+
+void im::on_action_Atmospheric_Circulation_Blur_triggered()
+{
+    dlgAtmosphericCirculation = new DialogAtmosphericCirculation;
+
+    dlgAtmosphericCirculation->setModal(true);
+    dlgAtmosphericCirculation->show();
+
+    connect(dlgAtmosphericCirculation,
+            SIGNAL(sendData(double)),
+            this,
+            SLOT(atmosphericCirculationBlur(double)));
+}
+
+void im::on_action_Wiener_Filter_triggered()
+{
+    dlgWienerFilter = new DialogWienerFilter;
+
+    dlgWienerFilter->setModal(true);
+    dlgWienerFilter->show();
+    connect(dlgWienerFilter,
+            SIGNAL(sendData(int, double, int, int, double)),
+            this,
+            SLOT(wienerFilter(int, double, int, int, double)));
+}
+
+
+ipk::Pipeline im::recordedPipeline() const
+{
+    ipk::Pipeline result = pipeline;
+    result.append(ipk::Pipeline::fromString(pendingSteps.toStdString()));
+
+    return result;
+}
+
+void im::on_action_Save_Pipeline_triggered()
+{
+    ipk::Pipeline steps = recordedPipeline();
+
+    if (steps.isEmpty()) {
+        QMessageBox::information(this, tr("Save Pipeline"), tr("No operation is recorded yet."));
+        return;
+    }
+
+    QString path = QFileDialog::getSaveFileName(this, tr("Save pipeline"), QDir::homePath(), pipelineFormat);
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)
+            || file.write(steps.toString().c_str()) < 0) {
+        QMessageBox::critical(this, tr("Error"), tr("Unable to save pipeline!"));
+    }
+}
+
+void im::on_action_Run_Pipeline_triggered()
+{
+    ipk::Image img = inputImage();
+
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error!"), tr("Unfortunately, something is wrong."));
+        return;
+    }
+
+    QString path = QFileDialog::getOpenFileName(this, tr("Run pipeline"), QDir::homePath(), pipelineFormat);
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QMessageBox::critical(this, tr("Error"), tr("Unable to read pipeline!"));
+        return;
+    }
+
+    ipk::Pipeline steps;
+    try {
+        steps = ipk::Pipeline::fromString(file.readAll().toStdString());
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, tr("Error!"), QString::fromLocal8Bit(e.what()));
+        return;
+    }
+
+    runKernel("pipeline", [&]() { return mergeRoi(img, steps.run(roiView(img))); },
+              QString::fromStdString(steps.toString()));
+}
+
+void im::on_action_Clear_Pipeline_triggered()
+{
+    startPipeline(fileName);
+    pipelineCache.clear();
+    updatePipelineDock();
+}
+
+void im::updatePipelineDock(const std::vector<bool> &reused)
+{
+    const std::vector<ipk::OperationStep> &steps = recordedPipeline().steps();
+
+    ui->listWidget_Pipeline->clear();
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        QListWidgetItem *item = new QListWidgetItem(ui->listWidget_Pipeline);
+        item->setText(QString("%1. %2").arg(i + 1).arg(QString::fromStdString(steps[i].toString())));
+        // reused steps are grayed out, they took no time
+        if (i < reused.size() && reused[i]) {
+            item->setText(item->text() + tr(" (reused)"));
+            item->setForeground(palette().brush(QPalette::Disabled, QPalette::Text));
+        }
+    }
+}
+
+// change a step, and run the pipeline again from its first image
+void im::on_listWidget_Pipeline_itemDoubleClicked(QListWidgetItem *item)
+{
+    ipk::Pipeline steps = recordedPipeline();
+    const int index = ui->listWidget_Pipeline->row(item);
+
+    if (index < 0 || index >= static_cast<int>(steps.steps().size())) {
+        return;
+    }
+    if (pipelineSource.isEmpty()) {
+        QMessageBox::critical(this, tr("Error"), tr("The first image of the pipeline is gone."));
+        return;
+    }
+
+    bool ok;
+    QString text = QInputDialog::getText(this, tr("Pipeline"), tr("Step %1:").arg(index + 1), QLineEdit::Normal,
+                                         QString::fromStdString(steps.steps()[index].toString()), &ok);
+    if (!ok) {
+        return;
+    }
+
+    ipk::OperationTimer timer("pipeline");
+    ipk::Image img = readImage(pipelineSource);
+    if (img.isNull()) {
+        QMessageBox::critical(this, tr("Error"), tr("Unable to read %1").arg(pipelineSource));
+        return;
+    }
+    timer.setPixels(static_cast<std::uint64_t>(img.width())*img.height());
+
+    try {
+        steps.replace(index, ipk::parseOperation(text.trimmed().toStdString()));
+
+        // only the steps from the one changed on are done again
+        std::vector<bool> reused;
+        ipk::Image result;
+        {
+            ipk::ScopedTimer kernelTimer("kernel");
+            result = pipelineCache.run(steps, img, &reused);
+        }
+
+        pipeline.clear();
+        showInput(pipelineSource);
+        // the first image comes back as the input, after what was there
+        history.push(img);
+        inputId = history.currentId();
+        showResult(result, QString::fromStdString(steps.toString()));
+        updatePipelineDock(reused);
+
+        const int count = static_cast<int>(std::count(reused.begin(), reused.end(), true));
+        statusBar()->showMessage(tr("%1 of %2 steps reused, %3 MB cached")
+                                 .arg(count).arg(reused.size())
+                                 .arg(pipelineCache.memoryUsage() >> 20));
+        performancePanel->addProfile(timer.finish());
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, tr("Error!"), QString::fromLocal8Bit(e.what()));
+    }
+}
+
+// previews run on a proxy of the whole input image,
+// the region of interest only applies to the full job
+void im::startPreview(QDialog *dialog)
+{
+    // the proxy is a level of the pyramid made when the input was opened
+    ipk::Image img = inItem->image();
+
+    if (img.isNull()) {
+        return;
+    }
+
+    livePreview->setSource(inItem->pyramid(), ui->graphicsView_out->viewport()->size());
+    previewSize = QSize(img.width(), img.height());
+    connect(dialog, SIGNAL(finished(int)), this, SLOT(stopPreview()));
+}
+
+void im::stopPreview()
+{
+    livePreview->cancel();
+
+    // the result comes back
+    previewItem->hide();
+    previewItem->setPixmap(QPixmap());
+    outItem->show();
+    outScene->setSceneRect(outItem->boundingRect());
+}
+
+void im::showPreview(const QImage &preview)
+{
+    ipk::TraceScope trace("preview pixmap", "display");
+    previewItem->setPixmap(QPixmap::fromImage(preview));
+    // the proxy covers the whole image
+    previewItem->setScale(static_cast<double>(previewSize.width())/preview.width());
+    previewItem->show();
+    outItem->hide();
+    outScene->setSceneRect(0, 0, previewSize.width(), previewSize.height());
+}
+
+void im::previewHsv(const int &h, const float &s, const float &v)
+{
+    livePreview->request([=](const ipk::Image &proxy, int) {
+        return ipk::adjustHsv(proxy, h, s, v);
+    });
+}
+
+void im::previewLinearTransformation(const double &k, const double &b)
+{
+    livePreview->request([=](const ipk::Image &proxy, int) {
+        return ipk::linearTransformation(proxy, k, b);
+    });
+}
+
+void im::previewThreshold(const int &threshold)
+{
+    livePreview->request([=](const ipk::Image &proxy, int) {
+        return ipk::threshold(proxy, threshold);
+    });
+}
+
+void im::previewButterworthLowPassFilter(const int &Order, const int &D0)
+{
+    // D0 is a distance in the spectrum, which shrinks with the image
+    livePreview->request([=](const ipk::Image &proxy, int shift) {
+        return ipk::butterworthLowPassFilter(proxy, Order, std::max(1, D0 >> shift));
+    });
+}
@@ -40,6 +40,7 @@
 #include "dialogpiecewiselineartransformation.h"
 #include "ui_dialogpiecewiselineartransformation.h"
 #include "qgraphicssceneplus.h"
+#include "tiledimageitem.h"
 #include "dialogadjusthsv.h"
 #include "ui_dialogadjusthsv.h"
 #include "dialoglineartransform.h"
@@ -56,13 +57,23 @@
 #include <QGraphicsPixmapItem>
 #include <QPixmap>
 #include <QMap>
+#include <QHash>
+#include <QPair>
+#include <QListWidgetItem>
 // include qt_windows.h for Windows target only.
 #include <QtGlobal>
 #ifdef Q_OS_WIN
 #include <qt_windows.h>
 #endif
-#include <complex>
-
+#include <functional>
+#include <vector>
+
+#include "history.h"
+#include "livepreview.h"
+#include "performancepanel.h"
+#include "image.h"
+#include "pipeline.h"
+#include "pipelinecache.h"
 #include "CImg.h"
 using namespace cimg_library;
 
@@ -148,6 +159,10 @@ private slots:
 
     void on_action_Flip_triggered();
 
+    void on_action_Rotate_triggered();
+
+    void on_action_Warp_triggered();
+
     void on_action_Inverse_Filter_triggered();
 
     void on_action_Manual_Threshold_triggered();
@@ -182,8 +197,29 @@ private slots:
 
     void on_action_Wiener_Filter_triggered();
 
+    void on_action_Save_Pipeline_triggered();
+
+    void on_action_Run_Pipeline_triggered();
+
+    void on_action_Clear_Pipeline_triggered();
+
+    void on_listWidget_Pipeline_itemDoubleClicked(QListWidgetItem *item);
+
+    void on_action_Undo_triggered();
+
+    void on_action_Redo_triggered();
+
+    void on_action_History_Budget_triggered();
+
+    // start a trace, or stop it and write it
+    void recordTrace(bool checked);
+
+    // precision of the frequency domain kernels, see setFftPrecision()
+    void setDoublePrecision(bool checked);
+
 public slots:
     void showColorValue(const QPointF &position);
+    void setRoi(const QRect &rect);
     void adjustHsv(const int &h, const float &s, const float &v);
     void linearTransformation(const double &k, const double &b);
     void piecewiseLinearTransformation(const double &r1, const double &s1, const double &r2, const double &s2);
@@ -217,32 +253,93 @@ public slots:
                       const int &angle,
                       const double &k);
     void ifft(const int &ifftType);
+    // live previews while the dialogs are open
+    void previewHsv(const int &h, const float &s, const float &v);
+    void previewLinearTransformation(const double &k, const double &b);
+    void previewThreshold(const int &threshold);
+    void previewButterworthLowPassFilter(const int &Order, const int &D0);
+    void showPreview(const QImage &preview);
+    void stopPreview();
 
 private:
     Ui::im *ui;
     QGraphicsScenePlus *inScene, *outScene;
-    QPixmap *inPixmap, *outPixmap;
-    QGraphicsPixmapItem *inPixmapItem, *outPixmapItem;
+    // the input and the result, drawn tile by tile
+    TiledImageItem *inItem, *outItem;
+    // the preview, on top of the result while a dialog is open
+    QGraphicsPixmapItem *previewItem;
     DialogAdjustHsv *dialogAdjustHsv;
     DialogLinearTransform *dialogLinearTransform;
     QString fileName;
     QString saveFileName;
     // result file name used for update out scene
     QString resultFileName;
+    // copy of the result, when a pipeline starts from it
+    QString sourceFileName;
     void setFileName(const QString &fileName);
     void setSaveFileName(const QString &saveFileName);
-    void updateOutScene(const QString &fileName);
-    inline int rgbToGray(const int &r, const int &g, const int &b);
-    // QMap<int, int> getHistogramEqualizationMap(const CImg<int> img, const int nLevel);
-    template<typename T>
-    QMap<T, T> getHistogramEqualizationMap(const CImg<T> &img, const int &nLevel = 256);
-    template<typename T>
-    QMap<T, T> getHistogramSpecificationMap(const CImg<T> &src, const CImg<T> &ref, const int &nLevel = 256);
-    // get position of pixel with minimum value of image img
-    // where img is nLevel * 1 size
-    // nLevel is the gray value range
-    template<typename T>
-    int getMinimumPos(const CImg<T> &img);
+    void updateOutScene(const ipk::Image &img);
+    // show fileName as the input image, without any region of interest
+    void showInput(const QString &fileName);
+    // read image file into a native interleaved buffer
+    // grayscale files give 1 channel, everything else 3 channels (alpha dropped)
+    ipk::Image readImage(const QString &fileName);
+    // the input image as it was opened, it's never read again
+    ipk::Image inputImage() const;
+    // save img to resultFileName and show it
+    // steps are how img was made from the input, in pipeline text,
+    // empty if that can't be replayed
+    void showResult(const ipk::Image &img, const QString &steps = QString());
+    // show the result of kernel, or the message of what it threw
+    // the operation is profiled under name, kernel included
+    void runKernel(const QString &name, const std::function<ipk::Image()> &kernel, const QString &steps = QString());
+    // readImage for the second operand of arithmetic and logic operations
+    // throws std::invalid_argument if the file can't be read
+    ipk::Image readOperand(const QString &fileName);
+    // region of interest of the input image, empty for the whole image
+    QRect roi;
+    // steps from the first opened image up to the input image,
+    // the result is reopened as the input to go on
+    ipk::Pipeline pipeline;
+    // steps from the input image to the result shown
+    QString pendingSteps;
+    // pipeline up to the result shown
+    ipk::Pipeline recordedPipeline() const;
+    // the image the pipeline starts from
+    QString pipelineSource;
+    // forget the steps, and start again from imagePath
+    void startPipeline(const QString &imagePath);
+    // outputs of the steps, so a change to a step
+    // only runs that step and the ones after it again
+    ipk::PipelineCache pipelineCache;
+    // list the steps of recordedPipeline() in the pipeline dock,
+    // the reused ones grayed out
+    void updatePipelineDock(const std::vector<bool> &reused = std::vector<bool>());
+    // results shown since the input was opened, for undo and redo
+    ipk::History history;
+    // history id of the input image
+    quint64 inputId;
+    // for every result in the history, the input it was made from and how
+    QHash<quint64, QPair<quint64, QString> > historyNotes;
+    // show an image of the history as the result
+    void showHistoryImage(const ipk::Image &img);
+    void updateHistoryActions();
+    LivePreview *livePreview;
+    // timing of the last operations
+    PerformancePanel *performancePanel;
+    // checked while tracing
+    QAction *traceAction;
+    // where the trace goes when it stops
+    QString traceFileName;
+    // size of the image previewed, the proxy is scaled up to it
+    QSize previewSize;
+    // previews for dialog until it's closed
+    void startPreview(QDialog *dialog);
+    // the region of interest of img, or all of it
+    ipk::ImageView roiView(const ipk::Image &img) const;
+    // img with its region of interest replaced by result, which was
+    // computed from roiView(img), result itself without a region of interest
+    ipk::Image mergeRoi(const ipk::Image &img, const ipk::Image &result) const;
 
     DialogPiecewiseLinearTransformation *dlgPiecewiseLinearTranformation;
     DialogAvarageFilter *dlgAverageFilter;
@@ -269,57 +366,12 @@ private:
     DialogWienerFilter *dlgWienerFilter;
     DialogIFFT *dlgIFFT;
 
-    CImgList<double> getMotionBlurH(const int &width, const int &height, const int &a, const int &b);
-    CImg<double> getPsfKernel(const int &length, const int &angle);
-    template<typename T>
-    CImgList<double> psfToOtf(const CImg<T> &img, const int &width, const int &height);
-    template <typename T>
-    bool isGrayscale(const CImg<T> &img);
-    template <typename T>
-    bool isRGB(const CImg<T> &img);
-    bool isBinary(const CImg<int> &img);
-    CImg<int> operatorAnd(const CImg<int> &img1, const CImg<int> &img2);
-    CImg<int> operatorOr(const CImg<int> &img1, const CImg<int> &img2);
-    CImg<int> operatorXor(const CImg<int> &img1, const CImg<int> &img2);
-    template <typename T>
-    CImgList<T> getConj(const CImgList<T> &img);
-    template <typename T>
-    CImg<T> fftshift(const CImg<T> &img);
-    template <typename T>
-    CImgList<T> fftshift(const CImgList<T> &img);
-    template <typename T>
-    CImg<T> fft(const CImg<T> &img);
-    // compute division of two CImgList and other overload
-    template<typename T>
-    CImgList<T> div(const CImg<T> &img1_real, const CImg<T> &img1_imag,
-                    const CImg<T> &img2_real, const CImg<T> &img2_imag);
-    template<typename T>
-    CImgList<T> div(const CImgList<T> &img1, const CImgList<T> &img2);
-    template<typename T>
-    CImgList<T> div(const CImgList<T> &img1, const CImgList<T> &img2, const int &D0);
-    // compute multiplication of two CImgList and other overload
-    template<typename T>
-    CImgList<T> mul(const CImg<T> &img1_real, const CImg<T> &img1_imag,
-                    const CImg<T> &img2_real, const CImg<T> &img2_imag);
-    template<typename T>
-    CImgList<T> mul(const CImgList<T> &img1, const CImgList<T> &img2);
-    template<typename T>
-    CImgList<T> add(const CImgList<T> &img1, const std::complex<T> &val);
-    // compute magnitude
-    CImg<double> magnitude(const CImgList<double> &img);
-    // check if point inside img
-    template <typename T>
-    bool isInsideImage(const QPoint &point, const CImg<T> &img);
-    // keep only magnitude part, and set phase to 1
-    template<typename T>
-    CImgList<T> keepMagnitude(const CImgList<T> &img);
-    // keep only phase part, and set magnitude to 1
-    template<typename T>
-    CImgList<T> keepPhase(const CImgList<T> &img);
     // image formats supported by Qt
     // one might get all the image formats supported by Qt by:
     // qDebug() << QImageReader::supportedImageFormats();
-    QString imageFormat = tr("All Images (*.bmp *.cur *.gif *.icns *.ico *.jp2 *.jpeg *.jpg *.mng *.pbm *.pgm *.png *.ppm *.svg *.svgz *.tga *.tif *.tiff *.wbmp *.webp *.xbm *.xpm);;");
+    QString imageFormat = tr("All Images (*.bmp *.cur *.gif *.icns *.ico *.jp2 *.jpeg *.jpg *.mng *.pbm *.pgm *.png *.ppm *.svg *.svgz *.tga *.tif *.tiff *.wbmp *.webp *.xbm *.xpm *.ipk);;");
+    QString pipelineFormat = tr("Pipelines (*.txt);;All Files (*)");
+    QString traceFormat = tr("Chrome traces (*.json);;All Files (*)");
 };
 
 #endif // IM_H
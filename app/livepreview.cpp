@@ -0,0 +1,99 @@
+#include "livepreview.h"
+#include "imageio.h"
+#include "trace.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+// a request is run once the sliders stay put that long
+const int debounceMilliseconds = 80;
+
+ipk::Image runJob(const LivePreview::Job &job, const ipk::Image &proxy, int shift)
+{
+    ipk::setTraceThreadName("preview worker");
+    ipk::TraceScope trace("preview", "worker");
+    try {
+        return job(proxy, shift);
+    } catch (const std::exception &) {
+        // some operations take some images only, the full job tells why
+        return ipk::Image();
+    }
+}
+
+} // namespace
+
+LivePreview::LivePreview(QObject *parent) :
+    QObject(parent),
+    proxyShift(0),
+    cancelled(false)
+{
+    timer.setSingleShot(true);
+    timer.setInterval(debounceMilliseconds);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(start()));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(finish()));
+}
+
+LivePreview::~LivePreview()
+{
+    watcher.waitForFinished();
+}
+
+void LivePreview::setSource(const ipk::ImagePyramid &pyramid, const QSize &size)
+{
+    // halving keeps power of 2 sizes, which the FFT needs,
+    // and frequencies just scale by the same factor
+    proxyShift = 0;
+    proxy = ipk::Image();
+    if (pyramid.isNull()) {
+        return;
+    }
+
+    while (proxyShift + 1 < pyramid.levelCount()) {
+        const ipk::Image level = pyramid.level(proxyShift);
+        if (level.width() <= size.width() && level.height() <= size.height()) {
+            break;
+        }
+        ++proxyShift;
+    }
+    proxy = pyramid.level(proxyShift);
+}
+
+void LivePreview::request(const Job &job)
+{
+    pending = job;
+    cancelled = false;
+    timer.start();
+}
+
+void LivePreview::cancel()
+{
+    pending = Job();
+    cancelled = true;
+    timer.stop();
+}
+
+void LivePreview::start()
+{
+    if (!pending || proxy.isNull() || watcher.isRunning()) {
+        return;
+    }
+
+    Job job = pending;
+    pending = Job();
+    watcher.setFuture(QtConcurrent::run(runJob, job, proxy, proxyShift));
+}
+
+void LivePreview::finish()
+{
+    ipk::Image result = watcher.result();
+
+    // a newer request makes this result stale
+    if (!cancelled && !pending && !result.isNull()) {
+        emit ready(ipk::toQImage(result));
+    }
+    if (!timer.isActive()) {
+        start();
+    }
+}
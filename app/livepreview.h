@@ -0,0 +1,59 @@
+#ifndef LIVEPREVIEW_H
+#define LIVEPREVIEW_H
+
+#include "image.h"
+#include "pyramid.h"
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QTimer>
+#include <functional>
+
+// live preview of an operation while its dialog is open
+//
+// the operation runs on a proxy, the first level of the pyramid of the
+// input image that fits the view, so point operations look just like
+// the full result, and sizes given in pixels are to be shifted right
+// by shift()
+//
+// requests follow the sliders of a dialog, they're debounced and run
+// one at a time in the background, only the last one counts:
+// a running job can't be stopped, but its result is dropped
+// if a newer request is waiting
+class LivePreview : public QObject
+{
+    Q_OBJECT
+
+public:
+    // gets the proxy and the number of times it was halved,
+    // may throw, then there's just no preview
+    typedef std::function<ipk::Image(const ipk::Image &proxy, int shift)> Job;
+
+    explicit LivePreview(QObject *parent = 0);
+    // waits for the running job
+    ~LivePreview();
+
+    void setSource(const ipk::ImagePyramid &pyramid, const QSize &size);
+    int shift() const { return proxyShift; }
+    void request(const Job &job);
+    // drop the waiting request, and the result of the running one
+    void cancel();
+
+signals:
+    void ready(const QImage &preview);
+
+private slots:
+    void start();
+    void finish();
+
+private:
+    ipk::Image proxy;
+    int proxyShift;
+    Job pending;
+    bool cancelled;
+    QTimer timer;
+    QFutureWatcher<ipk::Image> watcher;
+};
+
+#endif // LIVEPREVIEW_H
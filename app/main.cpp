@@ -0,0 +1,35 @@
+#include "im.h"
+#include "batch.h"
+#include "trace.h"
+#include <QApplication>
+#include <QCoreApplication>
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    // IPK_TRACE=file.json records a trace of the whole run, see trace.h
+    const QString traceFile = QString::fromLocal8Bit(qgetenv("IPK_TRACE"));
+    if (!traceFile.isEmpty()) {
+        ipk::startTracing();
+        ipk::setTraceThreadName("main");
+    }
+
+    int code;
+    // --op, --pipeline or --list-ops on the command line runs without any window
+    if (isBatchCommandLine(argc, argv)) {
+        QCoreApplication a(argc, argv);
+        code = runBatch(a.arguments());
+    } else {
+        QApplication a(argc, argv);
+        im w;
+        w.show();
+        code = a.exec();
+    }
+
+    // the window may have stopped it already
+    if (ipk::isTracing() && !ipk::stopTracing(traceFile)) {
+        std::fprintf(stderr, "can't write the trace to %s\n", qPrintable(traceFile));
+    }
+
+    return code;
+}
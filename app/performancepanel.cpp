@@ -0,0 +1,315 @@
+#include "performancepanel.h"
+#include "qcustomplot.h"
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QStringList>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QVBoxLayout>
+#include <algorithm>
+
+namespace {
+
+// time of the operation in no phase at all
+const char *const otherPhase = "other";
+
+double otherMilliseconds(const ipk::OperationProfile &profile)
+{
+    double phases = 0;
+    for (const ipk::PhaseTime &phase : profile.phases) {
+        phases += phase.milliseconds;
+    }
+
+    return std::max(0.0, profile.milliseconds - phases);
+}
+
+double phaseMilliseconds(const ipk::OperationProfile &profile, const QString &name)
+{
+    if (name == otherPhase) {
+        return otherMilliseconds(profile);
+    }
+
+    double total = 0;
+    for (const ipk::PhaseTime &phase : profile.phases) {
+        if (name == phase.name) {
+            total += phase.milliseconds;
+        }
+    }
+
+    return total;
+}
+
+// phases of all the profiles, in the order they first show up, other last
+QStringList phaseNames(const QList<ipk::OperationProfile> &profiles)
+{
+    QStringList names;
+    for (const ipk::OperationProfile &profile : profiles) {
+        for (const ipk::PhaseTime &phase : profile.phases) {
+            if (!names.contains(phase.name)) {
+                names << phase.name;
+            }
+        }
+    }
+    names << otherPhase;
+
+    return names;
+}
+
+const ipk::PhaseTime *findPhase(const ipk::OperationProfile &profile, const QString &name)
+{
+    for (const ipk::PhaseTime &phase : profile.phases) {
+        if (name == phase.name) {
+            return &phase;
+        }
+    }
+
+    return nullptr;
+}
+
+double megabytes(std::uint64_t bytes)
+{
+    return bytes/1048576.0;
+}
+
+double megapixelsPerSecond(const ipk::OperationProfile &profile)
+{
+    return profile.milliseconds > 0 ? profile.pixels/profile.milliseconds/1000 : 0;
+}
+
+QString csvField(const QString &text)
+{
+    if (!text.contains(',') && !text.contains('"') && !text.contains('\n')) {
+        return text;
+    }
+
+    return '"' + QString(text).replace("\"", "\"\"") + '"';
+}
+
+} // namespace
+
+PerformancePanel::PerformancePanel(QWidget *parent) :
+    QDockWidget(tr("Performance"), parent),
+    plot(new QCustomPlot),
+    table(new QTableWidget(0, 7)),
+    maxCount(20)
+{
+    setObjectName("dockWidget_Performance");
+
+    plot->setMinimumHeight(200);
+    plot->yAxis->setLabel(tr("ms"));
+    plot->xAxis->setTickLabelRotation(60);
+    plot->legend->setFont(font());
+
+    table->setHorizontalHeaderLabels(QStringList() << tr("Operation") << tr("ms") << tr("Mpix/s")
+                                     << tr("Allocated MB") << tr("Peak MB") << tr("Peak RSS MB")
+                                     << tr("Phases"));
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->verticalHeader()->hide();
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    QPushButton *csvButton = new QPushButton(tr("Export CSV..."));
+    QPushButton *jsonButton = new QPushButton(tr("Export JSON..."));
+    QPushButton *clearButton = new QPushButton(tr("Clear"));
+    connect(csvButton, SIGNAL(clicked()), this, SLOT(exportCsv()));
+    connect(jsonButton, SIGNAL(clicked()), this, SLOT(exportJson()));
+    connect(clearButton, SIGNAL(clicked()), this, SLOT(clear()));
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    buttons->addWidget(csvButton);
+    buttons->addWidget(jsonButton);
+    buttons->addStretch();
+    buttons->addWidget(clearButton);
+
+    QWidget *contents = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(contents);
+    layout->addWidget(plot, 2);
+    layout->addWidget(table, 1);
+    layout->addLayout(buttons);
+    setWidget(contents);
+
+    updateChart();
+}
+
+void PerformancePanel::setMaxProfiles(int count)
+{
+    maxCount = std::max(1, count);
+    while (profiles.size() > maxCount) {
+        profiles.removeFirst();
+    }
+    updateChart();
+    updateTable();
+}
+
+void PerformancePanel::addProfile(const ipk::OperationProfile &profile)
+{
+    profiles.append(profile);
+    while (profiles.size() > maxCount) {
+        profiles.removeFirst();
+    }
+    updateChart();
+    updateTable();
+}
+
+void PerformancePanel::clear()
+{
+    profiles.clear();
+    updateChart();
+    updateTable();
+}
+
+void PerformancePanel::updateChart()
+{
+    plot->clearPlottables();
+
+    // one bar per operation, oldest on the left
+    QSharedPointer<QCPAxisTickerText> ticker(new QCPAxisTickerText);
+    QVector<double> keys;
+    double highest = 0;
+    for (int i = 0; i < profiles.size(); ++i) {
+        ticker->addTick(i + 1, QString::fromStdString(profiles[i].operation));
+        keys << i + 1;
+        highest = std::max(highest, profiles[i].milliseconds);
+    }
+
+    // one set of bars per phase, stacked
+    const QStringList names = phaseNames(profiles);
+    QCPBars *below = nullptr;
+    for (int k = 0; k < names.size(); ++k) {
+        QVector<double> values;
+        for (const ipk::OperationProfile &profile : profiles) {
+            values << phaseMilliseconds(profile, names[k]);
+        }
+
+        QCPBars *bars = new QCPBars(plot->xAxis, plot->yAxis);
+        bars->setName(names[k]);
+        bars->setStackingGap(0);
+        bars->setPen(Qt::NoPen);
+        // the golden angle keeps neighbours apart, other is gray
+        bars->setBrush(names[k] == otherPhase ? QColor(Qt::lightGray) : QColor::fromHsv((k*137)%360, 150, 220));
+        bars->setData(keys, values, true);
+        if (below) {
+            bars->moveAbove(below);
+        }
+        below = bars;
+    }
+
+    plot->xAxis->setTicker(ticker);
+    plot->xAxis->setRange(0, profiles.size() + 1);
+    plot->yAxis->setRange(0, highest > 0 ? highest*1.1 : 1);
+    plot->legend->setVisible(!profiles.isEmpty());
+    plot->replot();
+}
+
+void PerformancePanel::updateTable()
+{
+    table->setRowCount(profiles.size());
+
+    for (int i = 0; i < profiles.size(); ++i) {
+        const ipk::OperationProfile &profile = profiles[i];
+        QStringList phases;
+        for (const ipk::PhaseTime &phase : profile.phases) {
+            phases << QString("%1 %2 (peak %3 MB, RSS %4 MB)").arg(phase.name).arg(phase.milliseconds, 0, 'f', 1)
+                      .arg(megabytes(phase.peakBytes), 0, 'f', 1).arg(megabytes(phase.peakResident), 0, 'f', 1);
+        }
+
+        const QStringList cells = QStringList() << QString::fromStdString(profile.operation)
+                                                << QString::number(profile.milliseconds, 'f', 1)
+                                                << QString::number(megapixelsPerSecond(profile), 'f', 1)
+                                                << QString::number(megabytes(profile.bytesAllocated), 'f', 1)
+                                                << QString::number(megabytes(profile.peakBytes), 'f', 1)
+                                                << QString::number(megabytes(profile.peakResident), 'f', 1)
+                                                << phases.join(", ");
+        for (int column = 0; column < cells.size(); ++column) {
+            table->setItem(i, column, new QTableWidgetItem(cells[column]));
+        }
+    }
+
+    table->resizeColumnsToContents();
+    table->scrollToBottom();
+}
+
+void PerformancePanel::exportCsv()
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("Export profiles"), QDir::homePath(),
+                                                tr("CSV files (*.csv);;All Files (*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        QMessageBox::critical(this, tr("Error"), tr("Unable to write %1").arg(path));
+        return;
+    }
+
+    // a row per phase, the totals repeated, so it loads as one table
+    QTextStream out(&file);
+    out << "index,operation,phase,phase_ms,phase_peak_bytes,phase_peak_resident_bytes,total_ms,pixels,"
+           "bytes_allocated,peak_bytes,peak_resident_bytes\n";
+    const QStringList names = phaseNames(profiles);
+    for (int i = 0; i < profiles.size(); ++i) {
+        const ipk::OperationProfile &profile = profiles[i];
+        for (const QString &name : names) {
+            const double ms = phaseMilliseconds(profile, name);
+            if (ms <= 0 && name != otherPhase) {
+                continue;
+            }
+            // other has no peaks of its own
+            const ipk::PhaseTime *phase = findPhase(profile, name);
+            out << i << ',' << csvField(QString::fromStdString(profile.operation)) << ',' << name << ','
+                << QString::number(ms, 'f', 3) << ',' << (phase ? phase->peakBytes : 0) << ','
+                << (phase ? phase->peakResident : 0) << ',' << QString::number(profile.milliseconds, 'f', 3) << ','
+                << profile.pixels << ',' << profile.bytesAllocated << ',' << profile.peakBytes << ','
+                << profile.peakResident << '\n';
+        }
+    }
+}
+
+void PerformancePanel::exportJson()
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("Export profiles"), QDir::homePath(),
+                                                tr("JSON files (*.json);;All Files (*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QJsonArray operations;
+    for (const ipk::OperationProfile &profile : profiles) {
+        QJsonArray phases;
+        for (const ipk::PhaseTime &phase : profile.phases) {
+            QJsonObject object;
+            object["name"] = phase.name;
+            object["ms"] = phase.milliseconds;
+            object["peak_bytes"] = static_cast<double>(phase.peakBytes);
+            object["peak_resident_bytes"] = static_cast<double>(phase.peakResident);
+            phases.append(object);
+        }
+
+        QJsonObject object;
+        object["operation"] = QString::fromStdString(profile.operation);
+        object["ms"] = profile.milliseconds;
+        object["other_ms"] = otherMilliseconds(profile);
+        object["pixels"] = static_cast<double>(profile.pixels);
+        object["bytes_allocated"] = static_cast<double>(profile.bytesAllocated);
+        object["peak_bytes"] = static_cast<double>(profile.peakBytes);
+        object["peak_resident_bytes"] = static_cast<double>(profile.peakResident);
+        object["mpix_per_s"] = megapixelsPerSecond(profile);
+        object["phases"] = phases;
+        operations.append(object);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || file.write(QJsonDocument(operations).toJson()) < 0) {
+        QMessageBox::critical(this, tr("Error"), tr("Unable to write %1").arg(path));
+    }
+}
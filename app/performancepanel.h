@@ -0,0 +1,44 @@
+#ifndef PERFORMANCEPANEL_H
+#define PERFORMANCEPANEL_H
+
+#include "profiler.h"
+#include <QDockWidget>
+#include <QList>
+
+class QCustomPlot;
+class QTableWidget;
+
+// where the time of the last operations went, see profiler.h
+// a bar per operation, stacked by phase, and a table with the totals,
+// pixels, throughput, memory allocated and its peaks, per phase too
+// the profiles can be saved as CSV, a row per phase, or JSON
+class PerformancePanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PerformancePanel(QWidget *parent = 0);
+
+    // the oldest profiles go once there are more than count
+    void setMaxProfiles(int count);
+    int maxProfiles() const { return maxCount; }
+
+public slots:
+    void addProfile(const ipk::OperationProfile &profile);
+    void clear();
+
+private slots:
+    void exportCsv();
+    void exportJson();
+
+private:
+    void updateChart();
+    void updateTable();
+
+    QCustomPlot *plot;
+    QTableWidget *table;
+    QList<ipk::OperationProfile> profiles;
+    int maxCount;
+};
+
+#endif // PERFORMANCEPANEL_H
@@ -0,0 +1,98 @@
+#include "qgraphicssceneplus.h"
+#include "QDebug"
+#include <QGraphicsView>
+#include <QPen>
+#include <cmath>
+
+QGraphicsScenePlus::QGraphicsScenePlus(QObject *parent) : QGraphicsScene(parent),
+    roiItem(nullptr), selecting(false)
+{
+    position.setX(0);
+    position.setY(0);
+}
+
+void QGraphicsScenePlus::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
+{
+    position.setX(mouseEvent->scenePos().x());
+    position.setY(mouseEvent->scenePos().y());
+
+    if (selecting && roiItem) {
+        roiItem->setRect(QRectF(roiStart, position).normalized());
+    }
+
+    emit coordChanged(position);
+}
+
+void QGraphicsScenePlus::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent)
+{
+    position.setX(mouseEvent->scenePos().x());
+    position.setY(mouseEvent->scenePos().y());
+
+    if (mouseEvent->button() == Qt::LeftButton && (mouseEvent->modifiers() & Qt::ShiftModifier)) {
+        // start a new region of interest
+        clearRoi();
+        selecting = true;
+        roiStart = position;
+        roiItem = addRect(QRectF(roiStart, roiStart), QPen(Qt::red, 0, Qt::DashLine));
+        roiItem->setZValue(1);
+    }
+
+    emit coordChanged(position);
+}
+
+void QGraphicsScenePlus::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
+{
+    if (!selecting) {
+        return;
+    }
+    selecting = false;
+
+    // whole pixels only, clipped to the scene, that is, to the image
+    QRect rect = QRectF(roiStart, mouseEvent->scenePos()).normalized().toAlignedRect();
+    rect &= sceneRect().toAlignedRect();
+    if (rect.width() < 2 || rect.height() < 2) {
+        // a click, not a drag, drop the selection
+        clearRoi();
+        emit roiSelected(QRect());
+        return;
+    }
+
+    roiItem->setRect(rect);
+    emit roiSelected(rect);
+}
+
+void QGraphicsScenePlus::wheelEvent(QGraphicsSceneWheelEvent *wheelEvent)
+{
+    if (!(wheelEvent->modifiers() & Qt::ControlModifier)) {
+        QGraphicsScene::wheelEvent(wheelEvent);
+        return;
+    }
+
+    // about 1.2 times per notch of 120
+    const double factor = std::pow(1.0015, wheelEvent->delta());
+    for (QGraphicsView *view : views()) {
+        view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+        view->scale(factor, factor);
+    }
+    wheelEvent->accept();
+}
+
+void QGraphicsScenePlus::clearRoi()
+{
+    if (roiItem) {
+        removeItem(roiItem);
+        delete roiItem;
+        roiItem = nullptr;
+    }
+    selecting = false;
+}
+
+void QGraphicsScenePlus::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *mouseEvent)
+{
+    seedPosition.setX(mouseEvent->scenePos().x());
+    seedPosition.setY(mouseEvent->scenePos().y());
+
+    emit seedSetted(seedPosition);
+}
+
+
@@ -4,7 +4,10 @@
 #include <QObject>
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
+#include <QGraphicsSceneWheelEvent>
 #include <QPointF>
+#include <QGraphicsRectItem>
+#include <QRect>
 
 class QGraphicsScenePlus : public QGraphicsScene
 {
@@ -15,15 +18,26 @@ public:
     void mouseMoveEvent(QGraphicsSceneMouseEvent* mouseEvent) override;
     void mousePressEvent(QGraphicsSceneMouseEvent* mouseEvent) override;
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent* mouseEvent) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent* mouseEvent) override;
+    // ctrl + wheel zooms the views around the cursor
+    void wheelEvent(QGraphicsSceneWheelEvent* wheelEvent) override;
+    // remove the region of interest rectangle, call it before clear()
+    void clearRoi();
 
 signals:
     void coordChanged(const QPointF&);
     void seedSetted(const QPoint&);
+    // shift + drag selects a region of interest, an empty rect clears it
+    void roiSelected(const QRect&);
 
 private:
     // we save position of the mouse cursor in QPoint position
     QPointF position;
     QPoint seedPosition;
+    // region of interest, while and after it is dragged
+    QPointF roiStart;
+    QGraphicsRectItem *roiItem;
+    bool selecting;
 };
 
 #endif // QGRAPHICSSCENEPLUS_H
@@ -0,0 +1,164 @@
+#include "tiledimageitem.h"
+#include "imageio.h"
+#include "trace.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int tileSize = 256;
+// 256 MB of pixmaps
+const int cacheKilobytes = 256*1024;
+
+inline quint64 tileKey(int level, int tx, int ty)
+{
+    return (quint64(level) << 48) | (quint64(ty) << 24) | quint64(tx);
+}
+
+} // namespace
+
+TiledImageItem::TiledImageItem(QGraphicsItem *parent) :
+    QGraphicsObject(parent),
+    generation(0),
+    tiles(cacheKilobytes)
+{
+    // paint() only draws the tiles in option->exposedRect
+    setFlag(ItemUsesExtendedStyleOption);
+}
+
+TiledImageItem::~TiledImageItem()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void TiledImageItem::setPyramid(const ipk::ImagePyramid &pyramid)
+{
+    prepareGeometryChange();
+    ++generation;
+    pool.clear();
+    tiles.clear();
+    requested.clear();
+
+    levels = pyramid;
+    source = pyramid.isNull() ? ipk::Image() : pyramid.image();
+
+    update();
+}
+
+QRectF TiledImageItem::boundingRect() const
+{
+    return QRectF(0, 0, source.width(), source.height());
+}
+
+QSize TiledImageItem::levelSize(int level) const
+{
+    const ipk::Image img = levels.level(level);
+    return QSize(img.width(), img.height());
+}
+
+QRectF TiledImageItem::tileRect(int level, int tx, int ty) const
+{
+    const QSize size = levelSize(level);
+    const double sx = static_cast<double>(source.width())/size.width();
+    const double sy = static_cast<double>(source.height())/size.height();
+    const int x0 = tx*tileSize;
+    const int y0 = ty*tileSize;
+    const int x1 = std::min(size.width(), x0 + tileSize);
+    const int y1 = std::min(size.height(), y0 + tileSize);
+
+    return QRectF(x0*sx, y0*sy, (x1 - x0)*sx, (y1 - y0)*sy);
+}
+
+void TiledImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+    if (source.isNull()) {
+        return;
+    }
+
+    // the level with about one pixel per pixel on the screen, or the coarsest
+    const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+    int level = lod >= 1 ? 0 : static_cast<int>(std::floor(std::log2(1/lod)));
+    level = std::min(level, levels.levelCount() - 1);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, lod < 1);
+
+    const QSize size = levelSize(level);
+    const double sx = static_cast<double>(size.width())/source.width();
+    const double sy = static_cast<double>(size.height())/source.height();
+    const QRectF exposed = option->exposedRect & boundingRect();
+    if (exposed.isEmpty()) {
+        return;
+    }
+
+    const int tx0 = static_cast<int>(exposed.left()*sx)/tileSize;
+    const int ty0 = static_cast<int>(exposed.top()*sy)/tileSize;
+    const int tx1 = std::min((size.width() - 1)/tileSize, static_cast<int>(std::ceil(exposed.right()*sx))/tileSize);
+    const int ty1 = std::min((size.height() - 1)/tileSize, static_cast<int>(std::ceil(exposed.bottom()*sy))/tileSize);
+
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            const QRectF target = tileRect(level, tx, ty);
+            if (QPixmap *tile = tiles.object(tileKey(level, tx, ty))) {
+                painter->drawPixmap(target, *tile, QRectF(tile->rect()));
+                continue;
+            }
+
+            requestTile(level, tx, ty);
+
+            // meanwhile, the part of a coarser tile
+            for (int coarser = level + 1; coarser < levels.levelCount(); ++coarser) {
+                const int shift = coarser - level;
+                if (QPixmap *tile = tiles.object(tileKey(coarser, tx >> shift, ty >> shift))) {
+                    painter->save();
+                    painter->setClipRect(target, Qt::IntersectClip);
+                    painter->drawPixmap(tileRect(coarser, tx >> shift, ty >> shift), *tile, QRectF(tile->rect()));
+                    painter->restore();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void TiledImageItem::requestTile(int level, int tx, int ty)
+{
+    const quint64 key = tileKey(level, tx, ty);
+    if (requested.contains(key)) {
+        return;
+    }
+    requested.insert(key);
+
+    const ipk::Image img = levels.level(level);
+    const int current = generation;
+    QtConcurrent::run(&pool, [=]() {
+        ipk::setTraceThreadName("tile worker");
+        ipk::TraceScope trace("tile", "worker");
+        QImage tile = ipk::toQImage(ipk::ImageView(img).cropped(tx*tileSize, ty*tileSize, tileSize, tileSize));
+        QMetaObject::invokeMethod(this, "addTile", Qt::QueuedConnection,
+                                  Q_ARG(quint64, key), Q_ARG(QImage, tile), Q_ARG(int, current));
+    });
+}
+
+void TiledImageItem::addTile(quint64 key, const QImage &tile, int tileGeneration)
+{
+    if (tileGeneration != generation) {
+        return;
+    }
+    requested.remove(key);
+    if (tile.isNull()) {
+        return;
+    }
+
+    ipk::TraceScope trace("tile pixmap", "display");
+    QPixmap *pixmap = new QPixmap(QPixmap::fromImage(tile));
+    const int cost = std::max(1, pixmap->width()*pixmap->height()*pixmap->depth()/8/1024);
+    tiles.insert(key, pixmap, cost);
+
+    const int level = static_cast<int>(key >> 48);
+    const int ty = static_cast<int>((key >> 24) & 0xffffff);
+    const int tx = static_cast<int>(key & 0xffffff);
+    update(tileRect(level, tx, ty));
+}
@@ -0,0 +1,54 @@
+#ifndef TILEDIMAGEITEM_H
+#define TILEDIMAGEITEM_H
+
+#include "pyramid.h"
+#include <QCache>
+#include <QGraphicsObject>
+#include <QImage>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+
+// image item drawn tile by tile, for images too big for a single pixmap
+//
+// tiles are cut from the level of the pyramid that matches the zoom,
+// only the tiles in view are converted to pixmaps, on worker threads,
+// and the most recently used ones are kept in a cache
+// until a tile is ready, the part of a coarser tile at hand is drawn
+class TiledImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    explicit TiledImageItem(QGraphicsItem *parent = 0);
+    // waits for the workers
+    ~TiledImageItem();
+
+    // a null pyramid shows nothing
+    void setPyramid(const ipk::ImagePyramid &pyramid);
+    ipk::ImagePyramid pyramid() const { return levels; }
+    ipk::Image image() const { return source; }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private slots:
+    // from the workers, dropped if the image changed meanwhile
+    void addTile(quint64 key, const QImage &tile, int generation);
+
+private:
+    ipk::ImagePyramid levels;
+    ipk::Image source;
+    int generation;
+    QThreadPool pool;
+    // cost in KB
+    QCache<quint64, QPixmap> tiles;
+    QSet<quint64> requested;
+
+    QSize levelSize(int level) const;
+    // item rectangle covered by a tile
+    QRectF tileRect(int level, int tx, int ty) const;
+    void requestTile(int level, int tx, int ty);
+};
+
+#endif // TILEDIMAGEITEM_H
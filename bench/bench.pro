@@ -0,0 +1,44 @@
+# ipkbench: times the kernels of core on synthetic images, see benchmark.h
+# ipkbench --verify checks them against CImg, see verify.h
+# ipkbench --compare checks them against an earlier run, see compare.h
+# ipkbench --help lists the options
+
+QT       += core gui
+QT       -= widgets
+
+TARGET = ipkbench
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+# same as core, CImg.h is reached through frequency.h
+DEFINES += cimg_display=0
+
+# the kernels, see core/core.pro
+INCLUDEPATH += $$PWD/../core
+DEPENDPATH += $$PWD/../core
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../core/release/ -lipkcore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../core/debug/ -lipkcore
+else:unix: LIBS += -L$$OUT_PWD/../core/ -lipkcore
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/libipkcore.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/libipkcore.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/ipkcore.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/ipkcore.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../core/libipkcore.a
+
+SOURCES += \
+    main.cpp \
+    benchmark.cpp \
+    compare.cpp \
+    verify.cpp
+
+HEADERS += \
+    benchmark.h \
+    compare.h \
+    verify.h
+
+# peak working set, and the resident set of ipkcore
+win32: LIBS += -lpsapi
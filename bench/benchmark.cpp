@@ -0,0 +1,274 @@
+#include "benchmark.h"
+#include "frequency.h"
+#include "operations.h"
+#include "profiler.h"
+#include <QFile>
+#include <QJsonArray>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// registry operations, parameters close to the defaults of the dialogs
+const char *const operationTexts[] = {
+    "grayscale",
+    "hsv:30,1.2,0.9",
+    "linear:1.2,10",
+    "piecewise:64,32,192,224",
+    "average:5",
+    "median:5",
+    "max:5",
+    "min:5",
+    "custom:1,2,1,2,4,2,1,2,1",
+    "laplacian",
+    "negative",
+    "threshold:128",
+    "otsu",
+    "erode",
+    "dilate",
+    "opening",
+    "closing",
+    "mirror",
+    "flip",
+    "scale:0.5,1",
+    "scale:2,2",
+    "scale:0.5,4",
+    "rotate:30,1",
+    "ideal-lowpass:40",
+    "ideal-highpass:40",
+    "butterworth-lowpass:2,40",
+    "butterworth-highpass:2,40",
+    "homomorphic:0.5,2,1,40"
+};
+
+} // namespace
+
+std::vector<BenchCase> benchCases()
+{
+    std::vector<BenchCase> cases;
+
+    for (const char *text : operationTexts) {
+        const ipk::OperationStep step = ipk::parseOperation(text);
+        cases.push_back({ text, [step](const ipk::ImageView &src) { return step.apply(src); } });
+    }
+
+    // kernels of the frequency dialogs, not in the registry, with their defaults
+    cases.push_back({ "spectrum", [](const ipk::ImageView &src) { return ipk::spectrum(src); } });
+    cases.push_back({ "motion-blur:10,30", [](const ipk::ImageView &src) {
+        return ipk::motionBlur(src, 10, 30);
+    } });
+    cases.push_back({ "gaussian-noise:5", [](const ipk::ImageView &src) {
+        return ipk::gaussianNoise(src, 5);
+    } });
+    cases.push_back({ "atmospheric:0.00025", [](const ipk::ImageView &src) {
+        return ipk::atmosphericCirculationBlur(src, 0.00025);
+    } });
+    cases.push_back({ "inverse:30", [](const ipk::ImageView &src) {
+        return ipk::inverseFilter(src, ipk::NoiseNone, 30, 0, 10, 30);
+    } });
+    cases.push_back({ "wiener:gaussian,5,800", [](const ipk::ImageView &src) {
+        return ipk::wienerFilter(src, ipk::NoiseGaussian, 5, 10, 30, 800);
+    } });
+    cases.push_back({ "ifft:complete", [](const ipk::ImageView &src) {
+        return ipk::ifft(src, ipk::IfftComplete);
+    } });
+    cases.push_back({ "ifft:magnitude", [](const ipk::ImageView &src) {
+        return ipk::ifft(src, ipk::IfftMagnitude);
+    } });
+    cases.push_back({ "ifft:phase", [](const ipk::ImageView &src) {
+        return ipk::ifft(src, ipk::IfftPhase);
+    } });
+
+    return cases;
+}
+
+double BenchResult::percentile(double p) const
+{
+    if (milliseconds.empty()) {
+        return 0;
+    }
+
+    const double rank = p/100*(milliseconds.size() - 1);
+    const std::size_t below = static_cast<std::size_t>(rank);
+    const std::size_t above = std::min(below + 1, milliseconds.size() - 1);
+    return milliseconds[below] + (rank - below)*(milliseconds[above] - milliseconds[below]);
+}
+
+double BenchResult::megapixelsPerSecond() const
+{
+    const double ms = median();
+    return ms > 0 ? static_cast<double>(width)*height/ms/1000 : 0;
+}
+
+QJsonObject BenchResult::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["width"] = width;
+    object["height"] = height;
+    object["channels"] = channels;
+    if (!error.isEmpty()) {
+        object["error"] = error;
+        return object;
+    }
+
+    QJsonArray runs;
+    for (double ms : milliseconds) {
+        runs.append(ms);
+    }
+    object["runs_ms"] = runs;
+    object["min_ms"] = percentile(0);
+    object["median_ms"] = median();
+    object["p90_ms"] = percentile(90);
+    object["max_ms"] = percentile(100);
+    object["mpix_per_s"] = megapixelsPerSecond();
+    object["peak_rss_kb"] = static_cast<double>(peakRss);
+    object["peak_bytes"] = static_cast<double>(peakBytes);
+    object["bytes_allocated"] = static_cast<double>(bytesAllocated);
+    QJsonArray phaseArray;
+    for (const BenchPhase &phase : phases) {
+        QJsonObject phaseObject;
+        phaseObject["name"] = phase.name;
+        phaseObject["ms"] = phase.milliseconds;
+        phaseObject["peak_bytes"] = static_cast<double>(phase.peakBytes);
+        phaseObject["peak_rss_kb"] = static_cast<double>(phase.peakResident/1024);
+        phaseArray.append(phaseObject);
+    }
+    object["phases"] = phaseArray;
+    return object;
+}
+
+BenchResult BenchResult::fromJson(const QJsonObject &object)
+{
+    BenchResult result;
+    result.name = object["name"].toString();
+    result.width = object["width"].toInt();
+    result.height = object["height"].toInt();
+    result.channels = object["channels"].toInt();
+    result.error = object["error"].toString();
+    for (const QJsonValue &ms : object["runs_ms"].toArray()) {
+        result.milliseconds.push_back(ms.toDouble());
+    }
+    std::sort(result.milliseconds.begin(), result.milliseconds.end());
+    result.peakRss = static_cast<long>(object["peak_rss_kb"].toDouble(-1));
+    // 0 in files from before it was measured
+    result.peakBytes = static_cast<std::uint64_t>(object["peak_bytes"].toDouble());
+    result.bytesAllocated = static_cast<std::uint64_t>(object["bytes_allocated"].toDouble());
+    for (const QJsonValue &value : object["phases"].toArray()) {
+        const QJsonObject phaseObject = value.toObject();
+        BenchPhase phase;
+        phase.name = phaseObject["name"].toString();
+        phase.milliseconds = phaseObject["ms"].toDouble();
+        phase.peakBytes = static_cast<std::uint64_t>(phaseObject["peak_bytes"].toDouble());
+        phase.peakResident = static_cast<std::uint64_t>(phaseObject["peak_rss_kb"].toDouble())*1024;
+        result.phases.push_back(phase);
+    }
+    return result;
+}
+
+bool runCase(const BenchCase &c, const ipk::ImageView &img, const BenchOptions &options, BenchResult &result)
+{
+    result = BenchResult();
+    result.name = c.name;
+    result.width = img.width();
+    result.height = img.height();
+    result.channels = img.channels();
+
+    try {
+        resetPeakResidentSetSize();
+        for (int i = 0; i < std::max(1, options.warmups); ++i) {
+            c.run(img);
+        }
+
+        double total = 0;
+        for (int i = 0; i < options.runs && (i == 0 || total < options.maxSeconds*1000); ++i) {
+            const Clock::time_point start = Clock::now();
+            ipk::Image out = c.run(img);
+            const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            // freeing the result isn't part of the kernel
+            out = ipk::Image();
+            result.milliseconds.push_back(ms);
+            total += ms;
+        }
+        result.peakRss = peakResidentSetSize();
+
+        // one more for the memory, profiling would slow the timed ones down
+        ipk::OperationTimer timer(c.name.toStdString());
+        c.run(img);
+        const ipk::OperationProfile profile = timer.finish();
+        result.peakBytes = profile.peakBytes;
+        result.bytesAllocated = profile.bytesAllocated;
+        for (const ipk::PhaseTime &phase : profile.phases) {
+            BenchPhase benchPhase;
+            benchPhase.name = phase.name;
+            benchPhase.milliseconds = phase.milliseconds;
+            benchPhase.peakBytes = phase.peakBytes;
+            benchPhase.peakResident = phase.peakResident;
+            result.phases.push_back(benchPhase);
+        }
+    } catch (const std::invalid_argument &) {
+        return false;
+    } catch (const std::exception &e) {
+        result.milliseconds.clear();
+        result.error = e.what();
+    }
+
+    std::sort(result.milliseconds.begin(), result.milliseconds.end());
+    return true;
+}
+
+long peakResidentSetSize()
+{
+#if defined(Q_OS_LINUX)
+    // VmHWM follows resetPeakResidentSetSize(), ru_maxrss doesn't
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        for (QByteArray line = status.readLine(); !line.isEmpty(); line = status.readLine()) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').first().toLong();
+            }
+        }
+    }
+#endif
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long>(counters.PeakWorkingSetSize/1024);
+    }
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#if defined(Q_OS_DARWIN)
+    // bytes there
+    return usage.ru_maxrss/1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+bool resetPeakResidentSetSize()
+{
+#if defined(Q_OS_LINUX)
+    // 5 resets the peak, Linux 4.0 and later
+    QFile clearRefs("/proc/self/clear_refs");
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,87 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "image.h"
+#include <QJsonObject>
+#include <QString>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// a benchmark case is a kernel with fixed parameters, timed on synthetic
+// images of several sizes, grayscale and RGB, see synthetic.h
+// every operation of the registry is there, with parameters close to
+// what the dialogs use, and so are the frequency kernels the GUI calls
+// directly (inverse and Wiener filters, IFFT, motion blur, ...)
+
+struct BenchCase
+{
+    // the operation text for registry operations, "median:5" say
+    QString name;
+    // throws std::invalid_argument for images it doesn't take
+    std::function<ipk::Image(const ipk::ImageView &)> run;
+};
+
+std::vector<BenchCase> benchCases();
+
+struct BenchOptions
+{
+    // timed runs of each case, after the warm up ones
+    int runs = 5;
+    int warmups = 1;
+    // fewer runs once a case has taken this long, one at least
+    double maxSeconds = 10;
+};
+
+// memory and time of a phase of a case, see profiler.h
+struct BenchPhase
+{
+    QString name;
+    double milliseconds = 0;
+    std::uint64_t peakBytes = 0;
+    // bytes, 0 if unknown
+    std::uint64_t peakResident = 0;
+};
+
+struct BenchResult
+{
+    QString name;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    // wall time of every timed run, sorted
+    std::vector<double> milliseconds;
+    // of the whole process in KB while the case ran, -1 if unknown
+    long peakRss = -1;
+    // image buffers a run took at most above its input, see memory.h,
+    // and the phases it went through, from one more run, profiled,
+    // after the timed ones, so they don't pay for the profiling
+    std::uint64_t peakBytes = 0;
+    // allocated by that run, blocks of the buffer pool used again don't
+    // count, so 0 or just the result once the pool has warmed up
+    std::uint64_t bytesAllocated = 0;
+    std::vector<BenchPhase> phases;
+    // what went wrong, empty if the case ran
+    QString error;
+
+    // p in [0, 100], interpolated between the nearest runs
+    double percentile(double p) const;
+    double median() const { return percentile(50); }
+    // from the median time
+    double megapixelsPerSecond() const;
+    QJsonObject toJson() const;
+    // back from toJson(), runs and all
+    static BenchResult fromJson(const QJsonObject &object);
+};
+
+// time c on img, false if c doesn't take images like img
+// other exceptions, running out of memory say, end up in result.error
+bool runCase(const BenchCase &c, const ipk::ImageView &img, const BenchOptions &options, BenchResult &result);
+
+// peak resident set size of the process in KB, -1 if unknown
+long peakResidentSetSize();
+// start the peak over from the current size, where the system allows it
+// returns false if the peak can't be reset, it's then the peak since start
+bool resetPeakResidentSetSize();
+
+#endif // BENCHMARK_H
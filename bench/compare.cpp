@@ -0,0 +1,161 @@
+#include "compare.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// up to this many samples on both sides, the exact distribution is cheap
+const int exactSamples = 40;
+
+// P(U >= u) for n samples against m, none tied, counting the orderings
+// of the two samples that give each U
+double exactGreater(int n, int m, double u)
+{
+    // count[i][k]: orderings of i samples of a and j of b with U = k,
+    // for the current j, built up one sample of b at a time
+    const int maxU = n*m;
+    std::vector<std::vector<double> > count(n + 1, std::vector<double>(maxU + 1, 0));
+    for (int i = 0; i <= n; ++i) {
+        count[i][0] = 1;
+    }
+    for (int j = 1; j <= m; ++j) {
+        std::vector<std::vector<double> > next(n + 1, std::vector<double>(maxU + 1, 0));
+        next[0][0] = 1;
+        for (int i = 1; i <= n; ++i) {
+            for (int k = 0; k <= i*j; ++k) {
+                // the largest of all is from b, or it's from a and beats all j of b
+                next[i][k] = count[i][k] + (k >= j ? next[i - 1][k - j] : 0);
+            }
+        }
+        count.swap(next);
+    }
+
+    double total = 0, above = 0;
+    for (int k = 0; k <= maxU; ++k) {
+        total += count[n][k];
+        if (k >= u - 1e-9) {
+            above += count[n][k];
+        }
+    }
+    return above/total;
+}
+
+} // namespace
+
+bool loadBaseline(const QString &fileName, std::vector<BenchResult> &results, QJsonObject &environment,
+                  QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("can't read %1").arg(fileName);
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    const QJsonObject root = document.object();
+    if (document.isNull()) {
+        error = QString("%1: %2").arg(fileName, parseError.errorString());
+        return false;
+    }
+    if (root["benchmark"].toString() != "ipkbench" || root["version"].toInt() != 1) {
+        error = QString("%1: not the JSON of ipkbench --json").arg(fileName);
+        return false;
+    }
+
+    environment = root["environment"].toObject();
+    results.clear();
+    for (const QJsonValue &value : root["results"].toArray()) {
+        results.push_back(BenchResult::fromJson(value.toObject()));
+    }
+    return true;
+}
+
+double mannWhitneyGreater(const std::vector<double> &a, const std::vector<double> &b)
+{
+    const int n = static_cast<int>(a.size()), m = static_cast<int>(b.size());
+    if (n == 0 || m == 0) {
+        return 1;
+    }
+
+    // ranks of both samples together, ties get the mean rank
+    std::vector<std::pair<double, int> > all;
+    for (double x : a) {
+        all.push_back({ x, 0 });
+    }
+    for (double x : b) {
+        all.push_back({ x, 1 });
+    }
+    std::sort(all.begin(), all.end());
+
+    double rankSum = 0, tieTerm = 0;
+    bool ties = false;
+    for (std::size_t i = 0; i < all.size();) {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+        const double rank = (i + 1 + j)/2.0;
+        for (std::size_t k = i; k < j; ++k) {
+            if (all[k].second == 0) {
+                rankSum += rank;
+            }
+        }
+        const double t = static_cast<double>(j - i);
+        tieTerm += t*t*t - t;
+        ties = ties || j - i > 1;
+        i = j;
+    }
+    // pairs where a is larger, ties count half
+    const double u = rankSum - n*(n + 1)/2.0;
+
+    if (!ties && n + m <= exactSamples) {
+        return exactGreater(n, m, u);
+    }
+
+    const double mean = n*m/2.0;
+    const double variance = n*m/12.0*((n + m + 1) - tieTerm/((n + m)*(n + m - 1.0)));
+    if (variance <= 0) {
+        return 1;
+    }
+    // with continuity correction
+    const double z = (u - mean - 0.5)/std::sqrt(variance);
+    return 0.5*std::erfc(z/std::sqrt(2.0));
+}
+
+Comparison compareResults(const BenchResult &baseline, const BenchResult &current, const CompareOptions &options)
+{
+    Comparison comparison;
+    if (!current.error.isEmpty() || current.milliseconds.empty()) {
+        comparison.verdict = CompareFailed;
+        return comparison;
+    }
+    const double threshold = options.threshold/100;
+    if (baseline.peakBytes > 0 && current.peakBytes > 0) {
+        comparison.memoryChange = static_cast<double>(current.peakBytes)/baseline.peakBytes - 1;
+        comparison.moreMemory = comparison.memoryChange > threshold;
+    }
+    // nothing to compare with, it can't be slower than that
+    if (baseline.milliseconds.empty()) {
+        return comparison;
+    }
+
+    comparison.change = baseline.median() > 0 ? current.median()/baseline.median() - 1 : 0;
+    if (comparison.change > 0) {
+        comparison.pValue = mannWhitneyGreater(current.milliseconds, baseline.milliseconds);
+        if (comparison.pValue < options.alpha && comparison.change > threshold) {
+            comparison.verdict = CompareSlower;
+        }
+    } else {
+        comparison.pValue = mannWhitneyGreater(baseline.milliseconds, current.milliseconds);
+        if (comparison.pValue < options.alpha && -comparison.change > threshold) {
+            comparison.verdict = CompareFaster;
+        }
+    }
+
+    return comparison;
+}
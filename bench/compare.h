@@ -0,0 +1,58 @@
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include "benchmark.h"
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+// a run against the JSON of an earlier one, --json writes that
+// a case is slower when its runs are slower than the baseline ones by
+// more than chance would make them, by a one-sided Mann-Whitney U test,
+// and its median is slower by more than a threshold too, since with
+// enough runs any difference is significant
+// the peak of the image buffers doesn't change from run to run, more of
+// it than the threshold allows is flagged as is
+
+// the results of a JSON written by ipkbench --json, and the environment
+// they were measured in
+bool loadBaseline(const QString &fileName, std::vector<BenchResult> &results, QJsonObject &environment,
+                  QString &error);
+
+// p of the samples of a being at least that much larger than those of b
+// if both came from the same distribution
+// exact for few samples without ties, normal approximation otherwise
+double mannWhitneyGreater(const std::vector<double> &a, const std::vector<double> &b);
+
+struct CompareOptions
+{
+    // in percent of the baseline median, and of its peak buffer bytes
+    double threshold = 5;
+    // significance level of the test
+    double alpha = 0.05;
+};
+
+enum CompareVerdict {
+    CompareSame,
+    CompareSlower,
+    CompareFaster,
+    // failed now, whatever it did before
+    CompareFailed
+};
+
+struct Comparison
+{
+    // current median over the baseline one, minus 1
+    double change = 0;
+    // of a slowdown, or of a speedup when faster
+    double pValue = 1;
+    CompareVerdict verdict = CompareSame;
+    // current peak buffer bytes over the baseline ones, minus 1,
+    // 0 if either is unknown
+    double memoryChange = 0;
+    bool moreMemory = false;
+};
+
+Comparison compareResults(const BenchResult &baseline, const BenchResult &current, const CompareOptions &options);
+
+#endif // COMPARE_H
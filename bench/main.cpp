@@ -0,0 +1,462 @@
+#include "benchmark.h"
+#include "compare.h"
+#include "verify.h"
+#include "bufferpool.h"
+#include "frequency.h"
+#include "parallel.h"
+#include "simd.h"
+#include "synthetic.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <algorithm>
+#include <cstdio>
+
+// ipkbench                                   everything, 256x256 up to 8192x8192
+// ipkbench --sizes 512,2048 --filter median --json median.json
+// ipkbench --verify                          against CImg, see verify.h
+// ipkbench --compare before.json --runs 10   slower than before? see compare.h
+// results go to stdout as a table, and as JSON to --json for comparing builds
+
+namespace {
+
+// what every case runs on, see synthetic.h
+ipk::SyntheticPattern inputPattern = ipk::SyntheticScene;
+std::uint32_t inputSeed = 0;
+
+QList<int> parseList(const QString &text, bool &ok)
+{
+    QList<int> values;
+    ok = true;
+    for (const QString &item : text.split(',', QString::SkipEmptyParts)) {
+        const int value = item.trimmed().toInt(&ok);
+        if (!ok || value <= 0) {
+            ok = false;
+            return QList<int>();
+        }
+        values << value;
+    }
+    ok = ok && !values.isEmpty();
+    return values;
+}
+
+QString compiler()
+{
+#if defined(__clang__)
+    return QString("clang %1.%2.%3").arg(__clang_major__).arg(__clang_minor__).arg(__clang_patchlevel__);
+#elif defined(__GNUC__)
+    return QString("gcc %1.%2.%3").arg(__GNUC__).arg(__GNUC_MINOR__).arg(__GNUC_PATCHLEVEL__);
+#elif defined(_MSC_VER)
+    return QString("msvc %1").arg(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+// what tells two builds or machines apart
+QJsonObject environment()
+{
+    QJsonObject object;
+    object["compiler"] = compiler();
+    object["qt"] = qVersion();
+    object["cpu"] = QSysInfo::currentCpuArchitecture();
+    object["os"] = QSysInfo::prettyProductName();
+#ifdef IPK_SSE2
+    object["sse2"] = true;
+#else
+    object["sse2"] = false;
+#endif
+#ifdef QT_NO_DEBUG
+    object["debug"] = false;
+#else
+    object["debug"] = true;
+#endif
+    object["threads"] = ipk::threadCount();
+    object["huge_pages"] = ipk::hugePages();
+    object["fft_precision"] = ipk::fftPrecision() == ipk::FftFloat ? "float" : "double";
+    object["pattern"] = ipk::syntheticPatternName(inputPattern);
+    object["seed"] = static_cast<double>(inputSeed);
+    object["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    return object;
+}
+
+// path - for stdout
+bool writeJson(const QString &path, const char *benchmark, const QJsonArray &results)
+{
+    QJsonObject document;
+    document["benchmark"] = benchmark;
+    document["version"] = 1;
+    document["environment"] = environment();
+    document["results"] = results;
+    const QByteArray json = QJsonDocument(document).toJson();
+
+    if (path == "-") {
+        return std::fwrite(json.constData(), 1, json.size(), stdout) == static_cast<std::size_t>(json.size());
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        std::fprintf(stderr, "can't write %s\n", qPrintable(path));
+        return false;
+    }
+    return true;
+}
+
+template<typename Case>
+void filterCases(std::vector<Case> &cases, const QRegularExpression &filter)
+{
+    std::vector<Case> matching;
+    for (const Case &c : cases) {
+        if (filter.match(c.name).hasMatch()) {
+            matching.push_back(c);
+        }
+    }
+    cases.swap(matching);
+}
+
+// every case on every input, 1 if any is off by more than it may be
+int verify(const std::vector<VerifyCase> &cases, const QList<int> &sizes, const QList<int> &channels,
+           const BenchOptions &options, const QString &jsonPath)
+{
+    FILE *table = jsonPath == "-" ? stderr : stdout;
+    std::fprintf(table, "%-22s %-20s %2s %7s %9s %11s %11s %11s %8s  %s\n",
+                 "case", "input", "ch", "max err", "mean err", "tolerance", "ms", "CImg ms", "speedup", "result");
+
+    QJsonArray results;
+    int failed = 0;
+    for (int c : channels) {
+        for (const VerifyInput &input : verifyInputs(sizes, c)) {
+            for (const VerifyCase &verifyCase : cases) {
+                VerifyResult result;
+                if (!::verifyCase(verifyCase, input, options, result)) {
+                    continue;
+                }
+                results.append(result.toJson());
+
+                if (!result.passed) {
+                    ++failed;
+                }
+                if (!result.error.isEmpty()) {
+                    std::fprintf(table, "%-22s %-20s %2d  failed: %s\n", qPrintable(verifyCase.name),
+                                 qPrintable(input.name), c, qPrintable(result.error));
+                } else {
+                    const QString tolerance = QString("%1/%2").arg(verifyCase.maxError).arg(verifyCase.meanError);
+                    std::fprintf(table, "%-22s %-20s %2d %7d %9.4f %11s %11.3f %11.3f %7.2fx  %s\n",
+                                 qPrintable(verifyCase.name), qPrintable(input.name), c, result.maxError,
+                                 result.meanError, qPrintable(tolerance), result.milliseconds,
+                                 result.referenceMilliseconds, result.speedup(), result.passed ? "ok" : "FAILED");
+                }
+                std::fflush(table);
+            }
+        }
+    }
+    std::fprintf(table, "%d failed\n", failed);
+
+    if (!jsonPath.isEmpty() && !writeJson(jsonPath, "ipkbench-verify", results)) {
+        return 2;
+    }
+    return failed ? 1 : 0;
+}
+
+const char *verdictText(CompareVerdict verdict)
+{
+    switch (verdict) {
+    case CompareSlower:
+        return "SLOWER";
+    case CompareFaster:
+        return "faster";
+    case CompareFailed:
+        return "FAILED";
+    default:
+        return "same";
+    }
+}
+
+// the cases of the baseline again, on the same images, 1 if any is slower
+// or takes more memory
+// sizes and channels narrow the baseline down, unless empty
+int compare(const std::vector<BenchCase> &cases, const std::vector<BenchResult> &baseline, const QList<int> &sizes,
+            const QList<int> &channels, const BenchOptions &options, const CompareOptions &compareOptions,
+            const QString &jsonPath)
+{
+    FILE *table = jsonPath == "-" ? stderr : stdout;
+    std::fprintf(table, "%-28s %11s %3s %11s %11s %8s %8s %8s  %s\n",
+                 "case", "size", "ch", "before ms", "median ms", "change", "p", "memory", "verdict");
+
+    QJsonArray results;
+    int slower = 0, faster = 0, moreMemory = 0, missing = 0;
+    ipk::Image img;
+    for (const BenchResult &before : baseline) {
+        if ((!sizes.isEmpty() && !sizes.contains(before.width))
+                || (!channels.isEmpty() && !channels.contains(before.channels))) {
+            continue;
+        }
+        auto c = std::find_if(cases.begin(), cases.end(), [&](const BenchCase &c) { return c.name == before.name; });
+        if (c == cases.end()) {
+            ++missing;
+            continue;
+        }
+
+        // the baseline comes size by size, so does the image
+        if (img.width() != before.width || img.height() != before.height || img.channels() != before.channels) {
+            img = ipk::syntheticImage(before.width, before.height, before.channels, inputPattern, inputSeed);
+        }
+        BenchResult result;
+        if (!runCase(*c, img, options, result)) {
+            continue;
+        }
+        results.append(result.toJson());
+
+        const Comparison comparison = compareResults(before, result, compareOptions);
+        slower += comparison.verdict == CompareSlower || comparison.verdict == CompareFailed;
+        faster += comparison.verdict == CompareFaster;
+        moreMemory += comparison.moreMemory;
+        const QString sizeText = QString("%1x%2").arg(before.width).arg(before.height);
+        std::fprintf(table, "%-28s %11s %3d %11.2f %11.2f %+7.1f%% %8.4f %+7.1f%%  %s%s\n", qPrintable(c->name),
+                     qPrintable(sizeText), before.channels, before.median(), result.median(),
+                     comparison.change*100, comparison.pValue, comparison.memoryChange*100,
+                     verdictText(comparison.verdict), comparison.moreMemory ? ", MORE MEMORY" : "");
+        std::fflush(table);
+    }
+    std::fprintf(table, "%d slower or failed, %d faster, %d taking more memory, %d in the baseline only\n",
+                 slower, faster, moreMemory, missing);
+
+    if (!jsonPath.isEmpty() && !writeJson(jsonPath, "ipkbench", results)) {
+        return 2;
+    }
+    return slower || moreMemory ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ipkbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Time the image processing kernels on synthetic images.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("sizes", "Square image sizes, 256,512,1024,2048,4096,8192 by default.", "list");
+    QCommandLineOption channelOption("channels", "1 for grayscale, 3 for RGB, both by default.", "list");
+    QCommandLineOption filterOption("filter", "Only the cases whose name matches the regular expression.", "regexp");
+    QCommandLineOption runOption("runs", "Timed runs of each case, 5 by default.", "n");
+    QCommandLineOption warmupOption("warmups", "Untimed runs before those, 1 by default.", "n");
+    QCommandLineOption secondOption("max-seconds", "Fewer runs once a case has taken that long, 10 by default.",
+                                    "seconds");
+    QCommandLineOption threadOption(QStringList() << "j" << "threads",
+                                    "Worker threads of the kernels, all hardware threads by default.", "n");
+    QCommandLineOption hugePageOption("huge-pages", "Transparent huge pages for the large blocks of the buffer pool,"
+                                      " Linux only.");
+    QCommandLineOption precisionOption("fft-precision", "Planes of the frequency domain kernels: float (default)"
+                                       " or double. --compare takes the one of the baseline.", "type");
+    QCommandLineOption jsonOption("json", "Write the results as JSON to file, - for stdout.", "file");
+    QCommandLineOption listOption("list", "List the cases.");
+    QCommandLineOption verifyOption("verify", "Compare the kernels with the CImg code they replaced, on edge cases"
+                                    " and random images of --sizes, 512 by default, and time both.");
+    parser.addOption(sizeOption);
+    parser.addOption(channelOption);
+    parser.addOption(filterOption);
+    parser.addOption(runOption);
+    parser.addOption(warmupOption);
+    parser.addOption(secondOption);
+    parser.addOption(threadOption);
+    parser.addOption(hugePageOption);
+    parser.addOption(precisionOption);
+    parser.addOption(jsonOption);
+    parser.addOption(listOption);
+    parser.addOption(verifyOption);
+    QCommandLineOption compareOption("compare", "Run the cases of a --json file again, and exit with 1 if any is"
+                                     " slower, significantly and beyond --threshold, or takes more buffer memory"
+                                     " beyond --threshold.", "file");
+    QCommandLineOption thresholdOption("threshold", "Slowdown of the median, and growth of the peak buffer memory,"
+                                       " that --compare flags, in percent, 5 by default.", "percent");
+    QCommandLineOption alphaOption("alpha", "Significance level of --compare, 0.05 by default.", "p");
+    QStringList patterns;
+    for (const std::string &name : ipk::syntheticPatternNames()) {
+        patterns << QString::fromStdString(name);
+    }
+    QCommandLineOption patternOption("pattern", QString("Synthetic image the cases run on: %1, scene by default."
+                                                        " --compare takes the one of the baseline.")
+                                     .arg(patterns.join(", ")), "name");
+    QCommandLineOption seedOption("seed", "Seed of the synthetic image, 0 by default."
+                                  " --compare takes the one of the baseline.", "n");
+    parser.addOption(patternOption);
+    parser.addOption(seedOption);
+    parser.addOption(compareOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(alphaOption);
+    parser.process(app);
+
+    const bool verifying = parser.isSet(verifyOption);
+    std::vector<BenchCase> cases = benchCases();
+    std::vector<VerifyCase> verifyCases = verifying ? ::verifyCases() : std::vector<VerifyCase>();
+    if (parser.isSet(filterOption)) {
+        const QRegularExpression filter(parser.value(filterOption));
+        if (!filter.isValid()) {
+            std::fprintf(stderr, "bad regular expression %s\n", qPrintable(parser.value(filterOption)));
+            return 2;
+        }
+        filterCases(cases, filter);
+        filterCases(verifyCases, filter);
+    }
+
+    if (parser.isSet(listOption)) {
+        if (verifying) {
+            for (const VerifyCase &c : verifyCases) {
+                std::printf("%s\n", qPrintable(c.name));
+            }
+        } else {
+            for (const BenchCase &c : cases) {
+                std::printf("%s\n", qPrintable(c.name));
+            }
+        }
+        return 0;
+    }
+
+    bool ok = true;
+    const QList<int> defaultSizes = verifying ? QList<int>() << 512
+                                              : QList<int>() << 256 << 512 << 1024 << 2048 << 4096 << 8192;
+    const QList<int> sizes = parser.isSet(sizeOption) ? parseList(parser.value(sizeOption), ok) : defaultSizes;
+    QList<int> channels;
+    if (ok) {
+        channels = parser.isSet(channelOption) ? parseList(parser.value(channelOption), ok) : QList<int>() << 1 << 3;
+    }
+    for (int c : channels) {
+        ok = ok && (c == 1 || c == 3);
+    }
+    if (!ok) {
+        std::fprintf(stderr, "sizes are positive, channels 1 or 3\n");
+        return 2;
+    }
+
+    BenchOptions options;
+    if (parser.isSet(runOption)) {
+        options.runs = std::max(1, parser.value(runOption).toInt());
+    }
+    if (parser.isSet(warmupOption)) {
+        options.warmups = std::max(0, parser.value(warmupOption).toInt());
+    }
+    if (parser.isSet(secondOption)) {
+        options.maxSeconds = parser.value(secondOption).toDouble();
+    }
+    if (parser.isSet(threadOption)) {
+        ipk::setThreadCount(std::max(1, parser.value(threadOption).toInt()));
+    }
+    ipk::setHugePages(parser.isSet(hugePageOption));
+    if (parser.isSet(precisionOption)) {
+        const QString precision = parser.value(precisionOption);
+        if (precision != "float" && precision != "double") {
+            std::fprintf(stderr, "unknown precision %s\n", qPrintable(precision));
+            return 2;
+        }
+        ipk::setFftPrecision(precision == "float" ? ipk::FftFloat : ipk::FftDouble);
+    }
+    if (parser.isSet(patternOption)) {
+        if (!patterns.contains(parser.value(patternOption))) {
+            std::fprintf(stderr, "unknown pattern %s\n", qPrintable(parser.value(patternOption)));
+            return 2;
+        }
+        inputPattern = ipk::syntheticPattern(parser.value(patternOption).toStdString());
+    }
+    if (parser.isSet(seedOption)) {
+        inputSeed = parser.value(seedOption).toUInt();
+    }
+
+    if (verifying) {
+        return verify(verifyCases, sizes, channels, options, parser.value(jsonOption));
+    }
+
+    if (parser.isSet(compareOption)) {
+        std::vector<BenchResult> baseline;
+        QJsonObject before;
+        QString error;
+        if (!loadBaseline(parser.value(compareOption), baseline, before, error)) {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 2;
+        }
+        // the cases run again on the input of the baseline, in its precision,
+        // options may repeat those but not change them
+        if (before.contains("pattern")) {
+            const QString pattern = before["pattern"].toString();
+            if (!patterns.contains(pattern)
+                    || (parser.isSet(patternOption) && parser.value(patternOption) != pattern)) {
+                std::fprintf(stderr, "the baseline ran on pattern %s\n", qPrintable(pattern));
+                return 2;
+            }
+            inputPattern = ipk::syntheticPattern(pattern.toStdString());
+        }
+        if (before.contains("seed")) {
+            const std::uint32_t seed = static_cast<std::uint32_t>(before["seed"].toDouble());
+            if (parser.isSet(seedOption) && inputSeed != seed) {
+                std::fprintf(stderr, "the baseline ran with seed %u\n", seed);
+                return 2;
+            }
+            inputSeed = seed;
+        }
+        if (before.contains("fft_precision")) {
+            const QString precision = before["fft_precision"].toString();
+            if ((precision != "float" && precision != "double")
+                    || (parser.isSet(precisionOption) && parser.value(precisionOption) != precision)) {
+                std::fprintf(stderr, "the baseline ran in %s precision\n", qPrintable(precision));
+                return 2;
+            }
+            ipk::setFftPrecision(precision == "float" ? ipk::FftFloat : ipk::FftDouble);
+        }
+        CompareOptions compareOptions;
+        if (parser.isSet(thresholdOption)) {
+            compareOptions.threshold = std::max(0.0, parser.value(thresholdOption).toDouble());
+        }
+        if (parser.isSet(alphaOption)) {
+            compareOptions.alpha = parser.value(alphaOption).toDouble();
+        }
+        return compare(cases, baseline, parser.isSet(sizeOption) ? sizes : QList<int>(),
+                       parser.isSet(channelOption) ? channels : QList<int>(), options, compareOptions,
+                       parser.value(jsonOption));
+    }
+
+    // the table goes to stderr when the JSON takes stdout
+    const bool jsonToStdout = parser.value(jsonOption) == "-";
+    FILE *table = jsonToStdout ? stderr : stdout;
+    std::fprintf(table, "%-28s %11s %3s %11s %11s %11s %9s %10s\n",
+                 "case", "size", "ch", "median ms", "p90 ms", "Mpix/s", "peak MB", "buffer MB");
+
+    QJsonArray results;
+    int failed = 0;
+    for (int size : sizes) {
+        for (int c : channels) {
+            const ipk::Image img = ipk::syntheticImage(size, size, c, inputPattern, inputSeed);
+            for (const BenchCase &benchCase : cases) {
+                BenchResult result;
+                if (!runCase(benchCase, img, options, result)) {
+                    // grayscale only kernels on RGB and the like
+                    continue;
+                }
+                results.append(result.toJson());
+
+                const QString sizeText = QString("%1x%2").arg(size).arg(size);
+                if (!result.error.isEmpty()) {
+                    ++failed;
+                    std::fprintf(table, "%-28s %11s %3d  failed: %s\n", qPrintable(benchCase.name),
+                                 qPrintable(sizeText), c, qPrintable(result.error));
+                } else {
+                    std::fprintf(table, "%-28s %11s %3d %11.2f %11.2f %11.1f %9.1f %10.1f\n",
+                                 qPrintable(benchCase.name), qPrintable(sizeText), c, result.median(),
+                                 result.percentile(90), result.megapixelsPerSecond(), result.peakRss/1024.0,
+                                 result.peakBytes/1048576.0);
+                }
+                std::fflush(table);
+            }
+        }
+    }
+
+    if (parser.isSet(jsonOption) && !writeJson(parser.value(jsonOption), "ipkbench", results)) {
+        return 2;
+    }
+
+    return failed ? 1 : 0;
+}
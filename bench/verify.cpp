@@ -0,0 +1,991 @@
+#include "verify.h"
+#include "cimgconvert.h"
+#include "colortransform.h"
+#include "filters.h"
+#include "frequency.h"
+#include "grayscale.h"
+#include "memory.h"
+#include "pipeline.h"
+#include "pipelinecache.h"
+#include "resample.h"
+#include "synthetic.h"
+#include "tiled.h"
+#include "warp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+using namespace cimg_library;
+
+namespace {
+
+typedef std::function<ipk::Image(const ipk::ImageView &)> Kernel;
+
+// the CImg side of a case, from and back to an Image
+Kernel cimgReference(const std::function<CImg<double>(CImg<double>)> &kernel)
+{
+    return [kernel](const ipk::ImageView &src) { return ipk::fromCImg(kernel(ipk::toCImg(src))); };
+}
+
+bool isPowerOfTwo(int n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+void checkFftSize(const CImg<double> &img)
+{
+    // no FFTW here, CImg's own FFT throws for other sizes
+    if (!isPowerOfTwo(img.width()) || !isPowerOfTwo(img.height())) {
+        throw std::invalid_argument("CImg's FFT: not a power of two size");
+    }
+}
+
+CImg<double> centred(const CImg<double> &img)
+{
+    return img.get_shift(img.width()/2, img.height()/2, 0, 0, 2);
+}
+
+// kernel with the frequency kernels in the given precision
+Kernel inPrecision(ipk::FftPrecision precision, const Kernel &kernel)
+{
+    return [precision, kernel](const ipk::ImageView &src) {
+        ipk::ScopedFftPrecision scope(precision);
+        return kernel(src);
+    };
+}
+
+bool isConstant(const ipk::ImageView &src)
+{
+    std::vector<unsigned char> buffer(src.width()*src.channels() + 64);
+    const unsigned char first = *src.pixel(0, 0);
+    for (int y = 0; y < src.height(); ++y) {
+        const unsigned char *row = src.readRow(y, buffer.data());
+        if (std::any_of(row, row + src.width()*src.channels(), [first](unsigned char v) { return v != first; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the kernel in float against itself in double, the accuracy of FftFloat
+// sizes CImg's FFT doesn't take are skipped, and constant images, what comes out of them is rounding errors
+// normalized to (0, 255), different ones in either precision
+void addPrecision(std::vector<VerifyCase> &cases, const char *name, const Kernel &kernel,
+                  int maxError, double meanError)
+{
+    const Kernel reference = inPrecision(ipk::FftDouble, kernel);
+    cases.push_back({ QString("float:%1").arg(name), inPrecision(ipk::FftFloat, kernel),
+                      [reference](const ipk::ImageView &src) {
+                          if (!isPowerOfTwo(src.width()) || !isPowerOfTwo(src.height())) {
+                              throw std::invalid_argument("CImg's FFT: not a power of two size");
+                          }
+                          if (isConstant(src)) {
+                              throw std::invalid_argument("constant image");
+                          }
+                          return reference(src);
+                      }, maxError, meanError });
+}
+
+// the kernel on a size x size grayscale image, failing if more than the
+// given planes of the given precision besides the result were live at
+// once, the bound frequency.h gives, see MemoryWatermark
+// the reference is the kernel itself, other inputs are skipped
+void addPeakMemory(std::vector<VerifyCase> &cases, const char *name, ipk::FftPrecision precision, int size,
+                   int planeCount, const Kernel &kernel)
+{
+    const Kernel run = inPrecision(precision, kernel);
+    const std::size_t sampleSize = precision == ipk::FftFloat ? sizeof(float) : sizeof(double);
+    const std::uint64_t planes = planeCount*static_cast<std::uint64_t>(size)*size*sampleSize;
+    cases.push_back({ QString("%1:peak-memory:%2").arg(precision == ipk::FftFloat ? "float" : "double").arg(name),
+                      [run, planes](const ipk::ImageView &src) {
+                          ipk::MemoryWatermark watermark;
+                          watermark.start();
+                          ipk::Image result = run(src);
+                          watermark.finish();
+                          // the result has 64 spare bytes after its last row
+                          const std::uint64_t bound = planes + result.byteCount() + 64;
+                          if (watermark.peakBytes() > bound) {
+                              throw std::runtime_error(QString("peak of %1 bytes, more than %2")
+                                                       .arg(watermark.peakBytes()).arg(bound).toStdString());
+                          }
+                          return result;
+                      },
+                      [run, size](const ipk::ImageView &src) {
+                          if (src.width() != size || src.height() != size || !src.isGrayscale()) {
+                              throw std::invalid_argument("peak memory: measured on one size only");
+                          }
+                          return run(src);
+                      }, 0, 0 });
+}
+
+const unsigned char crossElement[9] = { 0, 1, 0, 1, 1, 1, 0, 1, 0 };
+const unsigned char cornerElement[9] = { 1, 1, 0, 1, 1, 0, 0, 0, 0 };
+
+// from the custom filter dialog, and one that doesn't add up to anything
+const int smoothWeights[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 };
+const int sobelWeights[9] = { 1, 0, -1, 2, 0, -2, 1, 0, -1 };
+
+CImg<double> element(const unsigned char values[9])
+{
+    // row by row, like the kernels take it
+    CImg<double> s(3, 3);
+    for (int i = 0; i < 9; ++i) {
+        s[i] = values[i];
+    }
+    return s;
+}
+
+void addMorphology(std::vector<VerifyCase> &cases, const char *name, const unsigned char values[9])
+{
+    const CImg<double> s = element(values);
+    cases.push_back({ QString("erode:%1").arg(name),
+                      [values](const ipk::ImageView &src) { return ipk::erode(src, values); },
+                      cimgReference([s](CImg<double> img) { return img.erode(s); }), 0, 0 });
+    cases.push_back({ QString("dilate:%1").arg(name),
+                      [values](const ipk::ImageView &src) { return ipk::dilate(src, values); },
+                      cimgReference([s](CImg<double> img) { return img.dilate(s); }), 0, 0 });
+}
+
+void addCustom(std::vector<VerifyCase> &cases, const char *name, const int weights[9])
+{
+    CImg<double> kernel(3, 3);
+    for (int i = 0; i < 9; ++i) {
+        kernel[i] = weights[i];
+    }
+    // what the custom filter dialog did
+    if (kernel.sum() > 0) {
+        kernel /= 9;
+    }
+    cases.push_back({ QString("custom:%1").arg(name),
+                      [weights](const ipk::ImageView &src) { return ipk::customFilter(src, weights); },
+                      cimgReference([kernel](CImg<double> img) { return img.convolve(kernel); }), 0, 0 });
+}
+
+void addResize(std::vector<VerifyCase> &cases, const char *name, ipk::ResampleFilter filter,
+               int interpolation, double factor, int maxError, double meanError)
+{
+    auto size = [factor](int n) { return std::max(1, static_cast<int>(std::lround(n*factor))); };
+    cases.push_back({ QString("resize-%1:%2").arg(name).arg(factor),
+                      [=](const ipk::ImageView &src) {
+                          return ipk::resize(src, size(src.width()), size(src.height()), filter);
+                      },
+                      cimgReference([=](CImg<double> img) {
+                          return img.resize(size(img.width()), size(img.height()), 1, -100, interpolation);
+                      }), maxError, meanError });
+}
+
+// the formulas of the GUI before the core, the default one in integers,
+// the standard ones rounded from double
+ipk::Image referenceGrayscale(const ipk::ImageView &src, ipk::GrayWeights weights)
+{
+    if (!src.isRGB()) {
+        throw std::invalid_argument("grayscale: not an RGB image");
+    }
+
+    ipk::Image dst(src.width(), src.height(), 1);
+    for (int y = 0; y < src.height(); ++y) {
+        for (int x = 0; x < src.width(); ++x) {
+            const unsigned char *p = src.pixel(x, y);
+            const int r = p[0], g = p[1], b = p[2];
+            int gray;
+            switch (weights) {
+            case ipk::GrayBT601:
+                gray = static_cast<int>(std::lround(0.299*r + 0.587*g + 0.114*b));
+                break;
+            case ipk::GrayBT709:
+                gray = static_cast<int>(std::lround(0.2126*r + 0.7152*g + 0.0722*b));
+                break;
+            default:
+                gray = (11*r + 16*g + 5*b)/32;
+                break;
+            }
+            dst.scanLine(y)[x] = static_cast<unsigned char>(std::min(gray, 255));
+        }
+    }
+    return dst;
+}
+
+// the scanline overload on src written out in layout, rows a few bytes
+// apart more than needed, 8-bit samples v go to 16 bits as 257*v,
+// like QImage widens them
+ipk::Image scanlineGrayscale(const ipk::ImageView &src, ipk::PixelLayout layout, ipk::GrayWeights weights)
+{
+    if (!src.isRGB()) {
+        throw std::invalid_argument("grayscale: not an RGB image");
+    }
+
+    const int sampleSize = layout == ipk::LayoutRGBX16 ? 2 : 1;
+    const int samples = layout == ipk::LayoutRGB888 ? 3 : 4;
+    const std::size_t stride = static_cast<std::size_t>(src.width())*samples*sampleSize + 12;
+    std::vector<unsigned char> bits(stride*src.height());
+    for (int y = 0; y < src.height(); ++y) {
+        unsigned char *row = bits.data() + y*stride;
+        for (int x = 0; x < src.width(); ++x) {
+            const unsigned char *p = src.pixel(x, y);
+            // memory order, 255 for X
+            unsigned char values[4] = { p[0], p[1], p[2], 255 };
+            if (layout == ipk::LayoutBGRX8888) {
+                std::swap(values[0], values[2]);
+            }
+            for (int i = 0; i < samples; ++i) {
+                if (sampleSize == 2) {
+                    const std::uint16_t wide = static_cast<std::uint16_t>(257*values[i]);
+                    std::memcpy(row + (x*samples + i)*2, &wide, 2);
+                } else {
+                    row[x*samples + i] = values[i];
+                }
+            }
+        }
+    }
+
+    return ipk::toGrayscale(bits.data(), src.width(), src.height(), stride, layout, weights);
+}
+
+void addGrayscale(std::vector<VerifyCase> &cases, const char *name, ipk::GrayWeights weights)
+{
+    const Kernel reference = [weights](const ipk::ImageView &src) { return referenceGrayscale(src, weights); };
+    // the standard weights in Q15 round a level off now and then
+    const int maxError = weights == ipk::GrayDefault ? 0 : 1;
+    cases.push_back({ QString("grayscale:%1").arg(name),
+                      [weights](const ipk::ImageView &src) { return ipk::toGrayscale(src, weights); },
+                      reference, maxError, 0.01 });
+
+    const struct { const char *name; ipk::PixelLayout layout; } layouts[] = {
+        { "rgb888", ipk::LayoutRGB888 },
+        { "rgbx8888", ipk::LayoutRGBX8888 },
+        { "bgrx8888", ipk::LayoutBGRX8888 },
+        { "rgbx16", ipk::LayoutRGBX16 }
+    };
+    for (const auto &layout : layouts) {
+        const ipk::PixelLayout pixelLayout = layout.layout;
+        cases.push_back({ QString("grayscale-%1:%2").arg(layout.name).arg(name),
+                          [pixelLayout, weights](const ipk::ImageView &src) {
+                              return scanlineGrayscale(src, pixelLayout, weights);
+                          },
+                          reference, maxError, 0.01 });
+    }
+}
+
+// warp() pixel by pixel, exact coordinates in double, background beyond
+// the horizon and for taps outside src
+ipk::Image referenceWarp(const ipk::ImageView &src, const ipk::Transform &transform, int width, int height,
+                         ipk::WarpInterpolation interpolation, unsigned char background)
+{
+    const ipk::Transform inverse = transform.inverted();
+    const int c = src.channels();
+    const int before = interpolation == ipk::WarpBicubic ? 1 : 0;
+    const int taps = interpolation == ipk::WarpBicubic ? 4 : interpolation == ipk::WarpBilinear ? 2 : 1;
+    auto sample = [&](int x, int y, int ch) -> double {
+        return x >= 0 && x < src.width() && y >= 0 && y < src.height() ? src.pixel(x, y)[ch] : background;
+    };
+    // Keys, a = -0.5, and the tent
+    auto weight = [interpolation](double t) {
+        t = std::fabs(t);
+        if (interpolation == ipk::WarpBilinear) {
+            return 1 - t;
+        }
+        return t < 1 ? 1.5*t*t*t - 2.5*t*t + 1 : -0.5*t*t*t + 2.5*t*t - 4*t + 2;
+    };
+
+    ipk::Image dst(width, height, c);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char *out = dst.scanLine(y) + x*c;
+            std::fill(out, out + c, background);
+            const double w = inverse.m[6]*(x + 0.5) + inverse.m[7]*(y + 0.5) + inverse.m[8];
+            double sx, sy;
+            inverse.map(x + 0.5, y + 0.5, sx, sy);
+            sx -= 0.5;
+            sy -= 0.5;
+            // anything further is background for every kernel
+            if (!(w > 0) || std::fabs(sx) > 1e6 || std::fabs(sy) > 1e6) {
+                continue;
+            }
+            if (interpolation == ipk::WarpNearest) {
+                for (int ch = 0; ch < c; ++ch) {
+                    out[ch] = static_cast<unsigned char>(sample(static_cast<int>(std::floor(sx + 0.5)),
+                                                                static_cast<int>(std::floor(sy + 0.5)), ch));
+                }
+                continue;
+            }
+            const int ix = static_cast<int>(std::floor(sx)), iy = static_cast<int>(std::floor(sy));
+            for (int ch = 0; ch < c; ++ch) {
+                double sum = 0;
+                for (int j = 0; j < taps; ++j) {
+                    for (int k = 0; k < taps; ++k) {
+                        const int xx = ix - before + k, yy = iy - before + j;
+                        sum += weight(sx - xx)*weight(sy - yy)*sample(xx, yy, ch);
+                    }
+                }
+                out[ch] = static_cast<unsigned char>(std::min(255.0, std::max(0.0, sum)) + 0.5);
+            }
+        }
+    }
+    return dst;
+}
+
+// img with the pixels in front of the horizon of transform cleared
+ipk::Image beyondHorizon(ipk::Image img, const ipk::Transform &transform)
+{
+    const ipk::Transform inverse = transform.inverted();
+    for (int y = 0; y < img.height(); ++y) {
+        for (int x = 0; x < img.width(); ++x) {
+            if (inverse.m[6]*(x + 0.5) + inverse.m[7]*(y + 0.5) + inverse.m[8] > 0) {
+                std::fill(img.scanLine(y) + x*img.channels(), img.scanLine(y) + (x + 1)*img.channels(), 0);
+            }
+        }
+    }
+    return img;
+}
+
+// resize() in double, across then down: the filter centred on the centre
+// of every output pixel, widened by the scale when downscaling, border
+// pixels replicated, the first pass rounded and clamped to 8 bits like
+// resize() does
+ipk::Image referenceResize(const ipk::ImageView &src, int width, int height, ipk::ResampleFilter filter)
+{
+    const double support = filter == ipk::ResampleLanczos3 ? 3 : filter == ipk::ResampleBicubic ? 2 : 1;
+    auto weight = [filter](double t) {
+        t = std::fabs(t);
+        if (filter == ipk::ResampleLanczos3) {
+            const double pi = 3.14159265358979323846;
+            return t == 0 ? 1.0 : t < 3 ? 3*std::sin(pi*t)*std::sin(pi*t/3)/(pi*pi*t*t) : 0.0;
+        } else if (filter == ipk::ResampleBicubic) {
+            return t < 1 ? 1.5*t*t*t - 2.5*t*t + 1 : t < 2 ? -0.5*t*t*t + 2.5*t*t - 4*t + 2 : 0.0;
+        }
+        return t < 1 ? 1 - t : 0.0;
+    };
+    // source pixels and normalized weights of output pixel i of out, from in pixels
+    std::vector<std::pair<int, double> > taps;
+    auto weights = [&](int in, int out, int i) {
+        const double scale = static_cast<double>(in)/out, factor = std::max(1.0, scale);
+        const double centre = (i + 0.5)*scale;
+        taps.clear();
+        double total = 0;
+        for (int x = static_cast<int>(std::floor(centre - support*factor));
+             x <= static_cast<int>(std::ceil(centre + support*factor)); ++x) {
+            const double w = weight((x + 0.5 - centre)/factor);
+            taps.push_back(std::make_pair(std::min(in - 1, std::max(0, x)), w));
+            total += w;
+        }
+        for (std::pair<int, double> &tap : taps) {
+            tap.second /= total;
+        }
+    };
+    auto toByte = [](double value) {
+        return static_cast<unsigned char>(std::min(255.0, std::max(0.0, value)) + 0.5);
+    };
+    const int c = src.channels();
+
+    ipk::Image across(width, src.height(), c);
+    for (int x = 0; x < width; ++x) {
+        weights(src.width(), width, x);
+        for (int y = 0; y < src.height(); ++y) {
+            for (int ch = 0; ch < c; ++ch) {
+                double sum = 0;
+                for (const std::pair<int, double> &tap : taps) {
+                    sum += tap.second*src.scanLine(y)[tap.first*c + ch];
+                }
+                across.scanLine(y)[x*c + ch] = toByte(sum);
+            }
+        }
+    }
+    ipk::Image dst(width, height, c);
+    for (int y = 0; y < height; ++y) {
+        weights(src.height(), height, y);
+        for (int i = 0; i < width*c; ++i) {
+            double sum = 0;
+            for (const std::pair<int, double> &tap : taps) {
+                sum += tap.second*across.scanLine(tap.first)[i];
+            }
+            dst.scanLine(y)[i] = toByte(sum);
+        }
+    }
+    return dst;
+}
+
+// CImg's resize samples from the left edge whatever the centering asked
+// for, clamps positions rather than pixels for bicubic, and its lanczos
+// has two lobes, so those are checked against referenceResize() instead
+void addFilteredResize(std::vector<VerifyCase> &cases, const char *name, ipk::ResampleFilter filter,
+                       double factor, int maxError, double meanError)
+{
+    auto size = [factor](int n) { return std::max(1, static_cast<int>(std::lround(n*factor))); };
+    cases.push_back({ QString("resize-%1:%2").arg(name).arg(factor),
+                      [=](const ipk::ImageView &src) {
+                          return ipk::resize(src, size(src.width()), size(src.height()), filter);
+                      },
+                      [=](const ipk::ImageView &src) {
+                          return referenceResize(src, size(src.width()), size(src.height()), filter);
+                      }, maxError, meanError });
+}
+
+// warp() of src by transform into an image of its size against referenceWarp()
+void addWarp(std::vector<VerifyCase> &cases, const char *name,
+             const std::function<ipk::Transform(const ipk::ImageView &)> &transform,
+             ipk::WarpInterpolation interpolation, int maxError, double meanError)
+{
+    const char *interpolations[] = { "nearest", "bilinear", "bicubic" };
+    cases.push_back({ QString("warp-%1:%2").arg(name).arg(interpolations[interpolation]),
+                      [=](const ipk::ImageView &src) {
+                          return ipk::warp(src, transform(src), src.width(), src.height(), interpolation);
+                      },
+                      [=](const ipk::ImageView &src) {
+                          return referenceWarp(src, transform(src), src.width(), src.height(), interpolation, 0);
+                      }, maxError, meanError });
+}
+
+// a random image, from a seed of its own
+// the steps one by one, what the fused and banded runs must match
+ipk::Image applySteps(const ipk::Pipeline &pipeline, const ipk::ImageView &src)
+{
+    ipk::Image current = src.toImage();
+    for (const ipk::OperationStep &step : pipeline.steps()) {
+        current = step.apply(current);
+    }
+    return current;
+}
+
+// src repeated downwards over a few bands of Pipeline::run() whatever
+// its width, those are about 512k samples and at least 32 rows high
+ipk::Image stacked(const ipk::ImageView &src)
+{
+    const int height = std::max(3*(1 << 19)/(src.width()*src.channels()), 1024) + 37;
+    ipk::Image img(src.width(), height, src.channels());
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(img.scanLine(y), src.scanLine(y % src.height()), std::size_t(src.width())*src.channels());
+    }
+    return img;
+}
+
+// the images one below the other, all of the same width and channels
+ipk::Image stacked(const std::vector<ipk::Image> &images)
+{
+    int height = 0;
+    for (const ipk::Image &img : images) {
+        height += img.height();
+    }
+    ipk::Image result(images.front().width(), height, images.front().channels());
+    int y = 0;
+    for (const ipk::Image &img : images) {
+        for (int row = 0; row < img.height(); ++row, ++y) {
+            std::memcpy(result.scanLine(y), img.scanLine(row), std::size_t(img.width())*img.channels());
+        }
+    }
+    return result;
+}
+
+// Pipeline::run() against the steps one by one, on src stacked so the
+// local stages cross band boundaries
+void addPipeline(std::vector<VerifyCase> &cases, const char *name, const char *text)
+{
+    const ipk::Pipeline pipeline = ipk::Pipeline::fromString(text);
+    cases.push_back({ QString("pipeline:%1").arg(name),
+                      [pipeline](const ipk::ImageView &src) { return pipeline.run(stacked(src)); },
+                      [pipeline](const ipk::ImageView &src) { return applySteps(pipeline, stacked(src)); }, 0, 0 });
+}
+
+// runTiled() in bands of bandRows into images in memory
+void addTiled(std::vector<VerifyCase> &cases, const char *name, const char *text, int bandRows)
+{
+    const ipk::Pipeline pipeline = ipk::Pipeline::fromString(text);
+    cases.push_back({ QString("tiled:%1:%2").arg(name).arg(bandRows),
+                      [pipeline, bandRows](const ipk::ImageView &src) {
+                          return ipk::runTiled(pipeline, src, [](int width, int height, int channels, bool) {
+                              return ipk::Image(width, height, channels);
+                          }, bandRows);
+                      },
+                      [pipeline](const ipk::ImageView &src) { return applySteps(pipeline, src); }, 0, 0 });
+}
+
+// a PipelineCache run cold, warm and after step edited is replaced, the
+// three results one below the other against the steps one by one, and
+// it fails if the cache reused a step it shouldn't or not one it should
+void addPipelineCache(std::vector<VerifyCase> &cases, const char *name, const char *text,
+                      std::size_t edited, const char *replacement)
+{
+    const ipk::Pipeline pipeline = ipk::Pipeline::fromString(text);
+    ipk::Pipeline edit = pipeline;
+    edit.replace(edited, ipk::parseOperation(replacement));
+    cases.push_back({ QString("pipeline-cache:%1").arg(name),
+                      [pipeline, edit, edited](const ipk::ImageView &src) {
+                          ipk::PipelineCache cache;
+                          std::vector<bool> cold, warm, after;
+                          std::vector<ipk::Image> results;
+                          results.push_back(cache.run(pipeline, src, &cold));
+                          results.push_back(cache.run(pipeline, src, &warm));
+                          results.push_back(cache.run(edit, src, &after));
+                          for (std::size_t i = 0; i < cold.size(); ++i) {
+                              if (cold[i] || !warm[i] || (i >= edited && after[i])) {
+                                  throw std::runtime_error(QString("step %1 %2 reused").arg(i)
+                                                           .arg(cold[i] || i >= edited ? "wrongly" : "not")
+                                                           .toStdString());
+                              }
+                          }
+                          return stacked(results);
+                      },
+                      [pipeline, edit](const ipk::ImageView &src) {
+                          const ipk::Image result = applySteps(pipeline, src);
+                          return stacked(std::vector<ipk::Image>{ result, result, applySteps(edit, src) });
+                      }, 0, 0 });
+}
+
+ipk::Image randomImage(int width, int height, int channels, unsigned int seed)
+{
+    ipk::Image img(width, height, channels);
+    std::mt19937 generator(seed);
+    for (int y = 0; y < height; ++y) {
+        unsigned char *row = img.scanLine(y);
+        for (int i = 0; i < width*channels; ++i) {
+            row[i] = static_cast<unsigned char>(generator() & 255);
+        }
+    }
+    return img;
+}
+
+ipk::Image constantImage(int width, int height, int channels, unsigned char value)
+{
+    ipk::Image img(width, height, channels);
+    for (int y = 0; y < height; ++y) {
+        std::fill(img.scanLine(y), img.scanLine(y) + width*channels, value);
+    }
+    return img;
+}
+
+// 0 and 255 side by side, the largest steps there are
+ipk::Image checkerboard(int width, int height, int channels)
+{
+    ipk::Image img(width, height, channels);
+    for (int y = 0; y < height; ++y) {
+        unsigned char *row = img.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            std::fill(row + x*channels, row + (x + 1)*channels, ((x ^ y) & 1) ? 255 : 0);
+        }
+    }
+    return img;
+}
+
+} // namespace
+
+std::vector<VerifyCase> verifyCases()
+{
+    std::vector<VerifyCase> cases;
+
+    // the rank and box filters match CImg exactly
+    for (int size : { 3, 4, 5 }) {
+        cases.push_back({ QString("median:%1").arg(size),
+                          [size](const ipk::ImageView &src) { return ipk::medianFilter(src, size); },
+                          cimgReference([size](CImg<double> img) {
+                              // blur_median loops forever on those
+                              if (img.width() == 1) {
+                                  throw std::invalid_argument("CImg's median: one pixel wide image");
+                              }
+                              return img.blur_median(size);
+                          }), 0, 0 });
+        // even windows reach right and below, like correlate, convolve flips them
+        cases.push_back({ QString("average:%1").arg(size),
+                          [size](const ipk::ImageView &src) { return ipk::averageFilter(src, size); },
+                          cimgReference([size](CImg<double> img) {
+                              return img.correlate(CImg<double>(size, size, 1, 1, 1.0/size/size));
+                          }), 0, 0 });
+    }
+    // CImg's dilate flips even windows too, odd ones only
+    for (int size : { 3, 5 }) {
+        cases.push_back({ QString("max:%1").arg(size),
+                          [size](const ipk::ImageView &src) { return ipk::maximumFilter(src, size); },
+                          cimgReference([size](CImg<double> img) { return img.dilate(size); }), 0, 0 });
+        cases.push_back({ QString("min:%1").arg(size),
+                          [size](const ipk::ImageView &src) { return ipk::minimumFilter(src, size); },
+                          cimgReference([size](CImg<double> img) { return img.erode(size); }), 0, 0 });
+    }
+    addMorphology(cases, "cross", crossElement);
+    addMorphology(cases, "corner", cornerElement);
+    addCustom(cases, "smooth", smoothWeights);
+    addCustom(cases, "sobel", sobelWeights);
+
+    // every layout of the scanlines, against the per pixel formulas
+    addGrayscale(cases, "default", ipk::GrayDefault);
+    addGrayscale(cases, "bt601", ipk::GrayBT601);
+    addGrayscale(cases, "bt709", ipk::GrayBT709);
+
+    // a perspective with its horizon two thirds across the output, what
+    // is beyond it must be background, the pixels in front of it are
+    // cleared on both sides, segments that close to it are far off
+    auto horizon = [](const ipk::ImageView &src) {
+        return ipk::Transform(1, 0, 0, 0, 1, 0, 1.5/src.width(), 0, 1);
+    };
+    cases.push_back({ "warp-perspective:horizon",
+                      [horizon](const ipk::ImageView &src) {
+                          const ipk::Transform transform = horizon(src);
+                          return beyondHorizon(ipk::warp(src, transform, src.width(), src.height(),
+                                                         ipk::WarpBilinear, 7), transform);
+                      },
+                      [horizon](const ipk::ImageView &src) {
+                          const ipk::Transform transform = horizon(src);
+                          return beyondHorizon(referenceWarp(src, transform, src.width(), src.height(),
+                                                             ipk::WarpBilinear, 7), transform);
+                      }, 0, 0 });
+
+    // the resampler averages and samples pixel centres where CImg doesn't,
+    // so only nearest upscaling by whole factors and area are comparable,
+    // area in fixed point is 1 off at most
+    addResize(cases, "nearest", ipk::ResampleNearest, 1, 2, 0, 0);
+    addResize(cases, "nearest", ipk::ResampleNearest, 1, 3, 0, 0);
+    addResize(cases, "area", ipk::ResampleArea, 2, 0.5, 1, 0.5);
+    addResize(cases, "area", ipk::ResampleArea, 2, 0.37, 1, 0.5);
+    for (double factor : { 2.0, 1.7 }) {
+        cases.push_back({ QString("resize-bilinear:%1").arg(factor),
+                          [factor](const ipk::ImageView &src) {
+                              return ipk::resize(src, static_cast<int>(std::lround(src.width()*factor)),
+                                                 static_cast<int>(std::lround(src.height()*factor)),
+                                                 ipk::ResampleBilinear);
+                          },
+                          cimgReference([factor](CImg<double> img) {
+                              // at the centres of the output pixels, border pixels replicated
+                              const int width = static_cast<int>(std::lround(img.width()*factor));
+                              const int height = static_cast<int>(std::lround(img.height()*factor));
+                              const double scaleX = static_cast<double>(img.width())/width;
+                              const double scaleY = static_cast<double>(img.height())/height;
+                              CImg<double> result(width, height, 1, img.spectrum());
+                              cimg_forXYC(result, x, y, c) {
+                                  result(x, y, 0, c) = img.linear_atXY(static_cast<float>((x + 0.5)*scaleX - 0.5),
+                                                                       static_cast<float>((y + 0.5)*scaleY - 0.5),
+                                                                       0, c);
+                              }
+                              return result;
+                          }), 1, 0.3 });
+    }
+    // the weights in fixed point are a level off here and there
+    addFilteredResize(cases, "bilinear", ipk::ResampleBilinear, 0.6, 1, 0.1);
+    addFilteredResize(cases, "bicubic", ipk::ResampleBicubic, 2, 1, 0.1);
+    addFilteredResize(cases, "bicubic", ipk::ResampleBicubic, 0.6, 1, 0.1);
+    addFilteredResize(cases, "lanczos", ipk::ResampleLanczos3, 2, 2, 0.1);
+    addFilteredResize(cases, "lanczos", ipk::ResampleLanczos3, 0.6, 2, 0.1);
+
+    // rotate() keeping the size against CImg's rotation about the centre,
+    // which turns clockwise, background outside the source for both
+    // CImg rotates in float, so a few nearest pixels land on the neighbour
+    for (int interpolation : { ipk::WarpNearest, ipk::WarpBilinear, ipk::WarpBicubic }) {
+        for (double degree : { 30.0, -117.5 }) {
+            const char *names[] = { "nearest", "bilinear", "bicubic" };
+            cases.push_back({ QString("rotate:%1,%2").arg(degree).arg(names[interpolation]),
+                              [degree, interpolation](const ipk::ImageView &src) {
+                                  return ipk::rotate(src, degree, static_cast<ipk::WarpInterpolation>(interpolation),
+                                                     false);
+                              },
+                              cimgReference([degree, interpolation](CImg<double> img) {
+                                  return img.get_rotate(static_cast<float>(-degree), 0.5f*(img.width() - 1),
+                                                        0.5f*(img.height() - 1), interpolation, 0);
+                              }), interpolation == ipk::WarpNearest ? 255 : 1,
+                              interpolation == ipk::WarpNearest ? 0.1 : 0.01 });
+        }
+    }
+
+    // an affine map and a mild perspective, against referenceWarp()
+    // the perspective has exact coordinates every 8 pixels only and linear
+    // ones in between, a fraction of a pixel off, which shows most on the
+    // checkerboard
+    auto affine = [](const ipk::ImageView &src) {
+        return ipk::Transform(0.9, 0.25, 0.1*src.width(), -0.2, 1.1, 0.05*src.height());
+    };
+    auto perspective = [](const ipk::ImageView &src) {
+        return ipk::Transform(1, 0.1, 0, 0.05, 0.95, 0, 0.05/src.width(), 0.03/src.height(), 1);
+    };
+    for (ipk::WarpInterpolation interpolation : { ipk::WarpNearest, ipk::WarpBilinear, ipk::WarpBicubic }) {
+        const bool nearest = interpolation == ipk::WarpNearest;
+        addWarp(cases, "affine", affine, interpolation, nearest ? 255 : 1, 0.01);
+        addWarp(cases, "perspective", perspective, interpolation, nearest ? 255 : 7, nearest ? 2.5 : 1.25);
+    }
+
+    // the colour transforms of the GUI before the core, through CImg's HSV
+    // and YUV in double, with V and Y in (0, 255) as colortransform.h has
+    // them, and the slope of the last piece through (r2, s2) as it should
+    cases.push_back({ "hsv:40,1.3,0.8", [](const ipk::ImageView &src) { return ipk::adjustHsv(src, 40, 1.3f, 0.8f); },
+                      cimgReference([](CImg<double> img) {
+                          if (img.spectrum() != 3) {
+                              throw std::invalid_argument("hsv: not an RGB image");
+                          }
+                          img.RGBtoHSV();
+                          cimg_forXY(img, x, y) {
+                              img(x, y, 0) = std::fmod(img(x, y, 0) + 40, 360);
+                              img(x, y, 1) = 1.3*img(x, y, 1);
+                              img(x, y, 2) = 0.8*img(x, y, 2);
+                          }
+                          return img.HSVtoRGB();
+                      }), 1, 0.01 });
+    cases.push_back({ "hsv:-100,0.5,1.2", [](const ipk::ImageView &src) { return ipk::adjustHsv(src, -100, 0.5f, 1.2f); },
+                      cimgReference([](CImg<double> img) {
+                          if (img.spectrum() != 3) {
+                              throw std::invalid_argument("hsv: not an RGB image");
+                          }
+                          img.RGBtoHSV();
+                          cimg_forXY(img, x, y) {
+                              img(x, y, 0) = std::fmod(img(x, y, 0) - 100, 360);
+                              img(x, y, 1) = 0.5*img(x, y, 1);
+                              img(x, y, 2) = 1.2*img(x, y, 2);
+                          }
+                          return img.HSVtoRGB();
+                      }), 1, 0.01 });
+    for (double k : { 1.2, 0.7 }) {
+        const double b = k > 1 ? -10 : 40;
+        cases.push_back({ QString("linear:%1,%2").arg(k).arg(b),
+                          [k, b](const ipk::ImageView &src) { return ipk::linearTransformation(src, k, b); },
+                          cimgReference([k, b](CImg<double> img) {
+                              if (img.spectrum() == 1) {
+                                  return img*k + b;
+                              }
+                              img.RGBtoHSV();
+                              cimg_forXY(img, x, y) {
+                                  img(x, y, 2) = (255*img(x, y, 2)*k + b)/255;
+                              }
+                              return img.HSVtoRGB();
+                          }), 1, 0.01 });
+    }
+    cases.push_back({ "piecewise:70,30,180,220",
+                      [](const ipk::ImageView &src) { return ipk::piecewiseLinearTransformation(src, 70, 30, 180, 220); },
+                      cimgReference([](CImg<double> img) {
+                          const double r1 = 70, s1 = 30, r2 = 180, s2 = 220;
+                          auto f = [=](double r) {
+                              if (r < r1) {
+                                  return s1/r1*r;
+                              } else if (r < r2) {
+                                  return (s2 - s1)/(r2 - r1)*(r - r1) + s1;
+                              }
+                              return (255 - s2)/(255 - r2)*(r - r2) + s2;
+                          };
+                          if (img.spectrum() == 1) {
+                              cimg_forXY(img, x, y) {
+                                  img(x, y) = f(img(x, y));
+                              }
+                              return img;
+                          }
+                          img.RGBtoYUV();
+                          cimg_forXY(img, x, y) {
+                              img(x, y, 0) = f(255*img(x, y, 0))/255;
+                          }
+                          return img.YUVtoRGB();
+                      }), 1, 0.01 });
+
+    // the frequency kernels as the GUI computed them before the core, in
+    // double like it did, a faster FFT may round a level off here and there
+    cases.push_back({ "spectrum", inPrecision(ipk::FftDouble, [](const ipk::ImageView &src) {
+                          return ipk::spectrum(src);
+                      }),
+                      cimgReference([](CImg<double> img) {
+                          checkFftSize(img);
+                          CImgList<double> F = img.get_FFT();
+                          CImg<double> result = (F[0].get_sqr() + F[1].get_sqr()).sqrt();
+                          result = ((result + 1).log().sqrt() + 1).log();
+                          return centred(result.normalize(0, 255));
+                      }), 2, 0.1 });
+    cases.push_back({ "ifft:complete", inPrecision(ipk::FftDouble, [](const ipk::ImageView &src) {
+                          return ipk::ifft(src, ipk::IfftComplete);
+                      }),
+                      cimgReference([](CImg<double> img) {
+                          checkFftSize(img);
+                          CImgList<double> F = img.get_FFT();
+                          CImg<double>::FFT(F[0], F[1], true);
+                          return F[0].normalize(0, 255);
+                      }), 2, 0.1 });
+    cases.push_back({ "ideal-lowpass:40", inPrecision(ipk::FftDouble, [](const ipk::ImageView &src) {
+                          return ipk::idealLowPassFilter(src, 40);
+                      }),
+                      cimgReference([](CImg<double> img) {
+                          checkFftSize(img);
+                          if (img.spectrum() != 1) {
+                              throw std::invalid_argument("ideal lowpass: not a grayscale image");
+                          }
+                          CImgList<double> F = img.get_FFT();
+                          CImg<double> H(img.width(), img.height(), 1, 1, 0.0);
+                          cimg_forXY(H, x, y) {
+                              const int dx = x - img.width()/2, dy = y - img.height()/2;
+                              H(x, y) = std::sqrt(static_cast<double>(dx*dx + dy*dy)) <= 40 ? 1 : 0;
+                          }
+                          // H is centred, F isn't
+                          H = centred(H);
+                          F[0].mul(H);
+                          F[1].mul(H);
+                          CImg<double>::FFT(F[0], F[1], true);
+                          return F[0].normalize(0, 255);
+                      }), 2, 0.1 });
+
+    // and in float, the default, against double, no noise so both get the same input
+    // the spectrum is in double either way
+    addPrecision(cases, "spectrum", [](const ipk::ImageView &src) { return ipk::spectrum(src); }, 0, 0);
+    addPrecision(cases, "ifft:complete", [](const ipk::ImageView &src) {
+        return ipk::ifft(src, ipk::IfftComplete);
+    }, 1, 0.1);
+    addPrecision(cases, "ifft:magnitude", [](const ipk::ImageView &src) {
+        return ipk::ifft(src, ipk::IfftMagnitude);
+    }, 1, 0.1);
+    addPrecision(cases, "ifft:phase", [](const ipk::ImageView &src) {
+        return ipk::ifft(src, ipk::IfftPhase);
+    }, 1, 0.1);
+    addPrecision(cases, "ideal-lowpass:40", [](const ipk::ImageView &src) {
+        return ipk::idealLowPassFilter(src, 40);
+    }, 1, 0.1);
+    addPrecision(cases, "butterworth-lowpass:2,40", [](const ipk::ImageView &src) {
+        return ipk::butterworthLowPassFilter(src, 2, 40);
+    }, 1, 0.1);
+    addPrecision(cases, "homomorphic:0.5,2,1,40", [](const ipk::ImageView &src) {
+        return ipk::homomorphicFilter(src, 0.5, 2, 1, 40);
+    }, 1, 0.1);
+    addPrecision(cases, "atmospheric:0.00025", [](const ipk::ImageView &src) {
+        return ipk::atmosphericCirculationBlur(src, 0.00025);
+    }, 1, 0.1);
+    addPrecision(cases, "inverse:30", [](const ipk::ImageView &src) {
+        return ipk::inverseFilter(src, ipk::NoiseNone, 30, 0, 10, 30);
+    }, 1, 0.1);
+    addPrecision(cases, "wiener:800", [](const ipk::ImageView &src) {
+        return ipk::wienerFilter(src, ipk::NoiseNone, 0, 10, 30, 800);
+    }, 1, 0.1);
+
+    // the fused and banded runs against the steps one by one, wiener and
+    // grayscale make RGB images gray ahead of the stages banded with them
+    addPipeline(cases, "local", "median:3\naverage:5\ndilate\nmax:3\ncustom:1,2,1,2,4,2,1,2,1");
+    addPipeline(cases, "point-local", "negative\nlinear:1.2,-10\naverage:3\nmedian:5\nlaplacian");
+    addPipeline(cases, "grayscale-local", "grayscale:1\nmedian:3\nthreshold:128\nclosing");
+    const ipk::Pipeline wienerLocal = ipk::Pipeline::fromString("wiener:0,0,10,30,800\naverage:3\nmedian:3");
+    cases.push_back({ "pipeline:wiener-local",
+                      [wienerLocal](const ipk::ImageView &src) { return wienerLocal.run(src); },
+                      [wienerLocal](const ipk::ImageView &src) {
+                          checkFftSize(ipk::toCImg(src));
+                          return applySteps(wienerLocal, src);
+                      }, 0, 0 });
+    addTiled(cases, "local-resample", "median:3\nscale:0.7\naverage:5\ndilate\nresize:97,61,2", 7);
+    addTiled(cases, "grayscale-local", "grayscale\nmedian:5\naverage:3", 5);
+    addPipelineCache(cases, "resample", "median:3\nscale:0.5,1\naverage:5\nmax:3", 3, "min:3");
+    addPipelineCache(cases, "point", "negative\nmedian:3\nlinear:0.8,20\naverage:3", 2, "linear:1.1,-5");
+
+    // the spectrum transformed in place and nothing else, in both
+    // precisions, and the OTF beside it for the deblurring
+    for (ipk::FftPrecision precision : { ipk::FftFloat, ipk::FftDouble }) {
+        addPeakMemory(cases, "butterworth-lowpass:2,40", precision, 256, 2, [](const ipk::ImageView &src) {
+            return ipk::butterworthLowPassFilter(src, 2, 40);
+        });
+        addPeakMemory(cases, "homomorphic:0.5,2,1,40", precision, 256, 2, [](const ipk::ImageView &src) {
+            return ipk::homomorphicFilter(src, 0.5, 2, 1, 40);
+        });
+        addPeakMemory(cases, "ifft:complete", precision, 256, 2, [](const ipk::ImageView &src) {
+            return ipk::ifft(src, ipk::IfftComplete);
+        });
+        addPeakMemory(cases, "ifft:phase", precision, 256, 2, [](const ipk::ImageView &src) {
+            return ipk::ifft(src, ipk::IfftPhase);
+        });
+        addPeakMemory(cases, "inverse:30", precision, 256, 4, [](const ipk::ImageView &src) {
+            return ipk::inverseFilter(src, ipk::NoiseNone, 30, 0, 10, 30);
+        });
+        addPeakMemory(cases, "wiener:800", precision, 256, 4, [](const ipk::ImageView &src) {
+            return ipk::wienerFilter(src, ipk::NoiseNone, 0, 10, 30, 800);
+        });
+    }
+
+    return cases;
+}
+
+std::vector<VerifyInput> verifyInputs(const QList<int> &sizes, int channels)
+{
+    std::vector<VerifyInput> inputs;
+
+    for (int size : sizes) {
+        inputs.push_back({ QString("random %1x%1").arg(size), randomImage(size, size, channels, size*4 + channels) });
+    }
+    inputs.push_back({ "random 257x193", randomImage(257, 193, channels, 1) });
+    inputs.push_back({ "1x1", randomImage(1, 1, channels, 2) });
+    inputs.push_back({ "row 64x1", randomImage(64, 1, channels, 3) });
+    inputs.push_back({ "column 1x64", randomImage(1, 64, channels, 4) });
+    inputs.push_back({ "row 37x1", randomImage(37, 1, channels, 5) });
+    inputs.push_back({ "constant 64x64", constantImage(64, 64, channels, 128) });
+    inputs.push_back({ "black 64x64", constantImage(64, 64, channels, 0) });
+    inputs.push_back({ "white 64x64", constantImage(64, 64, channels, 255) });
+    inputs.push_back({ "checkerboard 64x64", checkerboard(64, 64, channels) });
+    // prime sizes, and what the frequency filters are for
+    inputs.push_back({ "text 211x127", ipk::syntheticImage(211, 127, channels, ipk::SyntheticText, 1) });
+    inputs.push_back({ "bars 256x256", ipk::syntheticImage(256, 256, channels, ipk::SyntheticBars) });
+    inputs.push_back({ "impulses 128x128", ipk::syntheticImage(128, 128, channels, ipk::SyntheticImpulses, 1) });
+
+    return inputs;
+}
+
+double VerifyResult::speedup() const
+{
+    return milliseconds > 0 ? referenceMilliseconds/milliseconds : 0;
+}
+
+QJsonObject VerifyResult::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["input"] = input;
+    object["channels"] = channels;
+    object["passed"] = passed;
+    if (!error.isEmpty()) {
+        object["error"] = error;
+        return object;
+    }
+
+    object["max_error"] = maxError;
+    object["mean_error"] = meanError;
+    object["median_ms"] = milliseconds;
+    object["reference_median_ms"] = referenceMilliseconds;
+    object["speedup"] = speedup();
+    return object;
+}
+
+bool verifyCase(const VerifyCase &c, const VerifyInput &input, const BenchOptions &options, VerifyResult &result)
+{
+    result = VerifyResult();
+    result.name = c.name;
+    result.input = input.name;
+    result.channels = input.image.channels();
+
+    ipk::Image expected, actual;
+    try {
+        expected = c.reference(input.image);
+    } catch (const std::invalid_argument &) {
+        return false;
+    } catch (const std::exception &e) {
+        result.error = e.what();
+        return true;
+    }
+    // whatever the reference takes the kernel must take too
+    try {
+        actual = c.run(input.image);
+    } catch (const std::exception &e) {
+        result.error = e.what();
+        return true;
+    }
+
+    if (actual.width() != expected.width() || actual.height() != expected.height()
+            || actual.channels() != expected.channels()) {
+        result.error = QString("%1x%2x%3 instead of %4x%5x%6").arg(actual.width()).arg(actual.height())
+                       .arg(actual.channels()).arg(expected.width()).arg(expected.height()).arg(expected.channels());
+        return true;
+    }
+
+    double total = 0;
+    const int n = actual.width()*actual.channels();
+    for (int y = 0; y < actual.height(); ++y) {
+        const unsigned char *a = actual.scanLine(y), *b = expected.scanLine(y);
+        for (int i = 0; i < n; ++i) {
+            const int difference = std::abs(a[i] - b[i]);
+            result.maxError = std::max(result.maxError, difference);
+            total += difference;
+        }
+    }
+    result.meanError = total/(static_cast<double>(n)*actual.height());
+    result.passed = result.maxError <= c.maxError && result.meanError <= c.meanError;
+
+    BenchResult kernel, reference;
+    runCase({ c.name, c.run }, input.image, options, kernel);
+    runCase({ c.name, c.reference }, input.image, options, reference);
+    result.milliseconds = kernel.median();
+    result.referenceMilliseconds = reference.median();
+
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "benchmark.h"
+#include "image.h"
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <functional>
+#include <vector>
+
+// differential checks of the kernels against the CImg code they replaced
+// both run on random images and on edge cases (odd and prime sizes, one
+// pixel, a single row or column, constant, black and white, text, bars
+// and blurred points from synthetic.h), the outputs are
+// compared sample by sample, and both are timed for the speedup
+//
+// grayscale:* and grayscale-<layout>:* take the per pixel formulas of
+// the GUI before the core as reference, the latter through every
+// layout of scanlines toGrayscale() reads
+// so do hsv:*, linear:* and piecewise:*, rotate:* takes CImg's rotation,
+// bilinear upscaling CImg's interpolation, the other resize-* and warp-*
+// cases the filters evaluated in double
+//
+// the frequency kernels in float are checked against themselves in
+// double the same way, the float:* cases, see setFftPrecision()
+// the *:peak-memory:* cases fail if a filter takes more memory than
+// frequency.h says
+//
+// pipeline:*, tiled:* and pipeline-cache:* check that Pipeline::run(),
+// runTiled() and PipelineCache give what the steps give one by one,
+// pipeline:* on the input stacked over a few bands
+//
+// a reference throws std::invalid_argument for images it can't take:
+// CImg's FFT wants power of two sizes, its median never returns on
+// images one pixel wide, and so on, those inputs are skipped, a kernel
+// throwing for an input its reference takes fails
+
+struct VerifyCase
+{
+    QString name;
+    std::function<ipk::Image(const ipk::ImageView &)> run;
+    std::function<ipk::Image(const ipk::ImageView &)> reference;
+    // largest difference allowed for a sample, and on average
+    int maxError;
+    double meanError;
+};
+
+std::vector<VerifyCase> verifyCases();
+
+struct VerifyInput
+{
+    QString name;
+    ipk::Image image;
+};
+
+// a random size x size image for each size, and the edge cases
+// the same pixels every time, whatever the machine
+std::vector<VerifyInput> verifyInputs(const QList<int> &sizes, int channels);
+
+struct VerifyResult
+{
+    QString name;
+    QString input;
+    int channels = 0;
+    int maxError = 0;
+    double meanError = 0;
+    // median of the timed runs
+    double milliseconds = 0;
+    double referenceMilliseconds = 0;
+    // what went wrong, size mismatch included, empty if both ran
+    QString error;
+    bool passed = false;
+
+    double speedup() const;
+    QJsonObject toJson() const;
+};
+
+// run c and its reference on input, compare, then time both like runCase()
+// false if the reference or the kernel doesn't take input
+bool verifyCase(const VerifyCase &c, const VerifyInput &input, const BenchOptions &options, VerifyResult &result);
+
+#endif // VERIFY_H
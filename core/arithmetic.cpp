@@ -0,0 +1,185 @@
+#include "arithmetic.h"
+#include "grayscale.h"
+#include "parallel.h"
+#include "resample.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+int minRows(const ImageView &img)
+{
+    return std::max(1, (1 << 16)/std::max(1, img.width()*img.channels()));
+}
+
+void checkSameSize(const ImageView &a, const ImageView &b, const char *what)
+{
+    if (a.width() != b.width() || a.height() != b.height() || a.channels() != b.channels()) {
+        throw std::invalid_argument(std::string(what) + ": images differ in size or channels");
+    }
+}
+
+// out[i] = op(a[i], b[i]) for every sample
+template<typename Op>
+Image combine(const ImageView &a, const ImageView &b, const char *what, Op op)
+{
+    checkSameSize(a, b, what);
+
+    Image dst(a.width(), a.height(), a.channels());
+    const int n = a.width()*a.channels();
+
+    parallelFor(0, a.height(), [&](int first, int last) {
+        std::vector<unsigned char> bufferA(a.isMirrored() ? n + 64 : 0);
+        std::vector<unsigned char> bufferB(b.isMirrored() ? n + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *inA = a.readRow(y, bufferA.data());
+            const unsigned char *inB = b.readRow(y, bufferB.data());
+            unsigned char *out = dst.scanLine(y);
+            for (int i = 0; i < n; ++i) {
+                out[i] = op(inA[i], inB[i]);
+            }
+        }
+    }, minRows(a));
+
+    return dst;
+}
+
+} // namespace
+
+Image conformTo(const ImageView &src, const ImageView &like)
+{
+    Image result = src.toImage();
+
+    if (result.width() != like.width() || result.height() != like.height()) {
+        result = resize(result, like.width(), like.height(), ResampleNearest);
+    }
+
+    if (result.channels() == like.channels()) {
+        return result;
+    }
+    if (result.isRGB() && like.isGrayscale()) {
+        return toGrayscale(result);
+    }
+    if (!result.isGrayscale()) {
+        throw std::invalid_argument("conformTo: can't convert the channels");
+    }
+
+    // gray to every channel
+    Image dst(like.width(), like.height(), like.channels());
+    const int c = like.channels();
+    parallelFor(0, dst.height(), [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            const unsigned char *in = result.scanLine(y);
+            unsigned char *out = dst.scanLine(y);
+            for (int x = 0; x < dst.width(); ++x) {
+                std::fill(out + x*c, out + (x + 1)*c, in[x]);
+            }
+        }
+    }, minRows(dst));
+
+    return dst;
+}
+
+Image addition(const ImageView &a, const ImageView &b)
+{
+    return combine(a, b, "addition", [](unsigned char x, unsigned char y) {
+        return static_cast<unsigned char>((x + y) >> 1);
+    });
+}
+
+Image subtraction(const ImageView &a, const ImageView &b)
+{
+    return combine(a, b, "subtraction", [](unsigned char x, unsigned char y) {
+        return static_cast<unsigned char>(x > y ? x - y : 0);
+    });
+}
+
+Image multiplication(const ImageView &a, const ImageView &b)
+{
+    return combine(a, b, "multiplication", [](unsigned char x, unsigned char y) {
+        return static_cast<unsigned char>(std::min(255, x*y));
+    });
+}
+
+Image division(const ImageView &a, const ImageView &b)
+{
+    checkSameSize(a, b, "division");
+
+    // range of the quotient first, then the normalization
+    float lo = std::numeric_limits<float>::max(), hi = -lo;
+    std::mutex mutex;
+    const int n = a.width()*a.channels();
+
+    parallelFor(0, a.height(), [&](int first, int last) {
+        std::vector<unsigned char> bufferA(a.isMirrored() ? n + 64 : 0);
+        std::vector<unsigned char> bufferB(b.isMirrored() ? n + 64 : 0);
+        float rowLo = std::numeric_limits<float>::max(), rowHi = -rowLo;
+        for (int y = first; y < last; ++y) {
+            const unsigned char *inA = a.readRow(y, bufferA.data());
+            const unsigned char *inB = b.readRow(y, bufferB.data());
+            for (int i = 0; i < n; ++i) {
+                float q = static_cast<float>(inA[i])/std::max<int>(1, inB[i]);
+                rowLo = std::min(rowLo, q);
+                rowHi = std::max(rowHi, q);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        lo = std::min(lo, rowLo);
+        hi = std::max(hi, rowHi);
+    }, minRows(a));
+
+    // like CImg<>::normalize, a constant image goes to 0
+    const float scale = hi > lo ? 255.0f/(hi - lo) : 0.0f;
+    return combine(a, b, "division", [lo, scale](unsigned char x, unsigned char y) {
+        return static_cast<unsigned char>((static_cast<float>(x)/std::max<int>(1, y) - lo)*scale + 0.5f);
+    });
+}
+
+bool isBinary(const ImageView &img)
+{
+    if (!img.isGrayscale()) {
+        return false;
+    }
+
+    std::vector<unsigned char> buffer(img.isMirrored() ? img.width() + 64 : 0);
+    for (int y = 0; y < img.height(); ++y) {
+        const unsigned char *in = img.readRow(y, buffer.data());
+        for (int x = 0; x < img.width(); ++x) {
+            if (in[x] != 0 && in[x] != 255) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+Image bitwiseAnd(const ImageView &a, const ImageView &b)
+{
+    return combine(a, b, "bitwiseAnd", [](unsigned char x, unsigned char y) {
+        return static_cast<unsigned char>(x & y);
+    });
+}
+
+Image bitwiseOr(const ImageView &a, const ImageView &b)
+{
+    return combine(a, b, "bitwiseOr", [](unsigned char x, unsigned char y) {
+        return static_cast<unsigned char>(x | y);
+    });
+}
+
+Image bitwiseXor(const ImageView &a, const ImageView &b)
+{
+    return combine(a, b, "bitwiseXor", [](unsigned char x, unsigned char y) {
+        return static_cast<unsigned char>(x ^ y);
+    });
+}
+
+} // namespace ipk
@@ -0,0 +1,33 @@
+#ifndef ARITHMETIC_H
+#define ARITHMETIC_H
+
+#include "image.h"
+
+namespace ipk {
+
+// pixel by pixel operations on two images of the same size and
+// number of channels, std::invalid_argument is thrown otherwise
+
+// src resized (nearest neighbour) and converted to the size and
+// channels of like, so it can be the second operand
+Image conformTo(const ImageView &src, const ImageView &like);
+
+// (a + b)/2, rounded down
+Image addition(const ImageView &a, const ImageView &b);
+// a - b, clamped to 0
+Image subtraction(const ImageView &a, const ImageView &b);
+// a*b, clamped to 255
+Image multiplication(const ImageView &a, const ImageView &b);
+// a/b, normalized to (0, 255), b = 0 counts as 1
+Image division(const ImageView &a, const ImageView &b);
+
+// grayscale image with nothing but 0 and 255
+bool isBinary(const ImageView &img);
+// logical operations, meant for binary images
+Image bitwiseAnd(const ImageView &a, const ImageView &b);
+Image bitwiseOr(const ImageView &a, const ImageView &b);
+Image bitwiseXor(const ImageView &a, const ImageView &b);
+
+} // namespace ipk
+
+#endif // ARITHMETIC_H
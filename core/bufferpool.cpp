@@ -0,0 +1,170 @@
+#include "bufferpool.h"
+#include "memory.h"
+#include <QtGlobal>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <new>
+
+#if defined(Q_OS_LINUX)
+#include <sys/mman.h>
+#endif
+
+namespace ipk {
+
+namespace {
+
+const std::size_t alignment = 64;
+const std::size_t hugePageSize = 2 << 20;
+
+struct Block
+{
+    void *data;
+    std::size_t bytes;
+};
+
+std::mutex poolMutex;
+// released blocks, the most recently released last
+std::list<Block> cached;
+std::size_t limit = std::size_t(1) << 30;
+bool useHugePages = false;
+BufferPoolStats stats = { 0, 0, 0, 0 };
+
+std::size_t roundUp(std::size_t bytes)
+{
+    return (std::max<std::size_t>(bytes, 1) + alignment - 1) & ~(alignment - 1);
+}
+
+// like the pixels of an Image, the original pointer right before the aligned one
+void *allocateBlock(std::size_t bytes, bool huge)
+{
+    void *raw = std::malloc(bytes + alignment + sizeof(void *));
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void *);
+    addr = (addr + alignment - 1) & ~(alignment - 1);
+    reinterpret_cast<void **>(addr)[-1] = raw;
+
+#if defined(Q_OS_LINUX) && defined(MADV_HUGEPAGE)
+    if (huge && bytes >= hugePageSize) {
+        // whole pages within the block, the kernel takes the 2 MB ones out of them
+        const std::uintptr_t page = 4096;
+        const std::uintptr_t first = (addr + page - 1) & ~(page - 1), last = (addr + bytes) & ~(page - 1);
+        madvise(reinterpret_cast<void *>(first), last - first, MADV_HUGEPAGE);
+    }
+#else
+    Q_UNUSED(huge);
+#endif
+
+    return reinterpret_cast<void *>(addr);
+}
+
+void freeBlock(void *data)
+{
+    std::free(reinterpret_cast<void **>(data)[-1]);
+}
+
+// with poolMutex held
+void evict(std::size_t keep)
+{
+    while (stats.cachedBytes > keep && !cached.empty()) {
+        freeBlock(cached.front().data);
+        stats.cachedBytes -= cached.front().bytes;
+        cached.pop_front();
+    }
+}
+
+} // namespace
+
+void *acquireBuffer(std::size_t bytes)
+{
+    const std::size_t size = roundUp(bytes);
+    void *data = nullptr;
+    bool huge = false;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        // the most recently released, its pages are the likeliest to be in cache
+        for (std::list<Block>::reverse_iterator i = cached.rbegin(); i != cached.rend(); ++i) {
+            if (i->bytes == size) {
+                data = i->data;
+                stats.cachedBytes -= size;
+                ++stats.reusedBlocks;
+                cached.erase(std::next(i).base());
+                break;
+            }
+        }
+        if (!data) {
+            ++stats.freshBlocks;
+            stats.freshBytes += size;
+            huge = useHugePages;
+        }
+    }
+
+    if (!data) {
+        data = allocateBlock(size, huge);
+        countAllocation(size);
+    }
+    countBuffer(size);
+    return data;
+}
+
+void releaseBuffer(void *block, std::size_t bytes)
+{
+    if (!block) {
+        return;
+    }
+
+    const std::size_t size = roundUp(bytes);
+    countRelease(size);
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (size > limit) {
+        freeBlock(block);
+        return;
+    }
+    cached.push_back({ block, size });
+    stats.cachedBytes += size;
+    evict(limit);
+}
+
+void setBufferPoolLimit(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    limit = bytes;
+    evict(limit);
+}
+
+std::size_t bufferPoolLimit()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return limit;
+}
+
+void trimBufferPool()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    evict(0);
+}
+
+void setHugePages(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    useHugePages = enabled;
+}
+
+bool hugePages()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return useHugePages;
+}
+
+BufferPoolStats bufferPoolStats()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return stats;
+}
+
+} // namespace ipk
@@ -0,0 +1,50 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ipk {
+
+// memory for the temporaries of the kernels, the planes of the frequency
+// domain ones mostly, see PooledPlane in frequency.h
+// released blocks are kept by size and handed out again to the next one
+// asking for that size, so a kernel run again at the same size allocates
+// nothing and touches no fresh pages
+// blocks start on a 64 bytes boundary, one pool for the whole process,
+// safe to use from any thread
+
+struct BufferPoolStats
+{
+    // allocated from the system
+    std::uint64_t freshBlocks;
+    std::uint64_t freshBytes;
+    // handed out again after a release
+    std::uint64_t reusedBlocks;
+    // held for reuse right now
+    std::uint64_t cachedBytes;
+};
+
+// at least bytes, counted by countBuffer() until released, see memory.h
+// throws std::bad_alloc
+void *acquireBuffer(std::size_t bytes);
+// bytes as given to acquireBuffer()
+void releaseBuffer(void *block, std::size_t bytes);
+
+// released blocks beyond that many bytes are freed, those released
+// longest ago first, 1 GB by default
+void setBufferPoolLimit(std::size_t bytes);
+std::size_t bufferPoolLimit();
+// free all the blocks held for reuse
+void trimBufferPool();
+
+// ask for transparent huge pages on blocks of 2 MB or more, fewer TLB
+// misses on the FFT passes, off by default, Linux only, ignored elsewhere
+void setHugePages(bool enabled);
+bool hugePages();
+
+BufferPoolStats bufferPoolStats();
+
+} // namespace ipk
+
+#endif // BUFFERPOOL_H
@@ -0,0 +1,102 @@
+#include "cimgconvert.h"
+#include "parallel.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace cimg_library;
+
+namespace ipk {
+
+namespace {
+
+template <typename T>
+void copyInto(const ImageView &src, CImg<T> &img)
+{
+    if (img.width() != src.width() || img.height() != src.height() || img.depth() != 1
+            || img.spectrum() != src.channels()) {
+        throw std::invalid_argument("toCImg: not the size of the image");
+    }
+
+    ScopedTimer timer("cimg conversion");
+    const int c = src.channels();
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<unsigned char> buffer(src.isMirrored() ? src.width()*c + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *in = src.readRow(y, buffer.data());
+            for (int k = 0; k < c; ++k) {
+                T *out = img.data(0, y, 0, k);
+                for (int x = 0; x < src.width(); ++x) {
+                    out[x] = in[x*c + k];
+                }
+            }
+        }
+    });
+}
+
+template <typename T>
+Image copyFrom(const CImg<T> &img)
+{
+    if (img.is_empty()) {
+        return Image();
+    }
+    if (img.depth() != 1 || img.spectrum() > 4) {
+        throw std::invalid_argument("fromCImg: not a 2D image of up to 4 channels");
+    }
+
+    ScopedTimer timer("cimg conversion");
+    const int c = img.spectrum();
+    Image dst(img.width(), img.height(), c);
+
+    parallelFor(0, img.height(), [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            unsigned char *out = dst.scanLine(y);
+            for (int k = 0; k < c; ++k) {
+                const T *in = img.data(0, y, 0, k);
+                for (int x = 0; x < img.width(); ++x) {
+                    // NaN ends up as 0
+                    const double sample = in[x];
+                    double value = sample > 0.0 ? std::min(255.0, sample) : 0.0;
+                    out[x*c + k] = static_cast<unsigned char>(value + 0.5);
+                }
+            }
+        }
+    });
+
+    return dst;
+}
+
+} // namespace
+
+CImg<double> toCImg(const ImageView &src)
+{
+    CImg<double> img(src.width(), src.height(), 1, src.channels());
+    countAllocation(img.size()*sizeof(double));
+    toCImg(src, img);
+
+    return img;
+}
+
+void toCImg(const ImageView &src, CImg<float> &img)
+{
+    copyInto(src, img);
+}
+
+void toCImg(const ImageView &src, CImg<double> &img)
+{
+    copyInto(src, img);
+}
+
+Image fromCImg(const CImg<float> &img)
+{
+    return copyFrom(img);
+}
+
+Image fromCImg(const CImg<double> &img)
+{
+    return copyFrom(img);
+}
+
+} // namespace ipk
@@ -0,0 +1,27 @@
+#ifndef CIMGCONVERT_H
+#define CIMGCONVERT_H
+
+#include "image.h"
+#include "CImg.h"
+
+namespace ipk {
+
+// the frequency domain kernels still compute on CImg<float> or
+// CImg<double>, these move pixels between the two layouts
+// CImg stores channels as planes, an Image interleaves them
+
+// one plane per channel, values in (0, 255)
+cimg_library::CImg<double> toCImg(const ImageView &src);
+// into dst, which has the size and channels of src already, a plane of
+// the buffer pool say
+// throws std::invalid_argument otherwise
+void toCImg(const ImageView &src, cimg_library::CImg<float> &dst);
+void toCImg(const ImageView &src, cimg_library::CImg<double> &dst);
+// rounded and clamped to (0, 255), one channel per plane
+// throws std::invalid_argument for more than 4 planes or a 3D image
+Image fromCImg(const cimg_library::CImg<float> &img);
+Image fromCImg(const cimg_library::CImg<double> &img);
+
+} // namespace ipk
+
+#endif // CIMGCONVERT_H
@@ -0,0 +1,276 @@
+#include "colortransform.h"
+#include "filters.h"
+#include "grayscale.h"
+#include "parallel.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace ipk {
+
+using namespace simd;
+
+namespace {
+
+// pixels converted at once, small enough to stay in L1 cache
+const int blockSize = 64;
+
+struct Block
+{
+    alignas(16) float r[blockSize];
+    alignas(16) float g[blockSize];
+    alignas(16) float b[blockSize];
+};
+
+// at least this many pixels per thread, otherwise threads cost more than they save
+int minRows(const ImageView &img)
+{
+    return std::max(1, (1 << 16)/std::max(1, img.width()));
+}
+
+// deinterleave n RGB pixels into blk, padding up to a multiple of 4
+void loadBlock(const unsigned char *src, int n, Block &blk)
+{
+    for (int i = 0; i < n; ++i) {
+        blk.r[i] = src[3*i];
+        blk.g[i] = src[3*i + 1];
+        blk.b[i] = src[3*i + 2];
+    }
+    for (int i = n; i < blockSize && (i & 3); ++i) {
+        blk.r[i] = blk.g[i] = blk.b[i] = 0.0f;
+    }
+}
+
+inline unsigned char toByte(float value)
+{
+    // clamp first, NaN turns to 0 here too
+    value = value > 0.0f ? value : 0.0f;
+    value = value < 255.0f ? value : 255.0f;
+    return static_cast<unsigned char>(value + 0.5f);
+}
+
+void storeBlock(const Block &blk, int n, unsigned char *dst)
+{
+    for (int i = 0; i < n; ++i) {
+        dst[3*i] = toByte(blk.r[i]);
+        dst[3*i + 1] = toByte(blk.g[i]);
+        dst[3*i + 2] = toByte(blk.b[i]);
+    }
+}
+
+// run transform(blk, n) over every block of every row of an RGB image
+// transform works in place on the deinterleaved block
+template<typename Transform>
+Image transformRGB(const ImageView &src, const Transform &transform)
+{
+    Image dst(src.width(), src.height(), src.channels());
+    const int width = src.width();
+
+    parallelFor(0, src.height(), [&](int first, int last) {
+        Block blk;
+        std::vector<unsigned char> buffer(src.isMirrored() ? 3*width + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *in = src.readRow(y, buffer.data());
+            unsigned char *out = dst.scanLine(y);
+            for (int x = 0; x < width; x += blockSize) {
+                int n = std::min(blockSize, width - x);
+                loadBlock(in + 3*x, n, blk);
+                transform(blk, n);
+                storeBlock(blk, n, out + 3*x);
+            }
+        }
+    }, minRows(src));
+
+    return dst;
+}
+
+// piecewise linear function through (0, 0), (r1, s1), (r2, s2) and (255, 255)
+// empty segments get a zero slope instead of a division by zero
+struct Piecewise
+{
+    float r1, s1, r2, s2;
+    float k1, k2, k3;
+
+    Piecewise(double r1, double s1, double r2, double s2) :
+        r1(r1), s1(s1), r2(r2), s2(s2)
+    {
+        k1 = r1 > 0 ? s1/r1 : 0;
+        k2 = r2 > r1 ? (s2 - s1)/(r2 - r1) : 0;
+        k3 = r2 < 255 ? (255 - s2)/(255 - r2) : 0;
+    }
+
+    float operator()(float r) const
+    {
+        if (r < r1) {
+            return k1*r;
+        } else if (r < r2) {
+            return k2*(r - r1) + s1;
+        } else {
+            return k3*(r - r2) + s2;
+        }
+    }
+
+    Float4 operator()(const Float4 &r) const
+    {
+        Float4 low = Float4(k1)*r;
+        Float4 middle = Float4(k2)*(r - Float4(r1)) + Float4(s1);
+        Float4 high = Float4(k3)*(r - Float4(r2)) + Float4(s2);
+        return select(less(r, Float4(r1)), low, select(less(r, Float4(r2)), middle, high));
+    }
+};
+
+} // namespace
+
+Image adjustHsv(const ImageView &src, int h, float s, float v)
+{
+    if (!src.isRGB()) {
+        throw std::invalid_argument("adjustHsv: not an RGB image");
+    }
+
+    // hue is kept in sextants (0, 6) rather than degree (0, 360)
+    const float dh = static_cast<float>(std::fmod(h, 360))/60.0f;
+
+    return transformRGB(src, [dh, s, v](Block &blk, int n) {
+        const Float4 zero(0.0f), one(1.0f), two(2.0f), four(4.0f), six(6.0f);
+        for (int i = 0; i < n; i += 4) {
+            Float4 r = load(blk.r + i), g = load(blk.g + i), b = load(blk.b + i);
+            // RGB to HSV
+            Float4 M = max(max(r, g), b);
+            Float4 m = min(min(r, g), b);
+            Float4 d = M - m;
+            Float4 gray = equal(d, zero);
+            Float4 dd = select(gray, one, d);
+            Float4 H = select(equal(M, r), (g - b)/dd,
+                              select(equal(M, g), (b - r)/dd + two, (r - g)/dd + four));
+            H = select(gray, zero, H);
+            Float4 S = select(equal(M, zero), zero, d/select(equal(M, zero), one, M));
+            // adjust, and wrap hue to (0, 6)
+            H = H + Float4(dh);
+            H = H - six*floor(H/six);
+            S = S*Float4(s);
+            Float4 V = M*Float4(v);
+            // HSV to RGB
+            // channel = V - V*S*clamp(min(k, 4 - k), 0, 1), with k = (n + H) mod 6
+            // where n = 5, 3, 1 for R, G, B
+            Float4 VS = V*S;
+            Float4 k;
+            k = H + Float4(5.0f);
+            k = select(less(k, six), k, k - six);
+            store(blk.r + i, V - VS*max(zero, min(one, min(k, four - k))));
+            k = H + Float4(3.0f);
+            k = select(less(k, six), k, k - six);
+            store(blk.g + i, V - VS*max(zero, min(one, min(k, four - k))));
+            k = H + one;
+            k = select(less(k, six), k, k - six);
+            store(blk.b + i, V - VS*max(zero, min(one, min(k, four - k))));
+        }
+    });
+}
+
+Image linearTransformation(const ImageView &src, double k, double b)
+{
+    if (src.isGrayscale()) {
+        unsigned char lut[256];
+        for (int i = 0; i < 256; ++i) {
+            lut[i] = toByte(static_cast<float>(i*k + b));
+        }
+        return applyLut(src, lut);
+    }
+
+    if (!src.isRGB()) {
+        throw std::invalid_argument("linearTransformation: neither grayscale nor RGB image");
+    }
+
+    // with H and S fixed, RGB is linear in V
+    // so scaling every channel by V'/V is the same as
+    // converting to HSV, mapping V, and converting back
+    // for black pixels, S = 0, and R = G = B = V'
+    const float kf = static_cast<float>(k), bf = static_cast<float>(b);
+
+    return transformRGB(src, [kf, bf](Block &blk, int n) {
+        const Float4 zero(0.0f), one(1.0f);
+        for (int i = 0; i < n; i += 4) {
+            Float4 r = load(blk.r + i), g = load(blk.g + i), b = load(blk.b + i);
+            Float4 V = max(max(r, g), b);
+            Float4 V2 = V*Float4(kf) + Float4(bf);
+            Float4 black = equal(V, zero);
+            Float4 ratio = V2/select(black, one, V);
+            store(blk.r + i, select(black, V2, r*ratio));
+            store(blk.g + i, select(black, V2, g*ratio));
+            store(blk.b + i, select(black, V2, b*ratio));
+        }
+    });
+}
+
+Image piecewiseLinearTransformation(const ImageView &src, double r1, double s1, double r2, double s2)
+{
+    const Piecewise f(r1, s1, r2, s2);
+
+    if (src.isGrayscale()) {
+        unsigned char lut[256];
+        for (int i = 0; i < 256; ++i) {
+            lut[i] = toByte(f(static_cast<float>(i)));
+        }
+        return applyLut(src, lut);
+    }
+
+    if (!src.isRGB()) {
+        throw std::invalid_argument("piecewiseLinearTransformation: neither grayscale nor RGB image");
+    }
+
+    // same YUV coefficients as CImg, but with Y in (0, 255)
+    return transformRGB(src, [&f](Block &blk, int n) {
+        for (int i = 0; i < n; i += 4) {
+            Float4 r = load(blk.r + i), g = load(blk.g + i), b = load(blk.b + i);
+            Float4 Y = Float4(0.299f)*r + Float4(0.587f)*g + Float4(0.114f)*b;
+            Float4 U = Float4(0.492f)*(b - Y);
+            Float4 V = Float4(0.877f)*(r - Y);
+            Y = f(Y);
+            store(blk.r + i, Y + Float4(1.140f)*V);
+            store(blk.g + i, Y - Float4(0.395f)*U - Float4(0.581f)*V);
+            store(blk.b + i, Y + Float4(2.032f)*U);
+        }
+    });
+}
+
+Image pseudocolor(const ImageView &src)
+{
+    if (!src.isGrayscale()) {
+        if (!src.isRGB()) {
+            throw std::invalid_argument("pseudocolor: neither grayscale nor RGB image");
+        }
+        return pseudocolor(toGrayscale(src));
+    }
+
+    // the slopes were always integer divisions, keep them that way
+    unsigned char lut[3][256];
+    for (int i = 0; i < 256; ++i) {
+        int r = i < 128 ? 0 : (i < 200 ? 255/128*(i - 128) : 255);
+        int g = i < 64 ? 255/64*i : (i < 200 ? 255 : -255/(255 - 200)*(i - 200) + 255);
+        int b = i < 64 ? 255 : (i < 128 ? -255/(128 - 64)*(i - 64) + 255 : 0);
+        lut[0][i] = static_cast<unsigned char>(r);
+        lut[1][i] = static_cast<unsigned char>(g);
+        lut[2][i] = static_cast<unsigned char>(b);
+    }
+
+    Image dst(src.width(), src.height(), 3);
+    const int width = src.width();
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<unsigned char> buffer(src.isMirrored() ? width + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *in = src.readRow(y, buffer.data());
+            unsigned char *out = dst.scanLine(y);
+            for (int x = 0; x < width; ++x) {
+                out[3*x] = lut[0][in[x]];
+                out[3*x + 1] = lut[1][in[x]];
+                out[3*x + 2] = lut[2][in[x]];
+            }
+        }
+    }, minRows(src));
+
+    return dst;
+}
+
+} // namespace ipk
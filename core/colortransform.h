@@ -0,0 +1,33 @@
+#ifndef COLORTRANSFORM_H
+#define COLORTRANSFORM_H
+
+#include "image.h"
+
+namespace ipk {
+
+// fused colour kernels
+// each one reads an interleaved 8-bit row, converts it to HSV or YUV
+// in registers, adjusts it and converts it back in a single pass,
+// no full size floating point copy of the image is made
+//
+// grayscale images are transformed through a 256 entries lookup table
+
+// rotate hue by h degree, scale saturation by s and value by v
+// RGB image only, throws std::invalid_argument otherwise
+Image adjustHsv(const ImageView &src, int h, float s, float v);
+
+// s = k*r + b, r and s in (0, 255)
+// for RGB image, apply to V of HSV, where V = max(R, G, B)
+Image linearTransformation(const ImageView &src, double k, double b);
+
+// piecewise linear transformation through (r1, s1) and (r2, s2)
+// r and s in (0, 255)
+// for RGB image, apply to Y of YUV, where Y is in (0, 255) too
+Image piecewiseLinearTransformation(const ImageView &src, double r1, double s1, double r2, double s2);
+
+// map gray levels to colours, RGB images are converted to gray first
+Image pseudocolor(const ImageView &src);
+
+} // namespace ipk
+
+#endif // COLORTRANSFORM_H
@@ -0,0 +1,70 @@
+#-------------------------------------------------
+#
+# image processing kernels, no widgets here
+# QtGui is only used to read and write image files
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = ipkcore
+TEMPLATE = lib
+CONFIG += staticlib c++11
+
+DEFINES += QT_DEPRECATED_WARNINGS
+# CImg is only used for computation here, never for display
+DEFINES += cimg_display=0
+
+SOURCES += \
+    image.cpp \
+    parallel.cpp \
+    profiler.cpp \
+    memory.cpp \
+    bufferpool.cpp \
+    trace.cpp \
+    colortransform.cpp \
+    grayscale.cpp \
+    resample.cpp \
+    warp.cpp \
+    filters.cpp \
+    imageio.cpp \
+    operations.cpp \
+    pipeline.cpp \
+    pipelinecache.cpp \
+    history.cpp \
+    pyramid.cpp \
+    mappedimage.cpp \
+    tiled.cpp \
+    synthetic.cpp \
+    cimgconvert.cpp \
+    frequency.cpp \
+    histogram.cpp \
+    arithmetic.cpp
+
+HEADERS += \
+    CImg.h \
+    image.h \
+    parallel.h \
+    profiler.h \
+    memory.h \
+    bufferpool.h \
+    trace.h \
+    simd.h \
+    colortransform.h \
+    grayscale.h \
+    resample.h \
+    warp.h \
+    filters.h \
+    imageio.h \
+    operations.h \
+    pipeline.h \
+    pipelinecache.h \
+    history.h \
+    pyramid.h \
+    mappedimage.h \
+    tiled.h \
+    synthetic.h \
+    cimgconvert.h \
+    frequency.h \
+    histogram.h \
+    arithmetic.h
@@ -0,0 +1,523 @@
+#include "filters.h"
+#include "parallel.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+// at least this many pixels per thread, otherwise threads cost more than they save
+int minRows(const ImageView &img)
+{
+    return std::max(1, (1 << 16)/std::max(1, img.width()*img.channels()));
+}
+
+void checkSize(int size, const char *what)
+{
+    if (size < 1) {
+        throw std::invalid_argument(std::string(what) + ": window size must be at least 1");
+    }
+}
+
+inline int clampRow(const ImageView &src, int y)
+{
+    return std::min(src.height() - 1, std::max(0, y));
+}
+
+// row y of src, clamped to the image, with left and right more pixels
+// repeating the edge pixels, written to out
+void paddedRow(const ImageView &src, int y, int left, int right, unsigned char *out)
+{
+    const int c = src.channels();
+    const std::size_t rowSize = static_cast<std::size_t>(src.width())*c;
+    unsigned char *middle = out + left*c;
+
+    const unsigned char *row = src.readRow(clampRow(src, y), middle);
+    if (row != middle) {
+        std::memcpy(middle, row, rowSize);
+    }
+    for (int i = 0; i < left; ++i) {
+        std::memcpy(out + i*c, middle, c);
+    }
+    for (int i = 0; i < right; ++i) {
+        std::memcpy(middle + rowSize + i*c, middle + rowSize - c, c);
+    }
+}
+
+inline unsigned char toByte(float value)
+{
+    return static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, value)) + 0.5f);
+}
+
+// out = max(out, in) or min(out, in), n samples
+template<bool isMax>
+inline void rankRow(unsigned char *out, const unsigned char *in, int n)
+{
+    int i = 0;
+#ifdef IPK_SSE2
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        a = isMax ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), a);
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = isMax ? (in[i] > out[i] ? in[i] : out[i]) : (in[i] < out[i] ? in[i] : out[i]);
+    }
+}
+
+// separable min or max over a size x size window
+// both passes are elementwise min/max of shifted rows
+template<bool isMax>
+Image rankFilter(const ImageView &src, int size)
+{
+    const int c = src.channels();
+    const int n = src.width()*c;
+    const int left = size - size/2 - 1, right = size/2;
+    Image tmp(src.width(), src.height(), c);
+    Image dst(src.width(), src.height(), c);
+
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<unsigned char> row((src.width() + size)*c + 64);
+        for (int y = first; y < last; ++y) {
+            paddedRow(src, y, left, right, row.data());
+            unsigned char *out = tmp.scanLine(y);
+            std::memcpy(out, row.data(), n);
+            for (int k = 1; k < size; ++k) {
+                rankRow<isMax>(out, row.data() + k*c, n);
+            }
+        }
+    }, minRows(src));
+
+    const ImageView rows(tmp);
+    parallelFor(0, src.height(), [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            unsigned char *out = dst.scanLine(y);
+            std::memcpy(out, rows.scanLine(clampRow(rows, y - left)), n);
+            for (int k = 1; k < size; ++k) {
+                rankRow<isMax>(out, rows.scanLine(clampRow(rows, y - left + k)), n);
+            }
+        }
+    }, minRows(src));
+
+    return dst;
+}
+
+// min (erosion) or max (dilation) over the taps of a 3x3 structure element
+// taps are (dx, dy) offsets, in -1..1
+template<bool isMax>
+Image morphology(const ImageView &src, const std::vector<std::pair<int, int> > &taps)
+{
+    const int c = src.channels();
+    const int n = src.width()*c;
+    Image dst(src.width(), src.height(), c);
+
+    parallelFor(0, src.height(), [&](int first, int last) {
+        const std::size_t padded = (src.width() + 2)*c + 64;
+        std::vector<unsigned char> rows(3*padded);
+        for (int y = first; y < last; ++y) {
+            for (int k = 0; k < 3; ++k) {
+                paddedRow(src, y + k - 1, 1, 1, &rows[k*padded]);
+            }
+            unsigned char *out = dst.scanLine(y);
+            std::memset(out, isMax ? 0 : 255, n);
+            for (const auto &tap : taps) {
+                rankRow<isMax>(out, &rows[(tap.second + 1)*padded] + (tap.first + 1)*c, n);
+            }
+        }
+    }, minRows(src));
+
+    return dst;
+}
+
+// correlation with a 3x3 kernel, given row by row
+Image filter3x3(const ImageView &src, const float weights[9])
+{
+    const int c = src.channels();
+    const int n = src.width()*c;
+    Image dst(src.width(), src.height(), c);
+
+    parallelFor(0, src.height(), [&](int first, int last) {
+        const std::size_t padded = (src.width() + 2)*c + 64;
+        std::vector<unsigned char> rows(3*padded);
+        std::vector<float> acc(n);
+        for (int y = first; y < last; ++y) {
+            for (int k = 0; k < 3; ++k) {
+                paddedRow(src, y + k - 1, 1, 1, &rows[k*padded]);
+            }
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            for (int k = 0; k < 9; ++k) {
+                float w = weights[k];
+                if (w == 0.0f) {
+                    continue;
+                }
+                const unsigned char *in = &rows[(k/3)*padded] + (k % 3)*c;
+                for (int i = 0; i < n; ++i) {
+                    acc[i] += w*in[i];
+                }
+            }
+            unsigned char *out = dst.scanLine(y);
+            for (int i = 0; i < n; ++i) {
+                out[i] = toByte(acc[i]);
+            }
+        }
+    }, minRows(src));
+
+    return dst;
+}
+
+// k-th smallest value, 0 based, counted in hist, with coarse bins of 16 values
+inline int kthValue(const std::uint32_t *hist, const std::uint32_t *coarse, std::uint32_t k)
+{
+    int bin = 0;
+    while (coarse[bin] <= k) {
+        k -= coarse[bin++];
+    }
+    int value = bin*16;
+    while (hist[value] <= k) {
+        k -= hist[value++];
+    }
+
+    return value;
+}
+
+} // namespace
+
+Image averageFilter(const ImageView &src, int size)
+{
+    checkSize(size, "averageFilter");
+
+    const int c = src.channels();
+    const int n = src.width()*c;
+    const int left = size - size/2 - 1, right = size/2;
+    const std::uint32_t area = static_cast<std::uint32_t>(size)*size;
+    // exact for the sums at hand, and much cheaper than a division
+    const double invArea = (1.0 + 1e-12)/area;
+    Image dst(src.width(), src.height(), c);
+
+    // running sums, down the columns and then along the row
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<std::uint32_t> columns(n, 0);
+        std::vector<std::uint32_t> prefix((src.width() + size)*c);
+        std::vector<unsigned char> buffer(src.isMirrored() ? n + 64 : 0);
+        for (int k = -left; k <= right; ++k) {
+            const unsigned char *in = src.readRow(clampRow(src, first + k), buffer.data());
+            for (int i = 0; i < n; ++i) {
+                columns[i] += in[i];
+            }
+        }
+        for (int y = first; y < last; ++y) {
+            // prefix sums along the row, edge columns repeated,
+            // so a window sum is a single subtraction
+            std::uint32_t *p = prefix.data();
+            std::fill(p, p + c, 0);
+            for (int x = -left; x < src.width() + right; ++x, p += c) {
+                const std::uint32_t *column = &columns[std::min(src.width() - 1, std::max(0, x))*c];
+                for (int ch = 0; ch < c; ++ch) {
+                    p[c + ch] = p[ch] + column[ch];
+                }
+            }
+            unsigned char *out = dst.scanLine(y);
+            const std::uint32_t *lo = prefix.data(), *hi = prefix.data() + size*c;
+            for (int i = 0; i < n; ++i) {
+                out[i] = static_cast<unsigned char>((hi[i] - lo[i] + area/2)*invArea);
+            }
+            if (y + 1 < last) {
+                const unsigned char *in = src.readRow(clampRow(src, y - left), buffer.data());
+                for (int i = 0; i < n; ++i) {
+                    columns[i] -= in[i];
+                }
+                in = src.readRow(clampRow(src, y + right + 1), buffer.data());
+                for (int i = 0; i < n; ++i) {
+                    columns[i] += in[i];
+                }
+            }
+        }
+    }, minRows(src));
+
+    return dst;
+}
+
+// Huang's sliding histogram, one column in and one out per pixel
+Image medianFilter(const ImageView &src, int size)
+{
+    checkSize(size, "medianFilter");
+
+    if (size == 1) {
+        return src.toImage();
+    }
+    if (src.isMirrored()) {
+        // columns are read one pixel at a time, a plain copy is simpler
+        return medianFilter(src.toImage(), size);
+    }
+
+    const int w = src.width(), h = src.height(), c = src.channels();
+    const int left = size - size/2 - 1, right = size/2;
+    Image dst(w, h, c);
+
+    parallelFor(0, h, [&](int first, int last) {
+        std::vector<std::uint32_t> hist(256*c), coarse(16*c);
+        for (int y = first; y < last; ++y) {
+            const int y0 = std::max(0, y - left), y1 = std::min(h - 1, y + right);
+            auto addColumn = [&](int x, int sign) {
+                for (int yy = y0; yy <= y1; ++yy) {
+                    const unsigned char *p = src.scanLine(yy) + x*c;
+                    for (int ch = 0; ch < c; ++ch) {
+                        hist[ch*256 + p[ch]] += sign;
+                        coarse[ch*16 + (p[ch] >> 4)] += sign;
+                    }
+                }
+            };
+
+            std::fill(hist.begin(), hist.end(), 0);
+            std::fill(coarse.begin(), coarse.end(), 0);
+            for (int x = 0; x <= std::min(w - 1, right); ++x) {
+                addColumn(x, 1);
+            }
+
+            unsigned char *out = dst.scanLine(y);
+            for (int x = 0; x < w; ++x) {
+                const int x0 = std::max(0, x - left), x1 = std::min(w - 1, x + right);
+                const std::uint32_t count = static_cast<std::uint32_t>(y1 - y0 + 1)*(x1 - x0 + 1);
+                for (int ch = 0; ch < c; ++ch) {
+                    const std::uint32_t *hc = &hist[ch*256], *cc = &coarse[ch*16];
+                    int value = kthValue(hc, cc, count/2);
+                    if (count % 2 == 0) {
+                        // average of the two middle values
+                        value = (kthValue(hc, cc, count/2 - 1) + value + 1)/2;
+                    }
+                    out[x*c + ch] = static_cast<unsigned char>(value);
+                }
+                if (x - left >= 0) {
+                    addColumn(x - left, -1);
+                }
+                if (x + right + 1 < w) {
+                    addColumn(x + right + 1, 1);
+                }
+            }
+        }
+    }, std::max(1, (1 << 12)/std::max(1, w)));
+
+    return dst;
+}
+
+Image maximumFilter(const ImageView &src, int size)
+{
+    checkSize(size, "maximumFilter");
+    return rankFilter<true>(src, size);
+}
+
+Image minimumFilter(const ImageView &src, int size)
+{
+    checkSize(size, "minimumFilter");
+    return rankFilter<false>(src, size);
+}
+
+Image customFilter(const ImageView &src, const int weights[9])
+{
+    // convolution, so the kernel is mirrored
+    // if the weights add up to something positive, divide by 9
+    int sum = 0;
+    for (int k = 0; k < 9; ++k) {
+        sum += weights[k];
+    }
+    const float scale = sum > 0 ? 1.0f/9.0f : 1.0f;
+
+    float kernel[9];
+    for (int k = 0; k < 9; ++k) {
+        kernel[8 - k] = weights[k]*scale;
+    }
+
+    return filter3x3(src, kernel);
+}
+
+Image laplacianFilter(const ImageView &src)
+{
+    // src + 0.5*(north + south + east + west - 4*src)
+    const float kernel[9] = { 0.0f, 0.5f, 0.0f, 0.5f, -1.0f, 0.5f, 0.0f, 0.5f, 0.0f };
+    return filter3x3(src, kernel);
+}
+
+Image applyLut(const ImageView &src, const unsigned char lut[256])
+{
+    Image dst(src.width(), src.height(), src.channels());
+    const int n = src.width()*src.channels();
+
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<unsigned char> buffer(src.isMirrored() ? n + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *in = src.readRow(y, buffer.data());
+            unsigned char *out = dst.scanLine(y);
+            for (int i = 0; i < n; ++i) {
+                out[i] = lut[in[i]];
+            }
+        }
+    }, minRows(src));
+
+    return dst;
+}
+
+Image negative(const ImageView &src)
+{
+    unsigned char lut[256];
+    for (int i = 0; i < 256; ++i) {
+        lut[i] = static_cast<unsigned char>(255 - i);
+    }
+
+    return applyLut(src, lut);
+}
+
+Image threshold(const ImageView &src, int threshold)
+{
+    if (!src.isGrayscale()) {
+        throw std::invalid_argument("threshold: not a grayscale image");
+    }
+
+    unsigned char lut[256];
+    for (int i = 0; i < 256; ++i) {
+        lut[i] = i <= threshold ? 0 : 255;
+    }
+
+    return applyLut(src, lut);
+}
+
+int otsuThreshold(const ImageView &src)
+{
+    if (!src.isGrayscale()) {
+        throw std::invalid_argument("otsuThreshold: not a grayscale image");
+    }
+
+    std::vector<double> hist(256, 0.0);
+    std::vector<unsigned char> buffer(src.isMirrored() ? src.width() + 64 : 0);
+    for (int y = 0; y < src.height(); ++y) {
+        const unsigned char *in = src.readRow(y, buffer.data());
+        for (int x = 0; x < src.width(); ++x) {
+            hist[in[x]] += 1.0;
+        }
+    }
+
+    double total = 0.0, sum = 0.0;
+    for (int i = 0; i < 256; ++i) {
+        total += hist[i];
+        sum += i*hist[i];
+    }
+
+    // background is (0, t), foreground is (t + 1, 255)
+    double w0 = 0.0, sum0 = 0.0, best = -1.0;
+    int result = 0;
+    for (int t = 0; t < 256; ++t) {
+        w0 += hist[t];
+        sum0 += t*hist[t];
+        double w1 = total - w0;
+        if (w0 == 0.0) {
+            continue;
+        }
+        if (w1 == 0.0) {
+            break;
+        }
+        double d = sum0/w0 - (sum - sum0)/w1;
+        double sigma = w0*w1*d*d;
+        if (sigma > best) {
+            best = sigma;
+            result = t;
+        }
+    }
+
+    return result;
+}
+
+Image regionGrowth(const ImageView &src, int x, int y, int threshold)
+{
+    if (!src.isGrayscale()) {
+        throw std::invalid_argument("regionGrowth: not a grayscale image");
+    }
+    if (x < 0 || x >= src.width() || y < 0 || y >= src.height()) {
+        throw std::invalid_argument("regionGrowth: seed outside the image");
+    }
+
+    const int w = src.width(), h = src.height();
+    Image img = src.toImage();
+    Image result(w, h, 1);
+    for (int j = 0; j < h; ++j) {
+        std::memset(result.scanLine(j), 255, w);
+    }
+
+    std::vector<std::pair<int, int> > seeds;
+    seeds.push_back(std::make_pair(x, y));
+    result.scanLine(y)[x] = 0;
+
+    while (!seeds.empty()) {
+        const int cx = seeds.back().first, cy = seeds.back().second;
+        seeds.pop_back();
+        const int value = img.scanLine(cy)[cx];
+        for (int j = std::max(0, cy - 1); j <= std::min(h - 1, cy + 1); ++j) {
+            for (int i = std::max(0, cx - 1); i <= std::min(w - 1, cx + 1); ++i) {
+                if (result.scanLine(j)[i] != 0 && std::abs(img.scanLine(j)[i] - value) < threshold) {
+                    result.scanLine(j)[i] = 0;
+                    seeds.push_back(std::make_pair(i, j));
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+Image erode(const ImageView &src, const unsigned char element[9])
+{
+    std::vector<std::pair<int, int> > taps;
+    for (int k = 0; k < 9; ++k) {
+        if (element[k]) {
+            taps.push_back(std::make_pair(k % 3 - 1, k/3 - 1));
+        }
+    }
+
+    // an empty element erodes everything
+    if (taps.empty()) {
+        Image dst(src.width(), src.height(), src.channels());
+        if (!dst.isNull()) {
+            std::memset(dst.bits(), 0, dst.byteCount());
+        }
+        return dst;
+    }
+
+    return morphology<false>(src, taps);
+}
+
+Image dilate(const ImageView &src, const unsigned char element[9])
+{
+    // the element is mirrored, so that dilation and erosion are dual
+    std::vector<std::pair<int, int> > taps;
+    for (int k = 0; k < 9; ++k) {
+        if (element[k]) {
+            taps.push_back(std::make_pair(1 - k % 3, 1 - k/3));
+        }
+    }
+
+    if (taps.empty()) {
+        return src.toImage();
+    }
+
+    return morphology<true>(src, taps);
+}
+
+Image opening(const ImageView &src, const unsigned char element[9])
+{
+    return dilate(erode(src, element), element);
+}
+
+Image closing(const ImageView &src, const unsigned char element[9])
+{
+    return erode(dilate(src, element), element);
+}
+
+} // namespace ipk
@@ -0,0 +1,48 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include "image.h"
+
+namespace ipk {
+
+// spatial filters, point operations and morphology on 8-bit images
+// every channel is filtered on its own
+// windows of even size reach one more pixel to the right and below,
+// pixels outside the image repeat the nearest edge pixel, except for
+// the median, whose window is clipped to the image, like CImg does
+// sizes below 1 throw std::invalid_argument
+
+Image averageFilter(const ImageView &src, int size);
+Image medianFilter(const ImageView &src, int size);
+Image maximumFilter(const ImageView &src, int size);
+Image minimumFilter(const ImageView &src, int size);
+
+// 3x3 convolution, weights given row by row
+// weights are divided by 9, unless they sum to zero or less
+Image customFilter(const ImageView &src, const int weights[9]);
+// src + 0.5*laplacian(src)
+Image laplacianFilter(const ImageView &src);
+
+// map every sample through lut, whatever the number of channels
+Image applyLut(const ImageView &src, const unsigned char lut[256]);
+Image negative(const ImageView &src);
+
+// grayscale image only, throw std::invalid_argument otherwise
+// 0 up to threshold, 255 above
+Image threshold(const ImageView &src, int threshold);
+// threshold maximizing the between class variance
+int otsuThreshold(const ImageView &src);
+// 0 for the 8-connected region grown from (x, y), 255 elsewhere
+// a neighbour joins when it differs from the pixel it was reached from
+// by less than threshold, (x, y) must be inside the image
+Image regionGrowth(const ImageView &src, int x, int y, int threshold);
+
+// morphology with a 3x3 binary structure element, given row by row
+Image erode(const ImageView &src, const unsigned char element[9]);
+Image dilate(const ImageView &src, const unsigned char element[9]);
+Image opening(const ImageView &src, const unsigned char element[9]);
+Image closing(const ImageView &src, const unsigned char element[9]);
+
+} // namespace ipk
+
+#endif // FILTERS_H
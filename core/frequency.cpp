@@ -0,0 +1,531 @@
+#include "frequency.h"
+#include "bufferpool.h"
+#include "cimgconvert.h"
+#include "parallel.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace cimg_library;
+
+namespace ipk {
+
+namespace {
+
+std::atomic<int> precision(FftFloat);
+
+inline bool singlePrecision()
+{
+    return precision.load(std::memory_order_relaxed) == FftFloat;
+}
+
+template <typename T>
+BasicPooledPlane<T> toPlane(const ImageView &src)
+{
+    BasicPooledPlane<T> img(src.width(), src.height(), src.channels());
+    toCImg(src, *img);
+    return img;
+}
+
+void requireGrayscale(const ImageView &src, const char *what)
+{
+    if (!src.isGrayscale()) {
+        throw std::invalid_argument(std::string(what) + ": not a grayscale image");
+    }
+}
+
+template <typename T>
+Image normalized(CImg<T> &img)
+{
+    img.normalize(0, 255);
+    return fromCImg(img);
+}
+
+// pixels of a channel
+template <typename T>
+inline std::size_t planeSize(const CImg<T> &img)
+{
+    return static_cast<std::size_t>(img.width())*img.height();
+}
+
+template <typename T>
+inline T logMagnitudeOf(T re, T im)
+{
+    return std::log(1 + std::sqrt(std::log(1 + std::sqrt(re*re + im*im))));
+}
+
+template <typename T>
+inline std::complex<T> magnitudeOnly(const std::complex<T> &v)
+{
+    return std::polar(std::abs(v), T(1));
+}
+
+template <typename T>
+inline std::complex<T> phaseOnly(const std::complex<T> &v)
+{
+    return std::polar(T(1), std::arg(v));
+}
+
+// out = op(in) for every frequency, in and out may be the same
+template <typename T, typename Op>
+void mapSpectrum(const BasicSpectrum<T> &in, const BasicSpectrum<T> &out, Op op)
+{
+    const T *inr = in[0].data(), *ini = in[1].data();
+    T *outr = out[0].data(), *outi = out[1].data();
+    for (std::size_t i = 0; i < in[0].size(); ++i) {
+        const std::complex<T> value = op(std::complex<T>(inr[i], ini[i]));
+        outr[i] = value.real();
+        outi[i] = value.imag();
+    }
+}
+
+// what get_shift(dx, dy, 0, 0, 2) gives, into dst of the same size
+// dst(x, y) = src((x - dx) mod width, (y - dy) mod height)
+template <typename T>
+void shiftInto(const CImg<T> &src, CImg<T> &dst, int dx, int dy)
+{
+    const int w = src.width(), h = src.height();
+    dx = ((dx % w) + w) % w;
+    dy = ((dy % h) + h) % h;
+    cimg_forC(src, c) {
+        for (int y = 0; y < h; ++y) {
+            const T *in = src.data(0, (y - dy + h) % h, 0, c);
+            T *out = dst.data(0, y, 0, c);
+            std::memcpy(out + dx, in, (w - dx)*sizeof(T));
+            std::memcpy(out, in + w - dx, dx*sizeof(T));
+        }
+    }
+}
+
+// what src.get_convolve(psf) gives, into dst of the same size, CImg
+// would allocate a new image for the result every time
+// Neumann boundaries, and the kernel reversed and centred like CImg does
+// it, the sums are in the same order too, so the results are identical
+// channels of dst only, src might have more
+template <typename T>
+void convolveInto(const CImg<T> &src, const Plane &psf, CImg<T> &dst)
+{
+    ScopedTimer timer("convolve");
+    const int w = src.width(), h = src.height();
+    const int kw = psf.width(), kh = psf.height();
+    const int left = kw/2, top = kh/2;
+    // the kernel in the precision of the planes
+    const CImg<T> K(psf);
+
+    parallelFor(0, h, [&](int first, int last) {
+        cimg_forC(dst, c) {
+            for (int y = first; y < last; ++y) {
+                T *out = dst.data(0, y, 0, c);
+                for (int x = 0; x < w; ++x) {
+                    T value = 0;
+                    for (int j = 0; j < kh; ++j) {
+                        const T *in = src.data(0, std::min(std::max(y + j - top, 0), h - 1), 0, c);
+                        const T *k = K.data(kw - 1, kh - 1 - j);
+                        for (int i = 0; i < kw; ++i) {
+                            value += in[std::min(std::max(x + i - left, 0), w - 1)]*k[-i];
+                        }
+                    }
+                    out[x] = value;
+                }
+            }
+        }
+    }, 16);
+}
+
+// all the transforms go through these, in place
+template <typename T>
+void forwardFFT(CImg<T> &re, CImg<T> &im)
+{
+    ScopedTimer timer("fft");
+    CImg<T>::FFT(re, im, false);
+}
+
+template <typename T>
+void inverseFFT(CImg<T> &re, CImg<T> &im)
+{
+    ScopedTimer timer("fft");
+    CImg<T>::FFT(re, im, true);
+}
+
+template <typename T>
+void forwardFFT(BasicSpectrum<T> &F)
+{
+    forwardFFT(F[0], F[1]);
+}
+
+template <typename T>
+void inverseFFT(BasicSpectrum<T> &F)
+{
+    inverseFFT(F[0], F[1]);
+}
+
+// src as a complex image, not transformed yet
+template <typename T>
+BasicSpectrum<T> toSpectrum(const ImageView &src)
+{
+    BasicSpectrum<T> F(src.width(), src.height(), src.channels());
+    toCImg(src, F[0]);
+    F[1].fill(0);
+    return F;
+}
+
+template <typename T>
+BasicSpectrum<T> forwardFFT(const ImageView &src)
+{
+    BasicSpectrum<T> F = toSpectrum<T>(src);
+    forwardFFT(F);
+    return F;
+}
+
+template <typename T>
+BasicSpectrum<T> otf(const Plane &psf, int width, int height)
+{
+    // what psf.get_resize(width, height, 1, 1, 0) gives, zeros right and below
+    BasicSpectrum<T> H(width, height);
+    H[0].fill(0);
+    H[1].fill(0);
+    for (int y = 0; y < std::min(height, psf.height()); ++y) {
+        std::copy(psf.data(0, y), psf.data(0, y) + std::min(width, psf.width()), H[0].data(0, y));
+    }
+    forwardFFT(H);
+
+    return H;
+}
+
+// the kernels keep one spectrum and work on it in place, the transfer
+// functions are evaluated on the fly rather than kept as planes
+// the spectrum isn't centred, so frequency (x, y) is at ((x + w/2) mod w,
+// (y + h/2) mod h) once centred, that's the same as shifting, filtering
+// and shifting back, the sizes CImg transforms are even or 1
+
+// offset from the centre of the centred spectrum
+inline int centredOffset(int x, int size)
+{
+    return (x + size/2) % size - size/2;
+}
+
+// F *= H(D^2), with H real and D the distance from the centre
+template <typename T, typename Transfer>
+void filterCentred(const BasicSpectrum<T> &F, Transfer H)
+{
+    CImg<T> &re = F[0], &im = F[1];
+    for (int y = 0; y < re.height(); ++y) {
+        const int dy = centredOffset(y, re.height());
+        for (int x = 0; x < re.width(); ++x) {
+            const int dx = centredOffset(x, re.width());
+            const T value = static_cast<T>(H(dx*dx + dy*dy));
+            cimg_forC(re, c) {
+                re(x, y, 0, c) *= value;
+                im(x, y, 0, c) *= value;
+            }
+        }
+    }
+}
+
+template <typename T>
+void addNoise(CImg<T> &img, NoiseType noise, double variance)
+{
+    if (noise == NoiseGaussian) {
+        img.noise(variance);
+    } else if (noise != NoiseNone) {
+        throw std::invalid_argument("unknown noise type");
+    }
+}
+
+// the image level kernels in either precision, see the public ones below
+
+template <typename T, typename Transfer>
+Image filtered(const ImageView &src, Transfer H)
+{
+    BasicSpectrum<T> F = forwardFFT<T>(src);
+    filterCentred(F, H);
+    inverseFFT(F);
+
+    return normalized(F[0]);
+}
+
+template <typename T>
+Image homomorphic(const ImageView &src, double gammaL, double gammaH, double c, int D0)
+{
+    BasicSpectrum<T> F = toSpectrum<T>(src);
+    // img's gray level might be 0, which make it no sence
+    // so add 1 before log
+    cimg_for(F[0], p, T) {
+        *p = std::log(1 + *p);
+    }
+    forwardFFT(F);
+    filterCentred(F, [=](int d2) {
+        double D = std::sqrt(static_cast<double>(d2));
+        return (gammaH - gammaL)*(1 - std::exp(-c*(D/D0)*(D/D0))) + gammaL;
+    });
+    inverseFFT(F);
+
+    // only the real part matters, ignore imag part
+    F[0].exp() -= 1;
+    return normalized(F[0]);
+}
+
+template <typename T>
+Image centredSpectrum(const ImageView &src)
+{
+    BasicSpectrum<T> F = forwardFFT<T>(src);
+    // the log magnitude into the real part, then centred into the imaginary one
+    std::transform(F[0].begin(), F[0].end(), F[1].begin(), F[0].begin(), logMagnitudeOf<T>);
+    F[0].normalize(0, 255);
+    shiftInto(F[0], F[1], F[0].width()/2, F[0].height()/2);
+
+    return fromCImg(F[1]);
+}
+
+template <typename T>
+Image inverse(const ImageView &src, NoiseType noise, int D0, double variance, int length, int angle)
+{
+    const Plane psf = motionBlurPsf(length, angle);
+    // src goes into the imaginary part, to be blurred into the real one
+    BasicSpectrum<T> F(src.width(), src.height(), src.channels());
+    toCImg(src, F[1]);
+    convolveInto(F[1], psf, F[0]);
+    F[0].normalize(0, 255);
+    addNoise(F[0], noise, variance);
+    F[1].fill(0);
+    forwardFFT(F);
+
+    // F/H within D0 of the centre, tiny values of H replaced by sqrt(DBL_EPSILON)
+    const BasicSpectrum<T> H = otf<T>(psf, F[0].width(), F[0].height());
+    const double eps = std::sqrt(DBL_EPSILON);
+    for (int y = 0; y < F[0].height(); ++y) {
+        const int dy = centredOffset(y, F[0].height());
+        for (int x = 0; x < F[0].width(); ++x) {
+            const int dx = centredOffset(x, F[0].width());
+            if (std::sqrt(static_cast<double>(dx*dx + dy*dy)) > D0) {
+                continue;
+            }
+            std::complex<T> d(H[0](x, y), H[1](x, y));
+            d = std::abs(d) > eps ? d : std::complex<T>(static_cast<T>(eps));
+            cimg_forC(F[0], c) {
+                const std::complex<T> value = std::complex<T>(F[0](x, y, 0, c), F[1](x, y, 0, c))/d;
+                F[0](x, y, 0, c) = value.real();
+                F[1](x, y, 0, c) = value.imag();
+            }
+        }
+    }
+    inverseFFT(F);
+
+    return normalized(F[0]);
+}
+
+template <typename T>
+Image wiener(const ImageView &src, NoiseType noise, double variance, int length, int angle, double k)
+{
+    const Plane psf = motionBlurPsf(length, angle);
+    // blurred like inverse(), noise added to every channel, as it always was
+    BasicSpectrum<T> G(src.width(), src.height(), src.channels());
+    toCImg(src, G[1]);
+    convolveInto(G[1], psf, G[0]);
+    addNoise(G[0], noise, variance);
+
+    // the restored image has the first channel only, as it always had
+    CImg<T> fre = G[0].get_shared_channel(0), fim = G[1].get_shared_channel(0);
+    fim.fill(0);
+    forwardFFT(fre, fim);
+
+    // F = conj(H)/(|H|^2 + k)*G, a frequency at a time
+    const BasicSpectrum<T> H = otf<T>(psf, fre.width(), fre.height());
+    const T *hr = H[0].data(), *hi = H[1].data();
+    T *fr = fre.data(), *fi = fim.data();
+    for (std::size_t i = 0; i < planeSize(fre); ++i) {
+        const std::complex<T> h(hr[i], hi[i]), hConj = std::conj(h);
+        const std::complex<T> dem = h*hConj + std::complex<T>(static_cast<T>(k), 0);
+        const std::complex<T> value = (hConj/dem)*std::complex<T>(fr[i], fi[i]);
+        fr[i] = value.real();
+        fi[i] = value.imag();
+    }
+    inverseFFT(fre, fim);
+
+    return normalized(fre);
+}
+
+template <typename T>
+Image transformedBack(const ImageView &src, IfftPart part)
+{
+    BasicSpectrum<T> F = forwardFFT<T>(src);
+
+    if (part == IfftMagnitude) {
+        mapSpectrum(F, F, magnitudeOnly<T>);
+    } else if (part == IfftPhase) {
+        mapSpectrum(F, F, phaseOnly<T>);
+    } else if (part != IfftComplete) {
+        throw std::invalid_argument("unknown IFFT type");
+    }
+
+    // take only real part, and normalize to (0, 255)
+    inverseFFT(F);
+    return normalized(F[0]);
+}
+
+} // namespace
+
+template <typename T>
+BasicPooledPlane<T>::BasicPooledPlane(int width, int height, int spectrum)
+{
+    const std::size_t bytes = static_cast<std::size_t>(std::max(0, width))*std::max(0, height)*std::max(0, spectrum)
+            *sizeof(T);
+    if (bytes == 0) {
+        return;
+    }
+
+    block.reset(static_cast<T *>(acquireBuffer(bytes)), [bytes](T *data) {
+        releaseBuffer(data, bytes);
+    });
+    view.assign(block.get(), width, height, 1, spectrum, true);
+}
+
+template <typename T>
+BasicPooledPlane<T>::BasicPooledPlane(const BasicPooledPlane &other) :
+    block(other.block), view(other.view)
+{
+}
+
+template <typename T>
+BasicPooledPlane<T> &BasicPooledPlane<T>::operator=(const BasicPooledPlane &other)
+{
+    // CImg would copy the pixels into a shared image, point to them instead
+    view.assign();
+    if (other.block) {
+        view.assign(other.block.get(), other.view.width(), other.view.height(), 1, other.view.spectrum(), true);
+    }
+    block = other.block;
+
+    return *this;
+}
+
+template <typename T>
+BasicSpectrum<T>::BasicSpectrum(int width, int height, int spectrum) :
+    re(width, height, spectrum), im(width, height, spectrum)
+{
+}
+
+template class BasicPooledPlane<float>;
+template class BasicPooledPlane<double>;
+template class BasicSpectrum<float>;
+template class BasicSpectrum<double>;
+
+void setFftPrecision(FftPrecision value)
+{
+    precision.store(value, std::memory_order_relaxed);
+}
+
+FftPrecision fftPrecision()
+{
+    return static_cast<FftPrecision>(precision.load(std::memory_order_relaxed));
+}
+
+// just generate a horizontal line across the middle
+// and then rotate to the specific angle
+Plane motionBlurPsf(int length, int angle)
+{
+    const int len = length % 2 == 0 ? length + 1 : length;
+    Plane psf(len, len, 1, 1, 0.0);
+
+    cimg_forX(psf, x) {
+        psf(x, len/2) = 1;
+    }
+    psf.rotate(-angle);
+    psf /= psf.sum();
+
+    return psf;
+}
+
+Image idealLowPassFilter(const ImageView &src, int D0)
+{
+    requireGrayscale(src, "idealLowPassFilter");
+    auto H = [D0](int d2) { return std::sqrt(static_cast<double>(d2)) <= D0 ? 1.0 : 0.0; };
+    return singlePrecision() ? filtered<float>(src, H) : filtered<double>(src, H);
+}
+
+Image idealHighPassFilter(const ImageView &src, int D0)
+{
+    requireGrayscale(src, "idealHighPassFilter");
+    auto H = [D0](int d2) { return std::sqrt(static_cast<double>(d2)) > D0 ? 1.0 : 0.0; };
+    return singlePrecision() ? filtered<float>(src, H) : filtered<double>(src, H);
+}
+
+Image butterworthLowPassFilter(const ImageView &src, int order, int D0)
+{
+    requireGrayscale(src, "butterworthLowPassFilter");
+    auto H = [order, D0](int d2) {
+        double D = std::sqrt(static_cast<double>(d2));
+        return 1/(1 + std::pow(D/D0, 2*order));
+    };
+    return singlePrecision() ? filtered<float>(src, H) : filtered<double>(src, H);
+}
+
+Image butterworthHighPassFilter(const ImageView &src, int order, int D0)
+{
+    requireGrayscale(src, "butterworthHighPassFilter");
+    auto H = [order, D0](int d2) {
+        double D = std::sqrt(static_cast<double>(d2));
+        return 1/(1 + std::pow(D0/D, 2*order));
+    };
+    return singlePrecision() ? filtered<float>(src, H) : filtered<double>(src, H);
+}
+
+Image homomorphicFilter(const ImageView &src, double gammaL, double gammaH, double c, int D0)
+{
+    requireGrayscale(src, "homomorphicFilter");
+    return singlePrecision() ? homomorphic<float>(src, gammaL, gammaH, c, D0)
+                             : homomorphic<double>(src, gammaL, gammaH, c, D0);
+}
+
+Image spectrum(const ImageView &src)
+{
+    // in double whatever fftPrecision() says, magnitudes that are 0 come
+    // out of a float FFT as its rounding errors, which the log of a log
+    // stretches over a dozen levels
+    return centredSpectrum<double>(src);
+}
+
+Image motionBlur(const ImageView &src, int length, int angle)
+{
+    PooledPlane result(src.width(), src.height(), src.channels());
+    convolveInto(*toPlane<double>(src), motionBlurPsf(length, angle), *result);
+    return normalized(*result);
+}
+
+Image gaussianNoise(const ImageView &src, double variance)
+{
+    PooledPlane result = toPlane<double>(src);
+    result->noise(variance);
+    return normalized(*result);
+}
+
+Image atmosphericCirculationBlur(const ImageView &src, double k)
+{
+    auto H = [k](int d2) { return std::exp(-k*std::pow(static_cast<double>(d2), 5.0/6.0)); };
+    return singlePrecision() ? filtered<float>(src, H) : filtered<double>(src, H);
+}
+
+Image inverseFilter(const ImageView &src, NoiseType noise, int D0, double variance, int length, int angle)
+{
+    return singlePrecision() ? inverse<float>(src, noise, D0, variance, length, angle)
+                             : inverse<double>(src, noise, D0, variance, length, angle);
+}
+
+Image wienerFilter(const ImageView &src, NoiseType noise, double variance, int length, int angle, double k)
+{
+    return singlePrecision() ? wiener<float>(src, noise, variance, length, angle, k)
+                             : wiener<double>(src, noise, variance, length, angle, k);
+}
+
+Image ifft(const ImageView &src, IfftPart part)
+{
+    return singlePrecision() ? transformedBack<float>(src, part) : transformedBack<double>(src, part);
+}
+
+} // namespace ipk
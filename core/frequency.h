@@ -0,0 +1,138 @@
+#ifndef FREQUENCY_H
+#define FREQUENCY_H
+
+#include "image.h"
+#include "CImg.h"
+#include <memory>
+
+namespace ipk {
+
+// frequency domain helpers
+// planes are CImg<float> or CImg<double>, see fftPrecision(), they come
+// from the buffer pool, see bufferpool.h, so running a kernel again at
+// the same size allocates nothing new besides the result
+typedef cimg_library::CImg<double> Plane;
+
+// a CImg<T> over a block of the buffer pool, the block goes back to the
+// pool with the last copy
+// copies share the pixels, like those of an Image, and assigning one
+// makes it point to other pixels, it never copies them
+// T is float or double
+template <typename T>
+class BasicPooledPlane
+{
+public:
+    BasicPooledPlane() {}
+    // pixels not initialized
+    BasicPooledPlane(int width, int height, int spectrum = 1);
+    BasicPooledPlane(const BasicPooledPlane &other);
+    BasicPooledPlane &operator=(const BasicPooledPlane &other);
+
+    bool isNull() const { return !block; }
+    // a shared CImg, its pixels may change, its size may not
+    cimg_library::CImg<T> &operator*() const { return view; }
+    cimg_library::CImg<T> *operator->() const { return &view; }
+
+private:
+    std::shared_ptr<T> block;
+    mutable cimg_library::CImg<T> view;
+};
+
+typedef BasicPooledPlane<double> PooledPlane;
+
+// a complex image, its real and imaginary parts, just what CImg<>::FFT
+// takes and gives, copies share the pixels too
+template <typename T>
+class BasicSpectrum
+{
+public:
+    BasicSpectrum() {}
+    // pixels not initialized
+    BasicSpectrum(int width, int height, int spectrum = 1);
+
+    // 0 for the real part, 1 for the imaginary one
+    cimg_library::CImg<T> &operator[](int part) const { return part == 0 ? *re : *im; }
+    const BasicPooledPlane<T> &real() const { return re; }
+    const BasicPooledPlane<T> &imag() const { return im; }
+
+private:
+    BasicPooledPlane<T> re;
+    BasicPooledPlane<T> im;
+};
+
+// motion blur psf of the given length, rotated by angle degree
+// same as fspecial('motion') of GNU Octave
+Plane motionBlurPsf(int length, int angle);
+
+// precision of the planes of the image level kernels, set for the
+// whole process
+enum FftPrecision {
+    // half the memory and memory traffic of doubles, plenty for images
+    // of 8 bits normalized back to 8 bits, CImg's FFT multiplies in
+    // float either way, the default
+    FftFloat,
+    // what the kernels always computed in
+    FftDouble
+};
+
+void setFftPrecision(FftPrecision precision);
+FftPrecision fftPrecision();
+
+// sets the precision for the life of the object, and the one before back
+class ScopedFftPrecision
+{
+public:
+    explicit ScopedFftPrecision(FftPrecision precision) : previous(fftPrecision()) { setFftPrecision(precision); }
+    ~ScopedFftPrecision() { setFftPrecision(previous); }
+    ScopedFftPrecision(const ScopedFftPrecision &) = delete;
+    ScopedFftPrecision &operator=(const ScopedFftPrecision &) = delete;
+
+private:
+    FftPrecision previous;
+};
+
+// image level kernels
+// results are normalized to (0, 255), like the GUI always did
+// those with a transform compute in the precision of fftPrecision(),
+// but spectrum(), which is always in double
+// each keeps one spectrum, transformed in place, and evaluates its
+// transfer function on the fly, so a grayscale image takes two planes
+// besides the result, four with the OTF of the deblurring
+// the filters below take grayscale images only,
+// and throw std::invalid_argument otherwise
+Image idealLowPassFilter(const ImageView &src, int D0);
+Image idealHighPassFilter(const ImageView &src, int D0);
+Image butterworthLowPassFilter(const ImageView &src, int order, int D0);
+Image butterworthHighPassFilter(const ImageView &src, int order, int D0);
+Image homomorphicFilter(const ImageView &src, double gammaL, double gammaH, double c, int D0);
+
+// every channel on its own from here
+// centred log magnitude of the spectrum
+Image spectrum(const ImageView &src);
+Image motionBlur(const ImageView &src, int length, int angle);
+Image gaussianNoise(const ImageView &src, double variance);
+Image atmosphericCirculationBlur(const ImageView &src, double k);
+
+enum NoiseType {
+    NoiseNone,
+    NoiseGaussian
+};
+
+// blur src, add noise if asked to, and restore it again
+// the Wiener filter restores the first channel only
+Image inverseFilter(const ImageView &src, NoiseType noise, int D0, double variance, int length, int angle);
+Image wienerFilter(const ImageView &src, NoiseType noise, double variance, int length, int angle, double k);
+
+enum IfftPart {
+    IfftComplete,
+    IfftMagnitude,
+    IfftPhase
+};
+
+// FFT and back, keeping all of the spectrum, only the magnitude
+// or only the phase
+Image ifft(const ImageView &src, IfftPart part);
+
+} // namespace ipk
+
+#endif // FREQUENCY_H
@@ -0,0 +1,198 @@
+#include "grayscale.h"
+#include "parallel.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+// weights in Q15 fixed point, they sum to 32768
+// the first weight applies to the first channel in memory
+struct Weights
+{
+    int w0, w1, w2;
+    // rounding term added before the final shift
+    // 0 for GrayDefault, which always truncated
+    bool round;
+};
+
+Weights fixedWeights(GrayWeights weights, PixelLayout layout)
+{
+    Weights w;
+
+    switch (weights) {
+    case GrayBT601:
+        w = { 9798, 19235, 3735, true };
+        break;
+    case GrayBT709:
+        w = { 6966, 23436, 2366, true };
+        break;
+    default:
+        w = { 11 << 10, 16 << 10, 5 << 10, false };
+        break;
+    }
+
+    if (layout == LayoutBGRX8888) {
+        std::swap(w.w0, w.w2);
+    }
+
+    return w;
+}
+
+int samplesPerPixel(PixelLayout layout)
+{
+    return layout == LayoutRGB888 ? 3 : 4;
+}
+
+// 8-bit samples give gray in Q15
+const int shift8 = 15;
+
+void grayRow8(const unsigned char *src, int width, int step, const Weights &w, unsigned char *dst)
+{
+    const int round = w.round ? 1 << (shift8 - 1) : 0;
+    int x = 0;
+
+#ifdef IPK_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights = _mm_setr_epi16(w.w0, w.w1, w.w2, 0, w.w0, w.w1, w.w2, 0);
+    const __m128i rounding = _mm_set1_epi32(round);
+    // gray of 4 pixels, each in 4 bytes of px, as 4 int32
+    auto gray4 = [&](__m128i px) {
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weights);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weights);
+        // lo = (r0*w0 + g0*w1, b0*w2, r1*w0 + g1*w1, b1*w2), hi for pixel 2 and 3
+        __m128 a = _mm_castsi128_ps(lo), b = _mm_castsi128_ps(hi);
+        __m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        return _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), rounding), shift8);
+    };
+    // 4 pixels starting at p, spread to 4 bytes each
+    auto load4 = [&](const unsigned char *p) {
+        if (step == 4) {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        }
+        // 3 bytes per pixel, the 4th byte belongs to the next pixel
+        // and gets a zero weight
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+        __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+        return _mm_unpacklo_epi64(p01, p23);
+    };
+
+    // 16 pixels a time, a 16 bytes load at the last group must stay inside the row
+    const int simdEnd = step == 4 ? width - 16 : width - 18;
+    for (; x <= simdEnd; x += 16) {
+        const unsigned char *p = src + x*step;
+        __m128i g0 = gray4(load4(p));
+        __m128i g1 = gray4(load4(p + 4*step));
+        __m128i g2 = gray4(load4(p + 8*step));
+        __m128i g3 = gray4(load4(p + 12*step));
+        __m128i g = _mm_packus_epi16(_mm_packs_epi32(g0, g1), _mm_packs_epi32(g2, g3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), g);
+    }
+#endif
+
+    for (; x < width; ++x) {
+        const unsigned char *p = src + x*step;
+        dst[x] = static_cast<unsigned char>((w.w0*p[0] + w.w1*p[1] + w.w2*p[2] + round) >> shift8);
+    }
+}
+
+// 4 samples per pixel, the 4th is ignored
+// gray in Q15 of 16-bit samples takes all of an unsigned 32-bit, then
+// down to 8 bits by 257, the way 257*v is back to v, in shifts only:
+// y/257 is (y - y/256)/256 for y up to 65663 (65535 and the rounding)
+void grayRow16(const std::uint16_t *src, int width, const Weights &w, unsigned char *dst)
+{
+    const unsigned int round = w.round ? (257u << shift8)/2 : 0;
+    int x = 0;
+
+#ifdef IPK_SSE2
+    // samples are split in bytes, as _mm_madd_epi16 takes signed ones
+    const __m128i weights = _mm_setr_epi16(w.w0, w.w1, w.w2, 0, w.w0, w.w1, w.w2, 0);
+    const __m128i rounding = _mm_set1_epi32(static_cast<int>(round));
+    const __m128i lowBytes = _mm_set1_epi16(0xff);
+    // sum of the weighted samples of 2 pixels, in their 8 samples v,
+    // as int32 (r0*w0 + g0*w1, b0*w2, r1*w0 + g1*w1, b1*w2)
+    auto products = [&](__m128i v) {
+        __m128i hi = _mm_madd_epi16(_mm_srli_epi16(v, 8), weights);
+        __m128i lo = _mm_madd_epi16(_mm_and_si128(v, lowBytes), weights);
+        return _mm_add_epi32(_mm_slli_epi32(hi, 8), lo);
+    };
+    for (; x + 8 <= width; x += 8) {
+        const __m128i *p = reinterpret_cast<const __m128i *>(src + x*4);
+        __m128i g[2];
+        for (int i = 0; i < 2; ++i) {
+            __m128 a = _mm_castsi128_ps(products(_mm_loadu_si128(p + 2*i)));
+            __m128 b = _mm_castsi128_ps(products(_mm_loadu_si128(p + 2*i + 1)));
+            __m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            // unsigned from here, logical shifts only
+            __m128i y = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), rounding), shift8);
+            g[i] = _mm_srli_epi32(_mm_sub_epi32(y, _mm_srli_epi32(y, 8)), 8);
+        }
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(g[0], g[1]), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), packed);
+    }
+#endif
+
+    for (; x < width; ++x) {
+        const std::uint16_t *p = src + x*4;
+        const unsigned int y = (static_cast<unsigned int>(w.w0)*p[0] + static_cast<unsigned int>(w.w1)*p[1]
+                                + static_cast<unsigned int>(w.w2)*p[2] + round) >> shift8;
+        dst[x] = static_cast<unsigned char>((y - (y >> 8)) >> 8);
+    }
+}
+
+} // namespace
+
+void grayscaleRow(const void *src, int width, PixelLayout layout, GrayWeights weights, unsigned char *dst)
+{
+    const Weights w = fixedWeights(weights, layout);
+
+    if (layout == LayoutRGBX16) {
+        grayRow16(static_cast<const std::uint16_t *>(src), width, w, dst);
+    } else {
+        grayRow8(static_cast<const unsigned char *>(src), width, samplesPerPixel(layout), w, dst);
+    }
+}
+
+Image toGrayscale(const void *bits, int width, int height, std::size_t stride,
+                  PixelLayout layout, GrayWeights weights)
+{
+    Image dst(width, height, 1);
+    const unsigned char *src = static_cast<const unsigned char *>(bits);
+
+    parallelFor(0, height, [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            grayscaleRow(src + y*stride, width, layout, weights, dst.scanLine(y));
+        }
+    }, std::max(1, (1 << 16)/std::max(1, width)));
+
+    return dst;
+}
+
+Image toGrayscale(const ImageView &src, GrayWeights weights)
+{
+    if (!src.isRGB()) {
+        throw std::invalid_argument("toGrayscale: not an RGB image");
+    }
+
+    const int width = src.width();
+    Image dst(width, src.height(), 1);
+
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<unsigned char> buffer(src.isMirrored() ? 3*width + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            grayscaleRow(src.readRow(y, buffer.data()), width, LayoutRGB888, weights, dst.scanLine(y));
+        }
+    }, std::max(1, (1 << 16)/std::max(1, width)));
+
+    return dst;
+}
+
+} // namespace ipk
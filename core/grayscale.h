@@ -0,0 +1,40 @@
+#ifndef GRAYSCALE_H
+#define GRAYSCALE_H
+
+#include "image.h"
+#include <cstddef>
+
+namespace ipk {
+
+// RGB weights used to compute gray value
+enum GrayWeights {
+    // (11*R + 16*G + 5*B)/32, what ImageProcessingKit always used
+    GrayDefault,
+    // ITU-R BT.601, 0.299*R + 0.587*G + 0.114*B
+    GrayBT601,
+    // ITU-R BT.709, 0.2126*R + 0.7152*G + 0.0722*B
+    GrayBT709
+};
+
+// memory layout of one pixel of the source scanlines
+// channel bytes are given in memory order, X is ignored (padding or alpha)
+enum PixelLayout {
+    LayoutRGB888,
+    LayoutRGBX8888,     // QImage::Format_RGBX8888, Format_RGBA8888
+    LayoutBGRX8888,     // QImage::Format_RGB32, Format_ARGB32 on little endian machine
+    LayoutRGBX16        // 16-bit per channel, native endian, QImage::Format_RGBX64
+};
+
+// convert one row of width pixels to 8-bit gray
+void grayscaleRow(const void *src, int width, PixelLayout layout, GrayWeights weights, unsigned char *dst);
+
+// convert height rows of interleaved RGB pixels to a grayscale image in a single pass
+// rows are stride bytes apart, so this reads a decoded QImage directly
+Image toGrayscale(const void *bits, int width, int height, std::size_t stride,
+                  PixelLayout layout, GrayWeights weights = GrayDefault);
+// RGB image only, throws std::invalid_argument otherwise
+Image toGrayscale(const ImageView &src, GrayWeights weights = GrayDefault);
+
+} // namespace ipk
+
+#endif // GRAYSCALE_H
@@ -0,0 +1,115 @@
+#include "histogram.h"
+#include "filters.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace ipk {
+
+namespace {
+
+void checkGrayscale(const ImageView &img, const char *what)
+{
+    if (!img.isGrayscale()) {
+        throw std::invalid_argument(std::string(what) + ": not a grayscale image");
+    }
+}
+
+// normalized cumulative histogram
+std::vector<double> cdf(const ImageView &src)
+{
+    std::vector<std::uint64_t> hist = histogram(src);
+    const double total = static_cast<double>(src.width())*src.height()*src.channels();
+    std::vector<double> result(256);
+
+    std::uint64_t sum = 0;
+    for (int i = 0; i < 256; ++i) {
+        sum += hist[i];
+        result[i] = sum/total;
+    }
+
+    return result;
+}
+
+} // namespace
+
+std::vector<std::uint64_t> histogram(const ImageView &src)
+{
+    std::vector<std::uint64_t> result(256, 0);
+    std::mutex mutex;
+    const int n = src.width()*src.channels();
+
+    // every thread counts into its own bins, merged at the end
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<std::uint64_t> bins(256, 0);
+        std::vector<unsigned char> buffer(src.isMirrored() ? n + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *in = src.readRow(y, buffer.data());
+            for (int i = 0; i < n; ++i) {
+                ++bins[in[i]];
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < 256; ++i) {
+            result[i] += bins[i];
+        }
+    }, std::max(1, (1 << 16)/std::max(1, n)));
+
+    return result;
+}
+
+void equalizationMap(const ImageView &src, unsigned char map[256])
+{
+    std::vector<std::uint64_t> hist = histogram(src);
+    const std::uint64_t total = static_cast<std::uint64_t>(src.width())*src.height()*src.channels();
+
+    std::uint64_t sum = 0;
+    for (int i = 0; i < 256; ++i) {
+        sum += hist[i];
+        map[i] = total ? static_cast<unsigned char>(sum*255/total) : static_cast<unsigned char>(i);
+    }
+}
+
+void specificationMap(const ImageView &src, const ImageView &ref, unsigned char map[256])
+{
+    std::vector<double> cdfSrc = cdf(src);
+    std::vector<double> cdfRef = cdf(ref);
+
+    for (int i = 0; i < 256; ++i) {
+        // first level with the minimum distance
+        int best = 0;
+        for (int j = 1; j < 256; ++j) {
+            if (std::abs(cdfSrc[i] - cdfRef[j]) < std::abs(cdfSrc[i] - cdfRef[best])) {
+                best = j;
+            }
+        }
+        map[i] = static_cast<unsigned char>(best);
+    }
+}
+
+Image histogramEqualization(const ImageView &src)
+{
+    checkGrayscale(src, "histogramEqualization");
+
+    unsigned char map[256];
+    equalizationMap(src, map);
+
+    return applyLut(src, map);
+}
+
+Image histogramSpecification(const ImageView &src, const ImageView &ref)
+{
+    checkGrayscale(src, "histogramSpecification");
+    checkGrayscale(ref, "histogramSpecification");
+
+    unsigned char map[256];
+    specificationMap(src, ref, map);
+
+    return applyLut(src, map);
+}
+
+} // namespace ipk
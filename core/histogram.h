@@ -0,0 +1,25 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "image.h"
+#include <cstdint>
+#include <vector>
+
+namespace ipk {
+
+// 256 bins, one per gray level, counting the samples of all channels
+std::vector<std::uint64_t> histogram(const ImageView &src);
+
+// gray level mappings, map[old] = new
+// level r goes to 255*cdf(r), rounded down
+void equalizationMap(const ImageView &src, unsigned char map[256]);
+// level r goes to the level of ref with the closest cdf
+void specificationMap(const ImageView &src, const ImageView &ref, unsigned char map[256]);
+
+// grayscale images only, throw std::invalid_argument otherwise
+Image histogramEqualization(const ImageView &src);
+Image histogramSpecification(const ImageView &src, const ImageView &ref);
+
+} // namespace ipk
+
+#endif // HISTOGRAM_H
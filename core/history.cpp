@@ -0,0 +1,192 @@
+#include "history.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace ipk {
+
+namespace {
+
+// rows per compressed chunk, about 1 MB of pixels
+inline int chunkRows(int rowBytes)
+{
+    return std::max(1, (1 << 20)/std::max(1, rowBytes));
+}
+
+} // namespace
+
+std::size_t History::Entry::bytes() const
+{
+    std::size_t total = 0;
+
+    for (const QByteArray &chunk : chunks) {
+        total += chunk.size();
+    }
+
+    return total;
+}
+
+History::History(std::size_t budget) :
+    limit(budget), nextId(1), position(-1)
+{
+}
+
+void History::clear()
+{
+    entries.clear();
+    position = -1;
+    image = Image();
+}
+
+void History::push(const Image &img, const Pipeline &steps)
+{
+    entries.erase(entries.begin() + (position + 1), entries.end());
+
+    Entry entry;
+    entry.id = nextId++;
+    entry.width = img.width();
+    entry.height = img.height();
+    entry.channels = img.channels();
+    // the first one is always a snapshot, there's nothing to replay from
+    if (!entries.empty()) {
+        entry.steps = steps;
+    }
+    entry.precision = fftPrecision();
+    compress(entry, img);
+
+    entries.push_back(std::move(entry));
+    position = static_cast<int>(entries.size()) - 1;
+    image = img;
+    trim();
+}
+
+Image History::undo()
+{
+    if (canUndo()) {
+        image = restore(position - 1);
+        --position;
+    }
+
+    return image;
+}
+
+Image History::redo()
+{
+    if (canRedo()) {
+        image = restore(position + 1);
+        ++position;
+    }
+
+    return image;
+}
+
+std::uint64_t History::currentId() const
+{
+    return entries.empty() ? 0 : entries[position].id;
+}
+
+void History::setBudget(std::size_t budget)
+{
+    limit = budget;
+    trim();
+}
+
+std::size_t History::memoryUsage() const
+{
+    std::size_t total = image.byteCount();
+
+    for (const Entry &entry : entries) {
+        total += entry.bytes();
+    }
+
+    return total;
+}
+
+// the closest image at hand before i, and the steps from there on
+Image History::restore(int i) const
+{
+    int j = i;
+    while (j != position && !entries[j].hasSnapshot()) {
+        --j;
+    }
+
+    Image img = j == position ? image : decompress(entries[j]);
+    for (int k = j + 1; k <= i; ++k) {
+        ScopedFftPrecision precision(entries[k].precision);
+        img = entries[k].steps.run(img);
+    }
+
+    return img;
+}
+
+void History::compress(Entry &entry, const Image &img) const
+{
+    const int n = img.width()*img.channels();
+    const int rows = chunkRows(n);
+    const int count = (img.height() + rows - 1)/rows;
+
+    entry.chunks.assign(count, QByteArray());
+    parallelFor(0, count, [&](int first, int last) {
+        // rows without their padding
+        std::vector<unsigned char> buffer(static_cast<std::size_t>(rows)*n);
+        for (int k = first; k < last; ++k) {
+            const int y0 = k*rows;
+            const int y1 = std::min(img.height(), y0 + rows);
+            for (int y = y0; y < y1; ++y) {
+                std::memcpy(&buffer[static_cast<std::size_t>(y - y0)*n], img.scanLine(y), n);
+            }
+            // fastest level, zlib does well enough on 8-bit images anyway
+            entry.chunks[k] = qCompress(buffer.data(), (y1 - y0)*n, 1);
+        }
+    });
+}
+
+Image History::decompress(const Entry &entry) const
+{
+    Image img(entry.width, entry.height, entry.channels);
+    const int n = img.width()*img.channels();
+    const int rows = chunkRows(n);
+
+    parallelFor(0, static_cast<int>(entry.chunks.size()), [&](int first, int last) {
+        for (int k = first; k < last; ++k) {
+            const QByteArray data = qUncompress(entry.chunks[k]);
+            const int y0 = k*rows;
+            const int y1 = std::min(img.height(), y0 + rows);
+            for (int y = y0; y < y1; ++y) {
+                std::memcpy(img.scanLine(y), data.constData() + static_cast<std::size_t>(y - y0)*n, n);
+            }
+        }
+    });
+
+    return img;
+}
+
+void History::trim()
+{
+    std::size_t used = memoryUsage() - image.byteCount();
+
+    // snapshots that can be replayed, oldest first
+    for (std::size_t i = 1; i < entries.size() && used > limit; ++i) {
+        Entry &entry = entries[i];
+        if (!entry.steps.isEmpty() && entry.hasSnapshot()) {
+            used -= entry.bytes();
+            entry.chunks.clear();
+        }
+    }
+
+    // then the oldest images, the next one becomes the first, so it needs a snapshot
+    while (used > limit && position > 0) {
+        Entry &next = entries[1];
+        if (!next.hasSnapshot()) {
+            compress(next, restore(1));
+            used += next.bytes();
+        }
+        next.steps.clear();
+        used -= entries.front().bytes();
+        entries.pop_front();
+        --position;
+    }
+}
+
+} // namespace ipk
@@ -0,0 +1,86 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "frequency.h"
+#include "image.h"
+#include "pipeline.h"
+#include <QByteArray>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace ipk {
+
+// undo/redo history of the working image
+//
+// only the current image is kept as is, the others are kept as
+// snapshots, their rows compressed by qCompress in chunks of about
+// 1 MB, which are done in parallel
+// an image made from the one before it by known steps needn't keep
+// a snapshot, it's replayed from the closest snapshot before it
+//
+// beyond the budget, snapshots of such images are dropped first,
+// oldest first, then the oldest images themselves
+class History
+{
+public:
+    explicit History(std::size_t budget = std::size_t(256) << 20);
+
+    void clear();
+    // img becomes the current image, anything that could be redone is dropped
+    // steps make img from the current image, if they are known,
+    // they are replayed in the fftPrecision() of the time of the push
+    void push(const Image &img, const Pipeline &steps = Pipeline());
+
+    bool isEmpty() const { return entries.empty(); }
+    bool canUndo() const { return position > 0; }
+    bool canRedo() const { return position + 1 < static_cast<int>(entries.size()); }
+    // the image before or after the current one, which becomes the current one
+    // the current image stays put if there's none
+    Image undo();
+    Image redo();
+    Image current() const { return image; }
+    // serial number of the current image, unique for the life of the history
+    std::uint64_t currentId() const;
+    int count() const { return static_cast<int>(entries.size()); }
+    int index() const { return position; }
+
+    // the budget covers the snapshots, the current image comes on top
+    std::size_t budget() const { return limit; }
+    void setBudget(std::size_t budget);
+    std::size_t memoryUsage() const;
+
+private:
+    struct Entry
+    {
+        std::uint64_t id;
+        int width;
+        int height;
+        int channels;
+        // compressed rows, empty once dropped
+        std::vector<QByteArray> chunks;
+        // from the entry before to this one, empty if unknown
+        Pipeline steps;
+        // what the steps ran in
+        FftPrecision precision;
+
+        bool hasSnapshot() const { return !chunks.empty(); }
+        std::size_t bytes() const;
+    };
+
+    Image restore(int i) const;
+    void compress(Entry &entry, const Image &img) const;
+    Image decompress(const Entry &entry) const;
+    void trim();
+
+    std::size_t limit;
+    std::uint64_t nextId;
+    std::deque<Entry> entries;
+    int position;
+    Image image;
+};
+
+} // namespace ipk
+
+#endif // HISTORY_H
@@ -0,0 +1,196 @@
+#include "image.h"
+#include "memory.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+namespace ipk {
+
+namespace {
+
+const std::size_t alignment = 64;
+
+// malloc() with the returned pointer aligned to alignment bytes
+// the original pointer is kept right before the aligned one
+unsigned char *alignedAlloc(std::size_t size)
+{
+    void *raw = std::malloc(size + alignment + sizeof(void *));
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void *);
+    addr = (addr + alignment - 1) & ~(alignment - 1);
+    reinterpret_cast<void **>(addr)[-1] = raw;
+
+    return reinterpret_cast<unsigned char *>(addr);
+}
+
+void alignedFree(unsigned char *ptr)
+{
+    if (ptr) {
+        std::free(reinterpret_cast<void **>(ptr)[-1]);
+    }
+}
+
+} // namespace
+
+Image::Image() :
+    w(0), h(0), c(0), bytesPerLine(0)
+{
+}
+
+Image::Image(int width, int height, int channels) :
+    w(width), h(height), c(channels)
+{
+    bytesPerLine = strideFor(w, c);
+    if (w > 0 && h > 0 && c > 0) {
+        // counted while it lives, see memory.h
+        const std::size_t bytes = bytesPerLine*h + alignment;
+        data.reset(alignedAlloc(bytes), [bytes](unsigned char *ptr) {
+            alignedFree(ptr);
+            countRelease(bytes);
+        });
+        countAllocation(bytes);
+        countBuffer(bytes);
+    } else {
+        w = h = c = 0;
+        bytesPerLine = 0;
+    }
+}
+
+Image::Image(int width, int height, int channels, const std::shared_ptr<unsigned char> &pixels) :
+    w(width), h(height), c(channels), data(pixels)
+{
+    bytesPerLine = strideFor(w, c);
+    if (w <= 0 || h <= 0 || c <= 0 || !data) {
+        w = h = c = 0;
+        bytesPerLine = 0;
+        data.reset();
+    }
+}
+
+std::size_t Image::strideFor(int width, int channels)
+{
+    return (static_cast<std::size_t>(std::max(0, width))*std::max(0, channels) + alignment - 1) & ~(alignment - 1);
+}
+
+Image Image::copy() const
+{
+    Image result(w, h, c);
+
+    if (!isNull()) {
+        std::memcpy(result.bits(), bits(), byteCount());
+    }
+
+    return result;
+}
+
+ImageView::ImageView() :
+    w(0), h(0), c(0), xStride(0), yStride(0), origin(0)
+{
+}
+
+ImageView::ImageView(const Image &image) :
+    w(image.w), h(image.h), c(image.c),
+    xStride(image.c), yStride(static_cast<std::ptrdiff_t>(image.bytesPerLine)),
+    origin(image.data.get()), data(image.data)
+{
+}
+
+ImageView ImageView::mirrored() const
+{
+    ImageView result(*this);
+
+    if (!isNull()) {
+        result.origin = pixel(w - 1, 0);
+        result.xStride = -xStride;
+    }
+
+    return result;
+}
+
+ImageView ImageView::flipped() const
+{
+    ImageView result(*this);
+
+    if (!isNull()) {
+        result.origin = pixel(0, h - 1);
+        result.yStride = -yStride;
+    }
+
+    return result;
+}
+
+ImageView ImageView::cropped(int x, int y, int width, int height) const
+{
+    int x0 = std::max(0, x), y0 = std::max(0, y);
+    int x1 = std::min(w, x + width), y1 = std::min(h, y + height);
+
+    if (x0 >= x1 || y0 >= y1) {
+        return ImageView();
+    }
+
+    ImageView result(*this);
+    result.origin = pixel(x0, y0);
+    result.w = x1 - x0;
+    result.h = y1 - y0;
+
+    return result;
+}
+
+const unsigned char *ImageView::readRow(int y, unsigned char *buffer) const
+{
+    const unsigned char *row = scanLine(y);
+
+    if (!isMirrored()) {
+        return row;
+    }
+
+    for (int x = 0; x < w; ++x, row += xStride) {
+        std::memcpy(buffer + x*c, row, c);
+    }
+
+    return buffer;
+}
+
+Image ImageView::toImage() const
+{
+    Image result(w, h, c);
+
+    if (!isNull()) {
+        copyPixels(*this, result);
+    }
+
+    return result;
+}
+
+void copyPixels(const ImageView &src, const ImageView &dst)
+{
+    if (src.width() != dst.width() || src.height() != dst.height()
+            || src.channels() != dst.channels()) {
+        throw std::invalid_argument("copyPixels: views of different size");
+    }
+
+    const int c = src.channels();
+    const std::size_t rowSize = static_cast<std::size_t>(src.width())*c;
+    // only the relative direction matters, mirror src so that dst is left to right
+    const ImageView from = dst.isMirrored() ? src.mirrored() : src;
+    const ImageView to = dst.isMirrored() ? dst.mirrored() : dst;
+
+    for (int y = 0; y < src.height(); ++y) {
+        if (!from.isMirrored()) {
+            std::memmove(to.scanLine(y), from.scanLine(y), rowSize);
+        } else {
+            const unsigned char *in = from.scanLine(y);
+            unsigned char *out = to.scanLine(y);
+            for (int x = 0; x < src.width(); ++x, in -= c) {
+                std::memcpy(out + x*c, in, c);
+            }
+        }
+    }
+}
+
+} // namespace ipk
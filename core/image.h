@@ -0,0 +1,121 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <cstddef>
+#include <memory>
+
+namespace ipk {
+
+// plain interleaved 8-bit image buffer used by the processing kernels
+// pixels are stored row by row, channels interleaved (gray, or R G B)
+// every row starts on a 64 bytes boundary, so rows might be padded
+// 64 spare bytes follow the last row, so SIMD loads might read
+// a few bytes past the end of any row
+//
+// copies share the same pixel data, just like QImage does,
+// use copy() if a deep copy is needed
+class Image
+{
+public:
+    Image();
+    Image(int width, int height, int channels);
+    // wraps pixels laid out like those of Image(width, height, channels):
+    // starting on a 64 bytes boundary, rows of strideFor() bytes, and
+    // 64 spare bytes after the last row, a mapped file for instance
+    // data is released by its deleter once the last copy is gone
+    Image(int width, int height, int channels, const std::shared_ptr<unsigned char> &data);
+
+    // bytes per row of an image of that width and channels
+    static std::size_t strideFor(int width, int channels);
+
+    bool isNull() const { return !data; }
+    int width() const { return w; }
+    int height() const { return h; }
+    int channels() const { return c; }
+    bool isGrayscale() const { return c == 1; }
+    bool isRGB() const { return c == 3; }
+    // bytes per row, including padding
+    std::size_t stride() const { return bytesPerLine; }
+    std::size_t byteCount() const { return bytesPerLine*h; }
+
+    unsigned char *bits() { return data.get(); }
+    const unsigned char *bits() const { return data.get(); }
+    unsigned char *scanLine(int y) { return data.get() + y*bytesPerLine; }
+    const unsigned char *scanLine(int y) const { return data.get() + y*bytesPerLine; }
+
+    // create a new image with the same size and number of channels
+    // pixels are not initialized
+    Image sameSize() const { return Image(w, h, c); }
+    Image copy() const;
+
+private:
+    friend class ImageView;
+
+    int w;
+    int h;
+    int c;
+    std::size_t bytesPerLine;
+    std::shared_ptr<unsigned char> data;
+};
+
+// strided window on the pixels of an Image, nothing is copied
+// mirrored views step backward within a row, flipped views step
+// backward from row to row, crops just move the origin
+// views keep the pixel data alive, like a copy of the Image would
+//
+// kernels take views, so they can run on a region of interest,
+// and an Image converts to a view of all its pixels
+class ImageView
+{
+public:
+    ImageView();
+    ImageView(const Image &image);
+
+    bool isNull() const { return !data; }
+    int width() const { return w; }
+    int height() const { return h; }
+    int channels() const { return c; }
+    bool isGrayscale() const { return c == 1; }
+    bool isRGB() const { return c == 3; }
+    // bytes from a pixel to the next one in a row, negative if mirrored
+    std::ptrdiff_t pixelStride() const { return xStride; }
+    // bytes from a row to the next one, negative if flipped
+    std::ptrdiff_t rowStride() const { return yStride; }
+    bool isMirrored() const { return xStride < 0; }
+
+    unsigned char *pixel(int x, int y) const { return origin + y*yStride + x*xStride; }
+    // first pixel of row y, the next ones are at lower addresses if mirrored
+    unsigned char *scanLine(int y) const { return origin + y*yStride; }
+
+    ImageView mirrored() const;
+    ImageView flipped() const;
+    // the rectangle is clipped to the view
+    ImageView cropped(int x, int y, int width, int height) const;
+
+    // pixels of row y, left to right
+    // points into the image, unless the view is mirrored, then the row
+    // is copied into buffer, which needs width()*channels() bytes
+    // kernels may read up to 64 bytes past the row either way,
+    // so buffer should have that much room at the end
+    const unsigned char *readRow(int y, unsigned char *buffer) const;
+    // deep copy, left to right and top to bottom
+    Image toImage() const;
+
+private:
+    int w;
+    int h;
+    int c;
+    std::ptrdiff_t xStride;
+    std::ptrdiff_t yStride;
+    unsigned char *origin;
+    std::shared_ptr<unsigned char> data;
+};
+
+// copy the pixels of src into dst, both views have the same size
+// and should not overlap
+// throws std::invalid_argument otherwise
+void copyPixels(const ImageView &src, const ImageView &dst);
+
+} // namespace ipk
+
+#endif // IMAGE_H
@@ -0,0 +1,141 @@
+#include "imageio.h"
+#include "mappedimage.h"
+#include "profiler.h"
+#include <QFileInfo>
+#include <QImage>
+#include <cstdint>
+#include <cstring>
+
+namespace ipk {
+
+namespace {
+
+// like CImg, only 8-bit grayscale files are treated as grayscale
+bool isGrayscale(const QImage &qimg)
+{
+    return qimg.format() == QImage::Format_Grayscale8
+            || ((qimg.format() == QImage::Format_Indexed8 || qimg.format() == QImage::Format_Mono)
+                && qimg.isGrayscale());
+}
+
+Image fromQImage(QImage qimg)
+{
+    bool gray = isGrayscale(qimg);
+    qimg = qimg.convertToFormat(gray ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+
+    Image img(qimg.width(), qimg.height(), gray ? 1 : 3);
+    const int rowSize = img.width()*img.channels();
+    for (int y = 0; y < img.height(); ++y) {
+        std::memcpy(img.scanLine(y), qimg.constScanLine(y), rowSize);
+    }
+
+    return img;
+}
+
+// QImage on the pixels of img, through view, which keeps them alive
+// QImage wants forward, 32-bit aligned rows, as an Image has,
+// other views are copied first
+QImage wrapImage(const ImageView &img, ImageView &view)
+{
+    bool direct = img.pixelStride() == img.channels() && img.rowStride() > 0 && img.rowStride() % 4 == 0
+            && reinterpret_cast<std::uintptr_t>(img.scanLine(0)) % 4 == 0;
+    view = direct ? img : ImageView(img.toImage());
+
+    return QImage(view.scanLine(0), view.width(), view.height(), static_cast<int>(view.rowStride()),
+                  view.isGrayscale() ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+}
+
+} // namespace
+
+Image loadImage(const QString &fileName)
+{
+    ScopedTimer timer("decode");
+
+    // nothing to decode, only gray and RGB files are taken, like from QImage
+    if (isMappedImageFile(fileName)) {
+        Image img = mapImage(fileName);
+        return img.isGrayscale() || img.isRGB() ? img : Image();
+    }
+
+    QImage qimg(fileName);
+
+    if (qimg.isNull()) {
+        return Image();
+    }
+
+    return fromQImage(qimg);
+}
+
+Image loadGrayscale(const QString &fileName, GrayWeights weights)
+{
+    if (isMappedImageFile(fileName)) {
+        Image img = loadImage(fileName);
+        return img.isRGB() ? toGrayscale(img, weights) : img;
+    }
+
+    ScopedTimer timer("decode");
+    QImage qimg(fileName);
+
+    if (qimg.isNull()) {
+        return Image();
+    } else if (isGrayscale(qimg)) {
+        return fromQImage(qimg);
+    }
+
+    // the layouts toGrayscale() reads as they are, those with alpha
+    // aren't among them, QImage drops it its own way
+    PixelLayout layout;
+    switch (qimg.format()) {
+    case QImage::Format_RGB888:
+        layout = LayoutRGB888;
+        break;
+    case QImage::Format_RGBX8888:
+        layout = LayoutRGBX8888;
+        break;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case QImage::Format_RGB32:
+        layout = LayoutBGRX8888;
+        break;
+#endif
+    case QImage::Format_RGBX64:
+        layout = LayoutRGBX16;
+        break;
+    default:
+        qimg = qimg.convertToFormat(QImage::Format_RGB888);
+        layout = LayoutRGB888;
+        break;
+    }
+
+    ScopedTimer grayscaleTimer("grayscale");
+    return toGrayscale(qimg.constBits(), qimg.width(), qimg.height(), qimg.bytesPerLine(), layout, weights);
+}
+
+bool saveImage(const ImageView &img, const QString &fileName)
+{
+    ScopedTimer timer("encode");
+
+    if (img.isNull() || (!img.isGrayscale() && !img.isRGB())) {
+        return false;
+    }
+
+    if (QFileInfo(fileName).suffix().compare("ipk", Qt::CaseInsensitive) == 0) {
+        return saveMappedImage(img, fileName);
+    }
+
+    ImageView view;
+    return wrapImage(img, view).save(fileName);
+}
+
+QImage toQImage(const ImageView &img)
+{
+    ScopedTimer timer("display conversion");
+
+    if (img.isNull() || (!img.isGrayscale() && !img.isRGB())) {
+        return QImage();
+    }
+
+    ImageView view;
+    return wrapImage(img, view).copy();
+}
+
+} // namespace ipk
@@ -0,0 +1,27 @@
+#ifndef IMAGEIO_H
+#define IMAGEIO_H
+
+#include "grayscale.h"
+#include "image.h"
+#include <QImage>
+#include <QString>
+
+namespace ipk {
+
+// image files through QImage, so no widget is needed
+// grayscale files give 1 channel, everything else 3 channels (alpha dropped)
+// mapped image files (see mappedimage.h) are mapped, not read
+// returns a null image if the file can't be read
+Image loadImage(const QString &fileName);
+// the same, converted to grayscale straight from the decoded scanlines,
+// in a single pass, 16-bit files keep their bits up to the conversion
+// grayscale files are loaded as is
+Image loadGrayscale(const QString &fileName, GrayWeights weights = GrayDefault);
+// the format is guessed from the file name, *.ipk is a mapped image file
+bool saveImage(const ImageView &img, const QString &fileName);
+// deep copy, Format_Grayscale8 or Format_RGB888, null for other channel counts
+QImage toQImage(const ImageView &img);
+
+} // namespace ipk
+
+#endif // IMAGEIO_H
@@ -0,0 +1,308 @@
+#include "mappedimage.h"
+#include "parallel.h"
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+const char magic[8] = { 'I', 'P', 'K', 'I', 'M', 'A', 'G', 'E' };
+const quint32 currentVersion = 1;
+
+// in the byte order of the machine, little endian anywhere this runs
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 width;
+    quint32 height;
+    quint32 channels;
+    // bytes per row, and from the start of the file to the first row
+    quint64 stride;
+    quint64 offset;
+    // a SampleType, 0 in files written before there were others
+    quint32 sampleType;
+    char reserved[20];
+};
+
+static_assert(sizeof(Header) == 64, "the header takes 64 bytes");
+
+int sampleBytes(quint32 type)
+{
+    switch (type) {
+    case SampleUInt16:
+        return 2;
+    case SampleUInt32:
+    case SampleFloat:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+Header makeHeader(int width, int height, int channels, SampleType type)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = currentVersion;
+    header.width = width;
+    header.height = height;
+    header.channels = channels;
+    header.stride = Image::strideFor(width, channels*sampleBytes(type));
+    header.offset = sizeof(header);
+    header.sampleType = type;
+    return header;
+}
+
+bool readHeader(QFile &file, Header &header)
+{
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+
+    return std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == currentVersion
+            && header.width > 0 && header.width <= 0x7fffffff
+            && header.height > 0 && header.height <= 0x7fffffff
+            && header.channels > 0 && header.channels <= 4
+            && header.sampleType <= SampleFloat
+            && header.stride == Image::strideFor(header.width, header.channels*sampleBytes(header.sampleType))
+            && header.offset >= sizeof(header) && header.offset % 64 == 0;
+}
+
+// file size, the 64 spare bytes of an Image included
+qint64 fileSize(const Header &header)
+{
+    return header.offset + header.stride*header.height + 64;
+}
+
+// the rows of an open file, the pointer keeps the file
+std::shared_ptr<unsigned char> map(const std::shared_ptr<QFile> &file, const Header &header,
+                                   QFileDevice::MemoryMapFlags flags)
+{
+    if (file->size() < fileSize(header)) {
+        return std::shared_ptr<unsigned char>();
+    }
+
+    uchar *pixels = file->map(0, fileSize(header), flags);
+    if (!pixels) {
+        return std::shared_ptr<unsigned char>();
+    }
+
+    // the file is unmapped and closed with the last copy of the pointer
+    return std::shared_ptr<unsigned char>(pixels + header.offset, [file, pixels](unsigned char *) {
+        file->unmap(pixels);
+    });
+}
+
+// a new mapped file of an open file
+std::shared_ptr<unsigned char> create(const std::shared_ptr<QFile> &file, const Header &header)
+{
+    // resizing leaves a sparse file on most systems, nothing is written yet
+    if (file->write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+            || !file->resize(fileSize(header))) {
+        return std::shared_ptr<unsigned char>();
+    }
+
+    return map(file, header, QFileDevice::NoOptions);
+}
+
+Image create(const std::shared_ptr<QFile> &file, int width, int height, int channels)
+{
+    if (width <= 0 || height <= 0 || channels <= 0 || channels > 4) {
+        return Image();
+    }
+
+    return Image(width, height, channels, create(file, makeHeader(width, height, channels, SampleUInt8)));
+}
+
+// samples to and from 8 bits, over the full range of the type
+inline unsigned char toByte(quint16 v)
+{
+    return static_cast<unsigned char>((v*255u + 32767u)/65535u);
+}
+
+inline unsigned char toByte(quint32 v)
+{
+    return static_cast<unsigned char>((static_cast<quint64>(v)*255u + 0x7fffffffu)/0xffffffffu);
+}
+
+inline unsigned char toByte(float v)
+{
+    // NaN goes to 0 too
+    return v >= 1.0f ? 255 : (v > 0.0f ? static_cast<unsigned char>(v*255.0f + 0.5f) : 0);
+}
+
+inline void fromByte(unsigned char v, quint16 &out)
+{
+    out = static_cast<quint16>(v*257u);
+}
+
+inline void fromByte(unsigned char v, quint32 &out)
+{
+    out = v*16843009u;
+}
+
+inline void fromByte(unsigned char v, float &out)
+{
+    out = v/255.0f;
+}
+
+template <typename T>
+void rowsToBytes(const unsigned char *src, std::size_t stride, Image &dst)
+{
+    const int n = dst.width()*dst.channels();
+    parallelFor(0, dst.height(), [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            const T *in = reinterpret_cast<const T *>(src + y*stride);
+            unsigned char *out = dst.scanLine(y);
+            for (int x = 0; x < n; ++x) {
+                out[x] = toByte(in[x]);
+            }
+        }
+    }, 16);
+}
+
+template <typename T>
+void rowsFromBytes(const ImageView &src, unsigned char *dst, std::size_t stride)
+{
+    const int n = src.width()*src.channels();
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<unsigned char> buffer(n + 64);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *in = src.readRow(y, buffer.data());
+            T *out = reinterpret_cast<T *>(dst + y*stride);
+            for (int x = 0; x < n; ++x) {
+                fromByte(in[x], out[x]);
+            }
+        }
+    }, 16);
+}
+
+} // namespace
+
+bool isMappedImageFile(const QString &fileName)
+{
+    QFile file(fileName);
+    Header header;
+
+    return file.open(QIODevice::ReadOnly) && readHeader(file, header);
+}
+
+Image mapImage(const QString &fileName, const QString &scratchDirectory)
+{
+    std::shared_ptr<QFile> file = std::make_shared<QFile>(fileName);
+    Header header;
+
+    if (!file->open(QIODevice::ReadOnly) || !readHeader(*file, header)) {
+        return Image();
+    }
+
+    std::shared_ptr<unsigned char> data = map(file, header, QFileDevice::MapPrivateOption);
+    if (header.sampleType == SampleUInt8 || !data) {
+        return Image(header.width, header.height, header.channels, data);
+    }
+
+    Image img = scratchDirectory.isEmpty()
+            ? Image(header.width, header.height, header.channels)
+            : createTemporaryMappedImage(scratchDirectory, header.width, header.height, header.channels);
+    if (img.isNull()) {
+        return Image();
+    }
+
+    switch (header.sampleType) {
+    case SampleUInt16:
+        rowsToBytes<quint16>(data.get(), header.stride, img);
+        break;
+    case SampleUInt32:
+        rowsToBytes<quint32>(data.get(), header.stride, img);
+        break;
+    default:
+        rowsToBytes<float>(data.get(), header.stride, img);
+        break;
+    }
+
+    return img;
+}
+
+Image createMappedImage(const QString &fileName, int width, int height, int channels)
+{
+    std::shared_ptr<QFile> file = std::make_shared<QFile>(fileName);
+
+    if (!file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return Image();
+    }
+
+    return create(file, width, height, channels);
+}
+
+std::shared_ptr<unsigned char> createMappedSamples(const QString &fileName, int width, int height, int channels,
+                                                   SampleType type, std::size_t &stride)
+{
+    if (width <= 0 || height <= 0 || channels <= 0 || channels > 4) {
+        return std::shared_ptr<unsigned char>();
+    }
+
+    std::shared_ptr<QFile> file = std::make_shared<QFile>(fileName);
+    if (!file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return std::shared_ptr<unsigned char>();
+    }
+
+    const Header header = makeHeader(width, height, channels, type);
+    stride = header.stride;
+    return create(file, header);
+}
+
+Image createTemporaryMappedImage(const QString &directory, int width, int height, int channels)
+{
+    // removed when closed, that is, once unmapped
+    std::shared_ptr<QTemporaryFile> file = std::make_shared<QTemporaryFile>(QDir(directory).filePath("ipk-XXXXXX.tmp"));
+
+    if (!file->open()) {
+        return Image();
+    }
+
+    return create(file, width, height, channels);
+}
+
+bool saveMappedImage(const ImageView &img, const QString &fileName, SampleType type)
+{
+    if (img.isNull() || img.channels() > 4) {
+        return false;
+    }
+
+    std::shared_ptr<QFile> file = std::make_shared<QFile>(fileName);
+    if (!file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return false;
+    }
+
+    const Header header = makeHeader(img.width(), img.height(), img.channels(), type);
+    std::shared_ptr<unsigned char> data = create(file, header);
+    if (!data) {
+        return false;
+    }
+
+    switch (type) {
+    case SampleUInt8:
+        copyPixels(img, Image(img.width(), img.height(), img.channels(), data));
+        break;
+    case SampleUInt16:
+        rowsFromBytes<quint16>(img, data.get(), header.stride);
+        break;
+    case SampleUInt32:
+        rowsFromBytes<quint32>(img, data.get(), header.stride);
+        break;
+    default:
+        rowsFromBytes<float>(img, data.get(), header.stride);
+        break;
+    }
+
+    return true;
+}
+
+} // namespace ipk
@@ -0,0 +1,55 @@
+#ifndef MAPPEDIMAGE_H
+#define MAPPEDIMAGE_H
+
+#include "image.h"
+#include <QString>
+#include <cstddef>
+
+namespace ipk {
+
+// images kept in files mapped into memory, pixels are paged in when
+// first read, and written back by the system, so an image needs not
+// fit in memory
+//
+// the file is a 64 bytes header followed by the rows, laid out just
+// like the pixels of an Image, so a mapped file of 8-bit samples is an
+// Image like any other, with nothing to decode
+// samples may also be 16 or 32-bit unsigned integers, or floats
+//
+// the file stays mapped until the last copy of the image is gone
+
+enum SampleType {
+    SampleUInt8,
+    SampleUInt16,
+    SampleUInt32,
+    // 0 to 1
+    SampleFloat
+};
+
+// true if fileName starts with the header of a mapped image file
+bool isMappedImageFile(const QString &fileName);
+// 8-bit samples are mapped read only, writes go to private copies of the pages
+// others are converted to 8 bits from the full range of their type,
+// in parallel, into a temporary mapped file in scratchDirectory if
+// there's one, into memory otherwise
+// returns a null image if the file can't be mapped
+Image mapImage(const QString &fileName, const QString &scratchDirectory = QString());
+// a new file of 8-bit samples, its pixels not initialized, writes go to the file
+// returns a null image if the file can't be made
+Image createMappedImage(const QString &fileName, int width, int height, int channels);
+// same as createMappedImage, for samples of any type, written straight
+// through the pointer, rows stride bytes apart, the file stays mapped
+// as long as the pointer
+// returns a null pointer if the file can't be made
+std::shared_ptr<unsigned char> createMappedSamples(const QString &fileName, int width, int height, int channels,
+                                                   SampleType type, std::size_t &stride);
+// same as createMappedImage, for a file in directory that's removed
+// once the image is gone
+Image createTemporaryMappedImage(const QString &directory, int width, int height, int channels);
+// img written with samples of type, 8 bits are spread over the full range
+// of the type, so converting back to 8 bits gives img again
+bool saveMappedImage(const ImageView &img, const QString &fileName, SampleType type = SampleUInt8);
+
+} // namespace ipk
+
+#endif // MAPPEDIMAGE_H
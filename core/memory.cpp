@@ -0,0 +1,202 @@
+#include "memory.h"
+#include <QtGlobal>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_DARWIN)
+#include <mach/mach.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+namespace ipk {
+
+namespace {
+
+std::atomic<std::uint64_t> allocated(0);
+std::atomic<std::uint64_t> live(0);
+// watermarks running, so that allocations skip the lock when there are none
+std::atomic<int> watermarkCount(0);
+
+const std::chrono::milliseconds samplePeriod(1);
+
+} // namespace
+
+// the running watermarks, and the thread sampling the resident set
+// for them, it waits for one to start and never ends
+class MemorySampler
+{
+public:
+    static MemorySampler &instance()
+    {
+        // never destroyed, its thread might still be waiting at exit
+        static MemorySampler *sampler = new MemorySampler;
+        return *sampler;
+    }
+
+    void add(MemoryWatermark *watermark)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        watermarks.push_back(watermark);
+        ++watermarkCount;
+        if (!started && watermark->peakRss > 0) {
+            // the system tells the resident set, worth sampling
+            started = true;
+            std::thread(&MemorySampler::sample, this).detach();
+        }
+        wake.notify_one();
+    }
+
+    void remove(MemoryWatermark *watermark)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        watermarks.erase(std::find(watermarks.begin(), watermarks.end(), watermark));
+        --watermarkCount;
+    }
+
+    // resident 0 leaves the resident peaks alone
+    void raise(std::uint64_t liveBytes, std::uint64_t resident)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (MemoryWatermark *watermark : watermarks) {
+            watermark->peakLive = std::max(watermark->peakLive, liveBytes);
+            watermark->peakRss = std::max(watermark->peakRss, resident);
+        }
+    }
+
+private:
+    MemorySampler() : started(false) {}
+
+    void sample()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this]() { return !watermarks.empty(); });
+            // reading it takes a few microseconds, not with the lock held
+            lock.unlock();
+            const std::uint64_t resident = residentBytes();
+            lock.lock();
+            for (MemoryWatermark *watermark : watermarks) {
+                watermark->peakRss = std::max(watermark->peakRss, resident);
+            }
+            wake.wait_for(lock, samplePeriod);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<MemoryWatermark *> watermarks;
+    bool started;
+};
+
+void countAllocation(std::size_t bytes)
+{
+    allocated.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+std::uint64_t allocatedBytes()
+{
+    return allocated.load(std::memory_order_relaxed);
+}
+
+void countBuffer(std::size_t bytes)
+{
+    const std::uint64_t now = live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (watermarkCount.load(std::memory_order_relaxed) > 0) {
+        MemorySampler::instance().raise(now, 0);
+    }
+}
+
+void countRelease(std::size_t bytes)
+{
+    // peaks only go up, nothing to raise
+    live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+std::uint64_t liveBytes()
+{
+    return live.load(std::memory_order_relaxed);
+}
+
+std::uint64_t residentBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(Q_OS_DARWIN)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)
+            == KERN_SUCCESS) {
+        return info.resident_size;
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    // pages in total, then resident, the cheapest place to read it
+    std::FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long long pages = 0, resident = 0;
+    const bool read = std::fscanf(statm, "%llu %llu", &pages, &resident) == 2;
+    std::fclose(statm);
+    return read ? resident*static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
+
+MemoryWatermark::MemoryWatermark() :
+    liveAtStart(0), peakLive(0), peakRss(0), running(false)
+{
+}
+
+MemoryWatermark::~MemoryWatermark()
+{
+    finish();
+}
+
+void MemoryWatermark::start()
+{
+    if (running) {
+        return;
+    }
+    running = true;
+    liveAtStart = peakLive = liveBytes();
+    peakRss = residentBytes();
+    MemorySampler::instance().add(this);
+}
+
+void MemoryWatermark::finish()
+{
+    if (!running) {
+        return;
+    }
+    running = false;
+    MemorySampler::instance().raise(liveBytes(), residentBytes());
+    MemorySampler::instance().remove(this);
+}
+
+std::uint64_t MemoryWatermark::peakBytes() const
+{
+    return peakLive - liveAtStart;
+}
+
+std::uint64_t MemoryWatermark::peakResident() const
+{
+    return peakRss;
+}
+
+} // namespace ipk
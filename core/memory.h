@@ -0,0 +1,66 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ipk {
+
+// how much memory the kernels take
+// Image buffers and the float or double planes of the frequency domain
+// kernels, which come from the buffer pool, are counted, so what is live
+// at any time is known to the byte, what CImg allocates inside its own
+// routines isn't counted that way, the resident set of the process sees
+// it instead
+// both count for the whole process, whatever thread allocates
+
+// whatever allocates pixels counts them here, CImg planes too
+void countAllocation(std::size_t bytes);
+// since the start of the process
+std::uint64_t allocatedBytes();
+
+// buffers in use, from countBuffer() to countRelease(), the Image
+// pixels and the blocks of the buffer pool, see bufferpool.h
+// allocating them is counted by countAllocation() on its own, a block
+// of the pool is in use more than once for one allocation
+void countBuffer(std::size_t bytes);
+void countRelease(std::size_t bytes);
+// counted by countBuffer() and not released yet
+std::uint64_t liveBytes();
+
+// of the process right now, 0 where the system doesn't tell
+std::uint64_t residentBytes();
+
+// the highest live bytes and resident set from start() to finish()
+// live bytes are followed on every allocation, the resident set at
+// start and finish, and every millisecond in between by a thread
+// that only runs while some watermark does
+class MemoryWatermark
+{
+public:
+    MemoryWatermark();
+    ~MemoryWatermark();
+    MemoryWatermark(const MemoryWatermark &) = delete;
+    MemoryWatermark &operator=(const MemoryWatermark &) = delete;
+
+    void start();
+    void finish();
+
+    // once finished
+    // above what was live at the start
+    std::uint64_t peakBytes() const;
+    // of the whole process, 0 if unknown
+    std::uint64_t peakResident() const;
+
+private:
+    friend class MemorySampler;
+
+    std::uint64_t liveAtStart;
+    std::uint64_t peakLive;
+    std::uint64_t peakRss;
+    bool running;
+};
+
+} // namespace ipk
+
+#endif // MEMORY_H
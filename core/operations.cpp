@@ -0,0 +1,415 @@
+#include "operations.h"
+#include "colortransform.h"
+#include "filters.h"
+#include "frequency.h"
+#include "grayscale.h"
+#include "resample.h"
+#include "trace.h"
+#include "warp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+namespace ipk {
+
+namespace {
+
+inline int toInt(double value)
+{
+    return static_cast<int>(std::lround(value));
+}
+
+// index in (0, count), enums given as numbers
+int choice(const std::vector<double> &p, std::size_t i, int fallback, int count, const char *what)
+{
+    int value = p.size() > i ? toInt(p[i]) : fallback;
+    if (value < 0 || value >= count) {
+        throw std::invalid_argument(std::string("unknown ") + what);
+    }
+    return value;
+}
+
+// 3x3 structure element, all ones unless given
+void structureElement(const std::vector<double> &p, unsigned char element[9])
+{
+    if (!p.empty() && p.size() != 9) {
+        throw std::invalid_argument("a structure element takes 9 values");
+    }
+    for (int k = 0; k < 9; ++k) {
+        element[k] = p.empty() || p[k] != 0.0 ? 1 : 0;
+    }
+}
+
+Image grayscaleOp(const ImageView &src, const std::vector<double> &p)
+{
+    if (src.isGrayscale()) {
+        return src.toImage();
+    }
+    return toGrayscale(src, static_cast<GrayWeights>(choice(p, 0, GrayDefault, 3, "weights")));
+}
+
+Image hsvOp(const ImageView &src, const std::vector<double> &p)
+{
+    return adjustHsv(src, toInt(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2]));
+}
+
+Image linearOp(const ImageView &src, const std::vector<double> &p)
+{
+    return linearTransformation(src, p[0], p[1]);
+}
+
+Image piecewiseOp(const ImageView &src, const std::vector<double> &p)
+{
+    return piecewiseLinearTransformation(src, p[0], p[1], p[2], p[3]);
+}
+
+Image averageOp(const ImageView &src, const std::vector<double> &p)
+{
+    return averageFilter(src, toInt(p[0]));
+}
+
+Image medianOp(const ImageView &src, const std::vector<double> &p)
+{
+    return medianFilter(src, toInt(p[0]));
+}
+
+Image maximumOp(const ImageView &src, const std::vector<double> &p)
+{
+    return maximumFilter(src, toInt(p[0]));
+}
+
+Image minimumOp(const ImageView &src, const std::vector<double> &p)
+{
+    return minimumFilter(src, toInt(p[0]));
+}
+
+Image customOp(const ImageView &src, const std::vector<double> &p)
+{
+    int weights[9];
+    for (int k = 0; k < 9; ++k) {
+        weights[k] = toInt(p[k]);
+    }
+    return customFilter(src, weights);
+}
+
+Image laplacianOp(const ImageView &src, const std::vector<double> &)
+{
+    return laplacianFilter(src);
+}
+
+Image negativeOp(const ImageView &src, const std::vector<double> &)
+{
+    return negative(src);
+}
+
+Image thresholdOp(const ImageView &src, const std::vector<double> &p)
+{
+    return threshold(src, toInt(p[0]));
+}
+
+Image otsuOp(const ImageView &src, const std::vector<double> &)
+{
+    return threshold(src, otsuThreshold(src));
+}
+
+Image erodeOp(const ImageView &src, const std::vector<double> &p)
+{
+    unsigned char element[9];
+    structureElement(p, element);
+    return erode(src, element);
+}
+
+Image dilateOp(const ImageView &src, const std::vector<double> &p)
+{
+    unsigned char element[9];
+    structureElement(p, element);
+    return dilate(src, element);
+}
+
+Image openingOp(const ImageView &src, const std::vector<double> &p)
+{
+    unsigned char element[9];
+    structureElement(p, element);
+    return opening(src, element);
+}
+
+Image closingOp(const ImageView &src, const std::vector<double> &p)
+{
+    unsigned char element[9];
+    structureElement(p, element);
+    return closing(src, element);
+}
+
+Image mirrorOp(const ImageView &src, const std::vector<double> &)
+{
+    return src.mirrored().toImage();
+}
+
+Image flipOp(const ImageView &src, const std::vector<double> &)
+{
+    return src.flipped().toImage();
+}
+
+// size and filter of the result of resize and scale
+void resizeTarget(const ImageView &, const std::vector<double> &p, int &width, int &height, ResampleFilter &filter)
+{
+    filter = static_cast<ResampleFilter>(choice(p, 2, ResampleBilinear, 5, "filter"));
+    width = toInt(p[0]);
+    height = toInt(p[1]);
+}
+
+void scaleTarget(const ImageView &src, const std::vector<double> &p, int &width, int &height, ResampleFilter &filter)
+{
+    filter = static_cast<ResampleFilter>(choice(p, 1, ResampleBilinear, 5, "filter"));
+    width = std::max(1, toInt(src.width()*p[0]));
+    height = std::max(1, toInt(src.height()*p[0]));
+}
+
+Image resizeOp(const ImageView &src, const std::vector<double> &p)
+{
+    int width, height;
+    ResampleFilter filter;
+    resizeTarget(src, p, width, height, filter);
+    return resize(src, width, height, filter);
+}
+
+Image scaleOp(const ImageView &src, const std::vector<double> &p)
+{
+    int width, height;
+    ResampleFilter filter;
+    scaleTarget(src, p, width, height, filter);
+    return resize(src, width, height, filter);
+}
+
+Image rotateOp(const ImageView &src, const std::vector<double> &p)
+{
+    WarpInterpolation interpolation = static_cast<WarpInterpolation>(
+                choice(p, 1, WarpBilinear, 3, "interpolation"));
+    return rotate(src, p[0], interpolation);
+}
+
+Image idealLowPassOp(const ImageView &src, const std::vector<double> &p)
+{
+    return idealLowPassFilter(src, toInt(p[0]));
+}
+
+Image idealHighPassOp(const ImageView &src, const std::vector<double> &p)
+{
+    return idealHighPassFilter(src, toInt(p[0]));
+}
+
+Image butterworthLowPassOp(const ImageView &src, const std::vector<double> &p)
+{
+    return butterworthLowPassFilter(src, toInt(p[0]), toInt(p[1]));
+}
+
+Image butterworthHighPassOp(const ImageView &src, const std::vector<double> &p)
+{
+    return butterworthHighPassFilter(src, toInt(p[0]), toInt(p[1]));
+}
+
+Image homomorphicOp(const ImageView &src, const std::vector<double> &p)
+{
+    return homomorphicFilter(src, p[0], p[1], p[2], toInt(p[3]));
+}
+
+Image spectrumOp(const ImageView &src, const std::vector<double> &)
+{
+    return spectrum(src);
+}
+
+Image ifftOp(const ImageView &src, const std::vector<double> &p)
+{
+    return ifft(src, static_cast<IfftPart>(choice(p, 0, IfftComplete, 3, "IFFT type")));
+}
+
+Image motionBlurOp(const ImageView &src, const std::vector<double> &p)
+{
+    return motionBlur(src, toInt(p[0]), toInt(p[1]));
+}
+
+Image gaussianNoiseOp(const ImageView &src, const std::vector<double> &p)
+{
+    return gaussianNoise(src, p[0]);
+}
+
+Image atmosphericOp(const ImageView &src, const std::vector<double> &p)
+{
+    return atmosphericCirculationBlur(src, p[0]);
+}
+
+Image inverseOp(const ImageView &src, const std::vector<double> &p)
+{
+    NoiseType noise = static_cast<NoiseType>(choice(p, 0, NoiseNone, 2, "noise type"));
+    return inverseFilter(src, noise, toInt(p[1]), p[2], toInt(p[3]), toInt(p[4]));
+}
+
+Image wienerOp(const ImageView &src, const std::vector<double> &p)
+{
+    NoiseType noise = static_cast<NoiseType>(choice(p, 0, NoiseNone, 2, "noise type"));
+    return wienerFilter(src, noise, p[1], toInt(p[2]), toInt(p[3]), p[4]);
+}
+
+int noRadius(const std::vector<double> &)
+{
+    return 0;
+}
+
+int oneRow(const std::vector<double> &)
+{
+    return 1;
+}
+
+int twoRows(const std::vector<double> &)
+{
+    return 2;
+}
+
+// windows reach size/2 rows away at most
+int halfSize(const std::vector<double> &p)
+{
+    return std::max(0, toInt(p[0])/2);
+}
+
+} // namespace
+
+const std::vector<Operation> &operations()
+{
+    static const std::vector<Operation> list = {
+        { "grayscale", "[weights]", "RGB to gray, weights 0 default, 1 BT.601, 2 BT.709", 0, 1, grayscaleOp, noRadius, PointNone },
+        { "hsv", "h,s,v", "rotate hue by h degree, scale saturation and value", 3, 3, hsvOp, noRadius, PointNone },
+        { "linear", "k,b", "k*r + b, on V for RGB images", 2, 2, linearOp, noRadius, PointGrayscale },
+        { "piecewise", "r1,s1,r2,s2", "piecewise linear through (r1, s1) and (r2, s2)", 4, 4, piecewiseOp, noRadius, PointGrayscale },
+        { "average", "size", "size x size average filter", 1, 1, averageOp, halfSize, PointNone },
+        { "median", "size", "size x size median filter", 1, 1, medianOp, halfSize, PointNone },
+        { "max", "size", "size x size maximum filter", 1, 1, maximumOp, halfSize, PointNone },
+        { "min", "size", "size x size minimum filter", 1, 1, minimumOp, halfSize, PointNone },
+        { "custom", "w00,w01,...,w22", "3x3 convolution, weights row by row", 9, 9, customOp, oneRow, PointNone },
+        { "laplacian", "", "laplacian sharpening", 0, 0, laplacianOp, oneRow, PointNone },
+        { "negative", "", "255 - value", 0, 0, negativeOp, noRadius, PointAll },
+        { "threshold", "t", "0 up to t, 255 above, grayscale only", 1, 1, thresholdOp, noRadius, PointGrayscale },
+        { "otsu", "", "threshold by Otsu's method, grayscale only", 0, 0, otsuOp, nullptr, PointNone },
+        { "erode", "[e00,...,e22]", "erosion, 3x3 structure element row by row", 0, 9, erodeOp, oneRow, PointNone },
+        { "dilate", "[e00,...,e22]", "dilation, 3x3 structure element row by row", 0, 9, dilateOp, oneRow, PointNone },
+        { "opening", "[e00,...,e22]", "erosion then dilation", 0, 9, openingOp, twoRows, PointNone },
+        { "closing", "[e00,...,e22]", "dilation then erosion", 0, 9, closingOp, twoRows, PointNone },
+        { "mirror", "", "reverse left and right", 0, 0, mirrorOp, noRadius, PointNone },
+        { "flip", "", "reverse top and bottom", 0, 0, flipOp, nullptr, PointNone },
+        { "resize", "width,height[,filter]",
+          "filter 0 nearest, 1 bilinear, 2 bicubic, 3 lanczos, 4 area", 2, 3, resizeOp, nullptr, PointNone },
+        { "scale", "factor[,filter]", "resize by factor, filters as for resize", 1, 2, scaleOp, nullptr, PointNone },
+        { "rotate", "degree[,interpolation]",
+          "counterclockwise, 0 nearest, 1 bilinear, 2 bicubic", 1, 2, rotateOp, nullptr, PointNone },
+        { "ideal-lowpass", "D0", "ideal low pass filter, grayscale only", 1, 1, idealLowPassOp, nullptr, PointNone },
+        { "ideal-highpass", "D0", "ideal high pass filter, grayscale only", 1, 1, idealHighPassOp, nullptr, PointNone },
+        { "butterworth-lowpass", "order,D0", "Butterworth low pass filter, grayscale only",
+          2, 2, butterworthLowPassOp, nullptr, PointNone },
+        { "butterworth-highpass", "order,D0", "Butterworth high pass filter, grayscale only",
+          2, 2, butterworthHighPassOp, nullptr, PointNone },
+        { "homomorphic", "gammaL,gammaH,c,D0", "homomorphic filter, grayscale only",
+          4, 4, homomorphicOp, nullptr, PointNone },
+        { "spectrum", "", "centred log magnitude of the spectrum", 0, 0, spectrumOp, nullptr, PointNone },
+        { "ifft", "[part]", "FFT and back, keeping 0 all of it, 1 the magnitude, 2 the phase",
+          0, 1, ifftOp, nullptr, PointNone },
+        { "motion-blur", "length,angle", "motion blur of length pixels, rotated by angle degree",
+          2, 2, motionBlurOp, nullptr, PointNone },
+        { "gaussian-noise", "variance", "add gaussian noise", 1, 1, gaussianNoiseOp, nullptr, PointNone },
+        { "atmospheric", "k", "atmospheric turbulence blur, exp(-k*D^(5/3))", 1, 1, atmosphericOp, nullptr, PointNone },
+        { "inverse", "noise,D0,variance,length,angle",
+          "motion blur, noise 0 none or 1 gaussian, then inverse filter within D0",
+          5, 5, inverseOp, nullptr, PointNone },
+        { "wiener", "noise,variance,length,angle,k",
+          "motion blur, noise 0 none or 1 gaussian, then Wiener filter, first channel only",
+          5, 5, wienerOp, nullptr, PointNone }
+    };
+
+    return list;
+}
+
+const Operation *findOperation(const std::string &name)
+{
+    for (const Operation &op : operations()) {
+        if (name == op.name) {
+            return &op;
+        }
+    }
+
+    return nullptr;
+}
+
+Image OperationStep::apply(const ImageView &src) const
+{
+    TraceScope trace(operation->name, "stage");
+    return operation->apply(src, parameters);
+}
+
+std::string OperationStep::toString() const
+{
+    std::ostringstream out;
+    out.precision(12);
+    out << operation->name;
+    for (std::size_t i = 0; i < parameters.size(); ++i) {
+        out << (i == 0 ? ':' : ',') << parameters[i];
+    }
+
+    return out.str();
+}
+
+OperationStep parseOperation(const std::string &text)
+{
+    std::size_t colon = text.find(':');
+    std::string name = text.substr(0, colon);
+
+    OperationStep step;
+    step.operation = findOperation(name);
+    if (!step.operation) {
+        throw std::invalid_argument("unknown operation " + name);
+    }
+
+    if (colon != std::string::npos) {
+        std::istringstream in(text.substr(colon + 1));
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            char *end;
+            double value = std::strtod(item.c_str(), &end);
+            if (item.empty() || *end != '\0') {
+                throw std::invalid_argument("bad parameter '" + item + "' for " + name);
+            }
+            step.parameters.push_back(value);
+        }
+    }
+
+    int count = static_cast<int>(step.parameters.size());
+    if (count < step.operation->minParameters || count > step.operation->maxParameters) {
+        throw std::invalid_argument(name + " takes " + step.operation->parameters);
+    }
+
+    return step;
+}
+
+bool resampleTarget(const OperationStep &step, const ImageView &src, int &width, int &height, ResampleFilter &filter)
+{
+    if (step.operation->apply == resizeOp) {
+        resizeTarget(src, step.parameters, width, height, filter);
+    } else if (step.operation->apply == scaleOp) {
+        scaleTarget(src, step.parameters, width, height, filter);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool grayscaleWeights(const OperationStep &step, GrayWeights &weights)
+{
+    if (step.operation->apply != grayscaleOp) {
+        return false;
+    }
+
+    weights = static_cast<GrayWeights>(choice(step.parameters, 0, GrayDefault, 3, "weights"));
+    return true;
+}
+
+} // namespace ipk
@@ -0,0 +1,66 @@
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+#include "grayscale.h"
+#include "image.h"
+#include "resample.h"
+#include <string>
+#include <vector>
+
+namespace ipk {
+
+// how a pipeline may fuse an operation with its neighbours
+enum PointOperation {
+    // not a lookup table
+    PointNone,
+    // a lookup table on grayscale images, the kernel of anything else
+    PointGrayscale,
+    // the same lookup table on every channel
+    PointAll
+};
+
+// registry of the kernels by name, with numeric parameters
+// nothing here depends on widgets, so the command line can use it
+struct Operation
+{
+    const char *name;
+    // parameters, as shown in the help, optional ones in brackets
+    const char *parameters;
+    const char *description;
+    int minParameters;
+    int maxParameters;
+    Image (*apply)(const ImageView &src, const std::vector<double> &parameters);
+    // rows of src an output row depends on, above and below it,
+    // nullptr if it depends on the whole image or changes its size
+    // an operation with a radius can run on horizontal bands of the image
+    int (*radius)(const std::vector<double> &parameters);
+    PointOperation point;
+};
+
+const std::vector<Operation> &operations();
+// nullptr if there is no such operation
+const Operation *findOperation(const std::string &name);
+
+// an operation with its parameters, written name or name:p1,p2,...
+struct OperationStep
+{
+    const Operation *operation;
+    std::vector<double> parameters;
+
+    Image apply(const ImageView &src) const;
+    std::string toString() const;
+};
+
+// throws std::invalid_argument for unknown names and wrong parameters
+OperationStep parseOperation(const std::string &text);
+
+// for resize and scale, the size and filter of the result of step on src,
+// false for any other operation
+bool resampleTarget(const OperationStep &step, const ImageView &src, int &width, int &height, ResampleFilter &filter);
+// for grayscale, its weights, false for any other operation
+// throws std::invalid_argument for unknown weights
+bool grayscaleWeights(const OperationStep &step, GrayWeights &weights);
+
+} // namespace ipk
+
+#endif // OPERATIONS_H
@@ -0,0 +1,99 @@
+#include "parallel.h"
+#include "trace.h"
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+// per calling thread, so that a batch job running several files at once
+// could give each of its workers a share of the cores
+thread_local int localThreadCount = 0;
+
+} // namespace
+
+int threadCount()
+{
+    if (localThreadCount > 0) {
+        return localThreadCount;
+    }
+
+    int n = static_cast<int>(std::thread::hardware_concurrency());
+    return n > 0 ? n : 1;
+}
+
+void setThreadCount(int count)
+{
+    localThreadCount = std::max(0, count);
+}
+
+void parallelFor(int begin, int end, const std::function<void(int, int)> &body, int minChunk)
+{
+    int total = end - begin;
+    if (total <= 0) {
+        return;
+    }
+
+    minChunk = std::max(1, minChunk);
+    int nChunk = std::min(threadCount(), (total + minChunk - 1)/minChunk);
+    if (nChunk <= 1) {
+        body(begin, end);
+        return;
+    }
+
+    int chunk = (total + nChunk - 1)/nChunk;
+    std::vector<std::thread> workers;
+    workers.reserve(nChunk - 1);
+
+    // the first exception of any chunk, rethrown on the calling thread once
+    // every worker has been joined, a throw leaving a worker would
+    // terminate the process, and so would destroying a joinable one
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto run = [&body, &error, &errorMutex](int first, int last) {
+        try {
+            body(first, last);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    for (int first = begin + chunk; first < end; first += chunk) {
+        int last = std::min(end, first + chunk);
+        workers.emplace_back([&run, first, last]() {
+            // workers must not spawn threads of their own
+            setThreadCount(1);
+            setTraceThreadName("parallelFor worker");
+            TraceScope trace("chunk", "worker");
+            run(first, last);
+        });
+    }
+    {
+        // the calling thread is a worker too for its own chunk
+        // so nested loops stay serial, and it gets its count back afterwards
+        struct Restore
+        {
+            int count;
+            ~Restore() { localThreadCount = count; }
+        } restore = { localThreadCount };
+        localThreadCount = 1;
+        TraceScope trace("chunk", "worker");
+        run(begin, std::min(end, begin + chunk));
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace ipk
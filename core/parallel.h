@@ -0,0 +1,25 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+namespace ipk {
+
+// number of worker threads used by the kernels
+// defaults to the number of hardware threads
+int threadCount();
+// set the number of worker threads for kernels started from the calling thread
+// 0 means use all hardware threads
+void setThreadCount(int count);
+
+// split [begin, end) into contiguous chunks, one per worker thread,
+// and call body(first, last) for each chunk
+// blocks until all chunks are done, the calling thread takes the first chunk
+// chunks are never smaller than minChunk (except the last one)
+// if body throws, the first exception is rethrown on the calling thread
+// once all chunks are done
+void parallelFor(int begin, int end, const std::function<void(int, int)> &body, int minChunk = 1);
+
+} // namespace ipk
+
+#endif // PARALLEL_H
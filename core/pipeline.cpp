@@ -0,0 +1,218 @@
+#include "pipeline.h"
+#include "filters.h"
+#include "parallel.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace ipk {
+
+namespace {
+
+// a step of the schedule, a single operation or a fused lookup table
+struct Stage
+{
+    // nullptr for a lookup table
+    const OperationStep *step;
+    unsigned char lut[256];
+    // -1 if the whole image is needed
+    int radius;
+    // steps done once this stage is
+    std::size_t end;
+
+    Image apply(const ImageView &src) const
+    {
+        if (step) {
+            return step->apply(src);
+        }
+        TraceScope trace("lookup table", "stage");
+        return applyLut(src, lut);
+    }
+};
+
+// a point operation is its result on the 256 gray levels
+void pointTable(const OperationStep &step, unsigned char table[256])
+{
+    Image ramp(256, 1, 1);
+    for (int i = 0; i < 256; ++i) {
+        ramp.scanLine(0)[i] = static_cast<unsigned char>(i);
+    }
+
+    Image mapped = step.apply(ramp);
+    if (mapped.width() != 256 || mapped.height() != 1 || mapped.channels() != 1) {
+        throw std::logic_error(std::string(step.operation->name) + " is not a point operation");
+    }
+    std::memcpy(table, mapped.scanLine(0), 256);
+}
+
+std::vector<Stage> schedule(const std::vector<OperationStep> &steps, int channels)
+{
+    std::vector<Stage> stages;
+
+    for (std::size_t k = 0; k < steps.size(); ++k) {
+        const OperationStep &step = steps[k];
+        const Operation &op = *step.operation;
+        // only decides whether grayscale-only point operations are fused,
+        // so it need not be exact: the Wiener filter, say, gives a single
+        // channel too, its point operations after it are just run alone
+        if (std::strcmp(op.name, "grayscale") == 0) {
+            channels = 1;
+        }
+
+        if (op.point == PointAll || (op.point == PointGrayscale && channels == 1)) {
+            unsigned char table[256];
+            pointTable(step, table);
+            if (!stages.empty() && !stages.back().step) {
+                Stage &last = stages.back();
+                for (int i = 0; i < 256; ++i) {
+                    last.lut[i] = table[last.lut[i]];
+                }
+                last.end = k + 1;
+                continue;
+            }
+
+            Stage stage;
+            stage.step = nullptr;
+            std::memcpy(stage.lut, table, 256);
+            stage.radius = 0;
+            stage.end = k + 1;
+            stages.push_back(stage);
+        } else {
+            Stage stage;
+            stage.step = &step;
+            stage.radius = op.radius ? op.radius(step.parameters) : -1;
+            stage.end = k + 1;
+            stages.push_back(stage);
+        }
+    }
+
+    return stages;
+}
+
+// stages [first, last) band by band, every band is extended by halo rows
+// above and below, so its middle rows come out just like for the whole image
+Image runBands(const ImageView &src, const std::vector<Stage> &stages, std::size_t first, std::size_t last, int halo)
+{
+    // a band should about fit in L2, but halo rows are done twice,
+    // so bands are kept many times higher than the halo
+    const int rows = std::max(std::max(32, 16*halo), (1 << 19)/std::max(1, src.width()*src.channels()));
+    const int bands = (src.height() + rows - 1)/rows;
+
+    // the channels of the result, from a single pixel, which also throws
+    // for steps that don't take src here rather than in a band
+    Image probe = src.cropped(0, 0, 1, 1).toImage();
+    for (std::size_t i = first; i < last; ++i) {
+        probe = stages[i].apply(probe);
+    }
+    Image dst(src.width(), src.height(), probe.channels());
+
+    TraceScope trace("fused bands", "stage");
+    parallelFor(0, bands, [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            TraceScope bandTrace("band", "worker");
+            const int y0 = b*rows;
+            const int y1 = std::min(src.height(), y0 + rows);
+            const int top = std::max(0, y0 - halo);
+            const int bottom = std::min(src.height(), y1 + halo);
+
+            Image band;
+            ImageView current = src.cropped(0, top, src.width(), bottom - top);
+            for (std::size_t i = first; i < last; ++i) {
+                band = stages[i].apply(current);
+                current = band;
+            }
+            copyPixels(current.cropped(0, y0 - top, current.width(), y1 - y0),
+                       ImageView(dst).cropped(0, y0, dst.width(), y1 - y0));
+        }
+    });
+
+    return dst;
+}
+
+} // namespace
+
+void Pipeline::append(const Pipeline &other)
+{
+    list.insert(list.end(), other.list.begin(), other.list.end());
+}
+
+Image Pipeline::run(const ImageView &src) const
+{
+    return run(src, std::function<void(std::size_t, const Image &)>());
+}
+
+Image Pipeline::run(const ImageView &src, const std::function<void(std::size_t, const Image &)> &done) const
+{
+    if (list.empty()) {
+        return src.toImage();
+    }
+
+    const std::vector<Stage> stages = schedule(list, src.channels());
+    Image result;
+    ImageView current = src;
+
+    for (std::size_t i = 0; i < stages.size();) {
+        // local stages from i up to j
+        std::size_t j = i;
+        int halo = 0;
+        while (j < stages.size() && stages[j].radius >= 0) {
+            halo += stages[j].radius;
+            ++j;
+        }
+
+        if (j - i > 1) {
+            result = runBands(current, stages, i, j, halo);
+            i = j;
+        } else {
+            result = stages[i].apply(current);
+            ++i;
+        }
+        if (done) {
+            done(stages[i - 1].end, result);
+        }
+        current = result;
+    }
+
+    return result;
+}
+
+std::string Pipeline::toString() const
+{
+    std::string text;
+
+    for (const OperationStep &step : list) {
+        text += step.toString() + '\n';
+    }
+
+    return text;
+}
+
+Pipeline Pipeline::fromString(const std::string &text)
+{
+    Pipeline pipeline;
+    std::istringstream in(text);
+    std::string line;
+
+    for (int number = 1; std::getline(in, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        const std::size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            continue;
+        }
+        line = line.substr(begin, line.find_last_not_of(" \t\r") + 1 - begin);
+
+        try {
+            pipeline.append(parseOperation(line));
+        } catch (const std::invalid_argument &e) {
+            std::ostringstream message;
+            message << "line " << number << ": " << e.what();
+            throw std::invalid_argument(message.str());
+        }
+    }
+
+    return pipeline;
+}
+
+} // namespace ipk
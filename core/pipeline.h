@@ -0,0 +1,50 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "image.h"
+#include "operations.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ipk {
+
+// ordered list of operations, run one after another in memory
+//
+// run() doesn't just apply the steps in turn:
+// neighbouring point operations are fused into a single lookup table,
+// and runs of local operations (filters, morphology, lookup tables)
+// are done band by band, each band with enough extra rows above and
+// below for all of them, so the intermediate images stay in cache
+// the result is the same as applying the steps one by one
+//
+// written as text, one step per line in the syntax of parseOperation(),
+// empty lines and anything after '#' are ignored
+class Pipeline
+{
+public:
+    const std::vector<OperationStep> &steps() const { return list; }
+    bool isEmpty() const { return list.empty(); }
+    void append(const OperationStep &step) { list.push_back(step); }
+    void append(const Pipeline &other);
+    // throws std::out_of_range for a bad index
+    void replace(std::size_t index, const OperationStep &step) { list.at(index) = step; }
+    void clear() { list.clear(); }
+
+    Image run(const ImageView &src) const;
+    // the same, and done(n, image) each time the output of the first n
+    // steps is a whole image, after each stage, fused ones included
+    Image run(const ImageView &src, const std::function<void(std::size_t, const Image &)> &done) const;
+
+    std::string toString() const;
+    // throws std::invalid_argument with the line number for bad lines
+    static Pipeline fromString(const std::string &text);
+
+private:
+    std::vector<OperationStep> list;
+};
+
+} // namespace ipk
+
+#endif // PIPELINE_H
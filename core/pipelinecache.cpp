@@ -0,0 +1,176 @@
+#include "pipelinecache.h"
+#include "frequency.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace ipk {
+
+namespace {
+
+const std::uint64_t fnvOffset = 14695981039346656037ULL;
+const std::uint64_t fnvPrime = 1099511628211ULL;
+
+inline std::uint64_t combine(std::uint64_t seed, std::uint64_t value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// FNV-1a, 8 bytes at a time
+std::uint64_t hashBytes(const unsigned char *p, int n)
+{
+    std::uint64_t h = fnvOffset;
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = (h ^ word)*fnvPrime;
+    }
+    for (; i < n; ++i) {
+        h = (h ^ p[i])*fnvPrime;
+    }
+
+    return h;
+}
+
+} // namespace
+
+std::uint64_t hashImage(const ImageView &src)
+{
+    const int n = src.width()*src.channels();
+    std::vector<std::uint64_t> rows(src.height());
+
+    parallelFor(0, src.height(), [&](int first, int last) {
+        std::vector<unsigned char> buffer(src.isMirrored() ? n + 64 : 0);
+        for (int y = first; y < last; ++y) {
+            rows[y] = hashBytes(src.readRow(y, buffer.data()), n);
+        }
+    }, std::max(1, (1 << 16)/std::max(1, n)));
+
+    std::uint64_t h = combine(combine(combine(fnvOffset, src.width()), src.height()), src.channels());
+    for (std::uint64_t row : rows) {
+        h = combine(h, row);
+    }
+
+    return h;
+}
+
+PipelineCache::PipelineCache(std::size_t budget) :
+    limit(budget), used(0)
+{
+}
+
+std::size_t PipelineCache::budget() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return limit;
+}
+
+void PipelineCache::setBudget(std::size_t budget)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    limit = budget;
+    evict(0);
+}
+
+std::size_t PipelineCache::memoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return used;
+}
+
+void PipelineCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    order.clear();
+    used = 0;
+}
+
+Image PipelineCache::run(const Pipeline &pipeline, const ImageView &src, std::vector<bool> *reused)
+{
+    const std::vector<OperationStep> &steps = pipeline.steps();
+    if (reused) {
+        reused->assign(steps.size(), false);
+    }
+    if (steps.empty()) {
+        return src.toImage();
+    }
+
+    // key of a step follows from the key of the one before it,
+    // frequency steps give other outputs in the other precision
+    std::vector<std::uint64_t> keys(steps.size());
+    std::uint64_t key = combine(hashImage(src), fftPrecision());
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        key = combine(key, std::hash<std::string>()(steps[i].toString()));
+        keys[i] = key;
+    }
+
+    // go on from the last output in the cache
+    Image result;
+    std::size_t first = steps.size();
+    while (first > 0 && !find(keys[first - 1], result)) {
+        --first;
+    }
+    if (reused) {
+        std::fill(reused->begin(), reused->begin() + first, true);
+    }
+
+    if (first == steps.size()) {
+        return result;
+    }
+
+    // the rest runs fused and banded like any pipeline, the outputs
+    // between its stages are kept
+    Pipeline rest;
+    for (std::size_t i = first; i < steps.size(); ++i) {
+        rest.append(steps[i]);
+    }
+
+    return rest.run(first > 0 ? ImageView(result) : src, [&](std::size_t done, const Image &image) {
+        insert(keys[first + done - 1], image);
+    });
+}
+
+bool PipelineCache::find(std::uint64_t key, Image &image)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+
+    order.splice(order.begin(), order, it->second.position);
+    image = it->second.image;
+
+    return true;
+}
+
+void PipelineCache::insert(std::uint64_t key, const Image &image)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (image.byteCount() > limit || entries.count(key)) {
+        return;
+    }
+
+    evict(image.byteCount());
+    order.push_front(key);
+    Entry entry = { image, order.begin() };
+    entries.emplace(key, entry);
+    used += image.byteCount();
+}
+
+void PipelineCache::evict(std::size_t bytes)
+{
+    while (!order.empty() && used + bytes > limit) {
+        auto it = entries.find(order.back());
+        used -= it->second.image.byteCount();
+        entries.erase(it);
+        order.pop_back();
+    }
+}
+
+} // namespace ipk
@@ -0,0 +1,68 @@
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include "image.h"
+#include "pipeline.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ipk {
+
+// hash of the size and the pixels of src, rows are hashed in parallel
+std::uint64_t hashImage(const ImageView &src);
+
+// outputs of pipeline steps, kept for the next run
+//
+// the output of a step is keyed by a hash of the input image, of
+// fftPrecision() and of every step up to it, parameters included,
+// so after a change to one step a run starts from the last output
+// kept before it, and only the steps from there on are done again
+// the steps not in the cache run through Pipeline::run(), fused and
+// banded, so the outputs kept are those between its stages, steps
+// fused into a lookup table or a band have none of their own
+//
+// the least recently used outputs are dropped once they take more
+// than the budget, results share their pixels with the cache,
+// which is fine as nothing writes into an image once made
+class PipelineCache
+{
+public:
+    explicit PipelineCache(std::size_t budget = std::size_t(512) << 20);
+
+    std::size_t budget() const;
+    void setBudget(std::size_t budget);
+    // bytes of pixels held
+    std::size_t memoryUsage() const;
+    void clear();
+
+    // same result as pipeline.run(src), through the cache
+    // reused gets, for each step, whether it was skipped thanks to the cache
+    Image run(const Pipeline &pipeline, const ImageView &src, std::vector<bool> *reused = nullptr);
+
+private:
+    struct Entry
+    {
+        Image image;
+        std::list<std::uint64_t>::iterator position;
+    };
+
+    bool find(std::uint64_t key, Image &image);
+    void insert(std::uint64_t key, const Image &image);
+    // drop entries until bytes more fit in the budget
+    void evict(std::size_t bytes);
+
+    mutable std::mutex mutex;
+    std::size_t limit;
+    std::size_t used;
+    // keys, the most recently used first
+    std::list<std::uint64_t> order;
+    std::unordered_map<std::uint64_t, Entry> entries;
+};
+
+} // namespace ipk
+
+#endif // PIPELINECACHE_H
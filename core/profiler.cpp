@@ -0,0 +1,108 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ipk {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+thread_local OperationTimer *currentOperation = nullptr;
+thread_local ScopedTimer *currentTimer = nullptr;
+
+double milliseconds(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+OperationTimer::OperationTimer(const std::string &operation, std::uint64_t pixels) :
+    trace(operation, "operation"),
+    start(Clock::now()),
+    allocatedAtStart(allocatedBytes()),
+    outer(currentOperation),
+    running(true)
+{
+    profile.operation = operation;
+    profile.pixels = pixels;
+    currentOperation = this;
+    memory.start();
+}
+
+OperationTimer::~OperationTimer()
+{
+    finish();
+}
+
+void OperationTimer::setPixels(std::uint64_t pixels)
+{
+    profile.pixels = pixels;
+}
+
+OperationProfile OperationTimer::finish()
+{
+    if (running) {
+        running = false;
+        profile.milliseconds = milliseconds(start, Clock::now());
+        profile.bytesAllocated = allocatedBytes() - allocatedAtStart;
+        memory.finish();
+        profile.peakBytes = memory.peakBytes();
+        profile.peakResident = memory.peakResident();
+        if (currentOperation == this) {
+            currentOperation = outer;
+        }
+    }
+
+    return profile;
+}
+
+void OperationTimer::addPhase(const char *name, double milliseconds, const MemoryWatermark &memory)
+{
+    for (PhaseTime &phase : profile.phases) {
+        if (std::strcmp(phase.name, name) == 0) {
+            phase.milliseconds += milliseconds;
+            phase.peakBytes = std::max(phase.peakBytes, memory.peakBytes());
+            phase.peakResident = std::max(phase.peakResident, memory.peakResident());
+            return;
+        }
+    }
+
+    profile.phases.push_back({ name, milliseconds, memory.peakBytes(), memory.peakResident() });
+}
+
+ScopedTimer::ScopedTimer(const char *phase) :
+    trace(phase, "phase"),
+    phase(phase),
+    operation(currentOperation),
+    parent(nullptr),
+    nestedMilliseconds(0)
+{
+    if (operation) {
+        parent = currentTimer;
+        currentTimer = this;
+        memory.start();
+        start = Clock::now();
+    }
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    if (!operation) {
+        return;
+    }
+
+    const double total = milliseconds(start, Clock::now());
+    memory.finish();
+    currentTimer = parent;
+    // the parent doesn't count this time as its own
+    if (parent && parent->operation == operation) {
+        parent->nestedMilliseconds += total;
+    }
+    if (operation->running) {
+        operation->addPhase(phase, total - nestedMilliseconds, memory);
+    }
+}
+
+} // namespace ipk
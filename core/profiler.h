@@ -0,0 +1,100 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "memory.h"
+#include "trace.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ipk {
+
+// where the time of an operation goes
+// an OperationTimer profiles what the calling thread does while it exists,
+// every ScopedTimer of that thread adds its time to a phase of it,
+// less the time of the timers nested in it
+// with no OperationTimer, a ScopedTimer reads a thread local and that's all
+// while tracing (see trace.h), both are traced too
+// both follow the memory taken too, see memory.h, the peaks of an
+// operation or phase count whatever other threads allocate meanwhile
+
+struct PhaseTime
+{
+    // the string literal given to ScopedTimer
+    const char *name;
+    double milliseconds;
+    // the highest of any of its runs, as in OperationProfile
+    std::uint64_t peakBytes;
+    std::uint64_t peakResident;
+};
+
+struct OperationProfile
+{
+    std::string operation;
+    // from start to finish, in phases or not
+    double milliseconds = 0;
+    // in the order they first ended, each phase once
+    std::vector<PhaseTime> phases;
+    // pixel buffers allocated while it ran, by any thread
+    std::uint64_t bytesAllocated = 0;
+    // most pixel buffer bytes live at once, above those live at its start
+    std::uint64_t peakBytes = 0;
+    // largest resident set of the process, CImg temporaries included,
+    // 0 if unknown
+    std::uint64_t peakResident = 0;
+    // pixels processed, 0 if unknown
+    std::uint64_t pixels = 0;
+};
+
+class OperationTimer
+{
+public:
+    explicit OperationTimer(const std::string &operation, std::uint64_t pixels = 0);
+    ~OperationTimer();
+    OperationTimer(const OperationTimer &) = delete;
+    OperationTimer &operator=(const OperationTimer &) = delete;
+
+    void setPixels(std::uint64_t pixels);
+    // stop, nothing is added after that
+    OperationProfile finish();
+
+private:
+    friend class ScopedTimer;
+    void addPhase(const char *name, double milliseconds, const MemoryWatermark &memory);
+
+    TraceScope trace;
+    MemoryWatermark memory;
+    OperationProfile profile;
+    std::chrono::steady_clock::time_point start;
+    std::uint64_t allocatedAtStart;
+    // an operation run by another one, its phases go to the inner one only
+    OperationTimer *outer;
+    bool running;
+};
+
+class ScopedTimer
+{
+public:
+    // phase must outlive the profile, a string literal that is
+    explicit ScopedTimer(const char *phase);
+    ~ScopedTimer();
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    TraceScope trace;
+    // started only when an operation is profiled
+    MemoryWatermark memory;
+    const char *phase;
+    // null when no operation is profiled
+    OperationTimer *operation;
+    ScopedTimer *parent;
+    std::chrono::steady_clock::time_point start;
+    double nestedMilliseconds;
+};
+
+} // namespace ipk
+
+#endif // PROFILER_H
@@ -0,0 +1,194 @@
+#include "pyramid.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "resample.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+// sum of two rows, n samples, sum needs room for 16 more
+void sumRows(const unsigned char *r0, const unsigned char *r1, int n, std::uint16_t *sum)
+{
+    int x = 0;
+
+#ifdef IPK_SSE2
+    // rows may be read up to 64 bytes past their end
+    const __m128i zero = _mm_setzero_si128();
+    for (; x < n; x += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r0 + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r1 + x));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(sum + x), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(sum + x + 8), hi);
+    }
+#endif
+
+    for (; x < n; ++x) {
+        sum[x] = static_cast<std::uint16_t>(r0[x] + r1[x]);
+    }
+}
+
+// pairs of pixels of the summed rows to a row of averages
+void halveRow(const std::uint16_t *sum, int outWidth, int channels, unsigned char *dst)
+{
+    int x = 0;
+
+#ifdef IPK_SSE2
+    if (channels == 1) {
+        // 8 pixels a time, adjacent pairs summed by madd
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i two = _mm_set1_epi32(2);
+        for (; x + 8 <= outWidth; x += 8) {
+            __m128i a = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(sum + 2*x)), ones);
+            __m128i b = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(sum + 2*x + 8)), ones);
+            a = _mm_srli_epi32(_mm_add_epi32(a, two), 2);
+            b = _mm_srli_epi32(_mm_add_epi32(b, two), 2);
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), a);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), packed);
+        }
+    }
+#endif
+
+    for (; x < outWidth; ++x) {
+        const std::uint16_t *p = sum + 2*x*channels;
+        for (int c = 0; c < channels; ++c) {
+            dst[x*channels + c] = static_cast<unsigned char>((p[c] + p[channels + c] + 2) >> 2);
+        }
+    }
+}
+
+} // namespace
+
+Image halve(const ImageView &src)
+{
+    if (src.isNull()) {
+        return Image();
+    }
+
+    const int width = src.width();
+    const int height = src.height();
+    const int channels = src.channels();
+    const int n = width*channels;
+    Image dst((width + 1)/2, (height + 1)/2, channels);
+
+    parallelFor(0, dst.height(), [&](int first, int last) {
+        // room for a repeated last pixel, and for the SIMD tails
+        std::vector<std::uint16_t> sum(n + channels + 16);
+        std::vector<unsigned char> buffer0(n + 64), buffer1(n + 64);
+        for (int y = first; y < last; ++y) {
+            const unsigned char *r0 = src.readRow(2*y, buffer0.data());
+            const unsigned char *r1 = src.readRow(std::min(2*y + 1, height - 1), buffer1.data());
+            sumRows(r0, r1, n, sum.data());
+            if (width % 2) {
+                std::copy(sum.begin() + (n - channels), sum.begin() + n, sum.begin() + n);
+            }
+            halveRow(sum.data(), dst.width(), channels, dst.scanLine(y));
+        }
+    }, 16);
+
+    return dst;
+}
+
+ImagePyramid::ImagePyramid(const Image &img, int minSize) :
+    d(std::make_shared<Data>())
+{
+    if (img.isNull()) {
+        d.reset();
+        return;
+    }
+
+    // each level depends on the one before, so the rows of a level are done in parallel
+    ScopedTimer timer("pyramid");
+    d->levels.push_back(img);
+    while (std::max(d->levels.back().width(), d->levels.back().height()) > std::max(1, minSize)) {
+        d->levels.push_back(halve(d->levels.back()));
+    }
+    d->laplacians.resize(d->levels.size());
+}
+
+Image ImagePyramid::level(int k) const
+{
+    if (k < 0 || k >= levelCount()) {
+        throw std::out_of_range("ImagePyramid::level: no such level");
+    }
+
+    return d->levels[k];
+}
+
+int ImagePyramid::levelForScale(double scale) const
+{
+    if (!d || scale >= 1.0) {
+        return 0;
+    }
+
+    const Image &img = d->levels.front();
+    int k = 0;
+    while (k + 1 < levelCount()
+           && d->levels[k + 1].width() >= scale*img.width()
+           && d->levels[k + 1].height() >= scale*img.height()) {
+        ++k;
+    }
+
+    return k;
+}
+
+Image ImagePyramid::laplacian(int k) const
+{
+    if (k < 0 || k >= levelCount()) {
+        throw std::out_of_range("ImagePyramid::laplacian: no such level");
+    }
+    if (k + 1 == levelCount()) {
+        return d->levels[k];
+    }
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    if (!d->laplacians[k].isNull()) {
+        return d->laplacians[k];
+    }
+
+    const Image &fine = d->levels[k];
+    const Image up = resize(d->levels[k + 1], fine.width(), fine.height(), ResampleBilinear);
+    Image lap = fine.sameSize();
+    const int n = fine.width()*fine.channels();
+    parallelFor(0, fine.height(), [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            const unsigned char *a = fine.scanLine(y);
+            const unsigned char *b = up.scanLine(y);
+            unsigned char *out = lap.scanLine(y);
+            for (int x = 0; x < n; ++x) {
+                out[x] = static_cast<unsigned char>(std::min(255, std::max(0, a[x] - b[x] + 128)));
+            }
+        }
+    }, 16);
+
+    d->laplacians[k] = lap;
+    return lap;
+}
+
+std::size_t ImagePyramid::memoryUsage() const
+{
+    if (!d) {
+        return 0;
+    }
+
+    std::size_t total = 0;
+    for (const Image &img : d->levels) {
+        total += img.byteCount();
+    }
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    for (const Image &img : d->laplacians) {
+        total += img.byteCount();
+    }
+
+    return total;
+}
+
+} // namespace ipk
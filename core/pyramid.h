@@ -0,0 +1,62 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include "image.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ipk {
+
+// src at half its size, rounded up, every pixel the rounded average
+// of a 2 x 2 block, the last column and row of odd sizes are repeated
+// rows are done in parallel, the sums with SIMD
+Image halve(const ImageView &src);
+
+// multi-resolution pyramid of an image
+//
+// level 0 is the image itself, every level after it is halve() of the
+// one before, down to a level that fits in minSize x minSize
+// all of them are made up front, only the Laplacian levels are made
+// when first asked for
+//
+// copies share the levels, like copies of an Image share the pixels
+class ImagePyramid
+{
+public:
+    ImagePyramid() {}
+    explicit ImagePyramid(const Image &img, int minSize = 1);
+
+    bool isNull() const { return !d; }
+    int levelCount() const { return d ? static_cast<int>(d->levels.size()) : 0; }
+    // throws std::out_of_range for a bad level
+    Image level(int k) const;
+    Image image() const { return level(0); }
+    // the smallest level still at least scale times the size of the image,
+    // level 0 for scales of 1 and more
+    int levelForScale(double scale) const;
+    Image atScale(double scale) const { return level(levelForScale(scale)); }
+
+    // level k minus level k + 1 brought back to its size, offset by 128
+    // and clamped to bytes, the last level is just the last level
+    // throws std::out_of_range for a bad level
+    Image laplacian(int k) const;
+
+    // bytes of the levels, the image itself and the Laplacian levels made so far included
+    std::size_t memoryUsage() const;
+
+private:
+    struct Data
+    {
+        std::vector<Image> levels;
+        std::mutex mutex;
+        std::vector<Image> laplacians;
+    };
+
+    std::shared_ptr<Data> d;
+};
+
+} // namespace ipk
+
+#endif // PYRAMID_H
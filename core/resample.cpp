@@ -0,0 +1,381 @@
+#include "resample.h"
+#include "parallel.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+// weights are Q14 fixed point
+const int precision = 14;
+const int rounding = 1 << (precision - 1);
+
+double pi()
+{
+    return 3.14159265358979323846;
+}
+
+double sinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= pi();
+    return std::sin(x)/x;
+}
+
+double filterSupport(ResampleFilter filter)
+{
+    switch (filter) {
+    case ResampleBicubic:
+        return 2.0;
+    case ResampleLanczos3:
+        return 3.0;
+    default:
+        return 1.0;
+    }
+}
+
+double filterWeight(ResampleFilter filter, double x)
+{
+    x = std::fabs(x);
+
+    switch (filter) {
+    case ResampleBicubic:
+        // Keys cubic convolution, a = -0.5
+        if (x < 1.0) {
+            return (1.5*x - 2.5)*x*x + 1.0;
+        } else if (x < 2.0) {
+            return ((-0.5*x + 2.5)*x - 4.0)*x + 2.0;
+        }
+        return 0.0;
+    case ResampleLanczos3:
+        return x < 3.0 ? sinc(x)*sinc(x/3.0) : 0.0;
+    default:
+        // triangle
+        return x < 1.0 ? 1.0 - x : 0.0;
+    }
+}
+
+// weight table of one axis
+// output i = sum of weights[i*stride + k]*input[first[i] + k], k < taps
+// stride is taps rounded up to 8, the extra weights are zero
+struct Coefficients
+{
+    int taps;
+    int stride;
+    std::vector<int> first;
+    std::vector<std::int16_t> weights;
+};
+
+Coefficients coefficients(int inSize, int outSize, ResampleFilter filter)
+{
+    const double scale = static_cast<double>(inSize)/outSize;
+    std::vector<std::vector<double> > raw(outSize);
+    std::vector<int> lo(outSize);
+
+    for (int i = 0; i < outSize; ++i) {
+        std::vector<double> &w = raw[i];
+
+        if (filter == ResampleNearest) {
+            lo[i] = std::min(inSize - 1, static_cast<int>((i + 0.5)*scale));
+            w.assign(1, 1.0);
+        } else if (filter == ResampleArea) {
+            // overlap of [a, b) with every source pixel [x, x + 1)
+            double a = i*scale, b = std::min((i + 1)*scale, static_cast<double>(inSize));
+            lo[i] = std::min(inSize - 1, static_cast<int>(a));
+            for (int x = lo[i]; x < b; ++x) {
+                w.push_back(std::min(b, x + 1.0) - std::max(a, static_cast<double>(x)));
+            }
+        } else {
+            // widen the filter when downscaling
+            double factor = std::max(1.0, scale);
+            double support = filterSupport(filter)*factor;
+            double center = (i + 0.5)*scale;
+            int begin = static_cast<int>(std::floor(center - support));
+            int end = static_cast<int>(std::ceil(center + support));
+            lo[i] = std::min(inSize - 1, std::max(0, begin));
+            w.assign(std::min(inSize - 1, std::max(0, end)) - lo[i] + 1, 0.0);
+            for (int x = begin; x <= end; ++x) {
+                // replicate border pixels
+                int xx = std::min(inSize - 1, std::max(0, x));
+                w[xx - lo[i]] += filterWeight(filter, (x + 0.5 - center)/factor);
+            }
+        }
+
+        // trim zero weights at both ends
+        while (w.size() > 1 && w.back() == 0.0) {
+            w.pop_back();
+        }
+        while (w.size() > 1 && w.front() == 0.0) {
+            w.erase(w.begin());
+            ++lo[i];
+        }
+        double sum = 0.0;
+        for (double v : w) {
+            sum += v;
+        }
+        if (sum == 0.0) {
+            // might only happen with extreme upscale of lanczos, fall back to nearest
+            lo[i] = std::min(inSize - 1, static_cast<int>((i + 0.5)*scale));
+            w.assign(1, 1.0);
+        }
+    }
+
+    Coefficients table;
+    table.taps = 1;
+    for (int i = 0; i < outSize; ++i) {
+        table.taps = std::max(table.taps, static_cast<int>(raw[i].size()));
+    }
+    table.taps = std::min(table.taps, inSize);
+    table.stride = (table.taps + 7) & ~7;
+    table.first.resize(outSize);
+    table.weights.assign(static_cast<std::size_t>(outSize)*table.stride, 0);
+
+    for (int i = 0; i < outSize; ++i) {
+        // all outputs use the same number of taps, keep them inside the input
+        int first = std::min(lo[i], inSize - table.taps);
+        int offset = lo[i] - first;
+        double sum = 0.0;
+        for (double v : raw[i]) {
+            sum += v;
+        }
+
+        // quantize, and give the rounding error to the largest weight,
+        // so that weights sum to exactly 1 << precision
+        std::int16_t *w = &table.weights[static_cast<std::size_t>(i)*table.stride];
+        int total = 0, largest = offset;
+        for (std::size_t k = 0; k < raw[i].size(); ++k) {
+            int q = static_cast<int>(std::lround(raw[i][k]/sum*(1 << precision)));
+            w[offset + k] = static_cast<std::int16_t>(q);
+            total += q;
+            if (std::abs(q) > std::abs(w[largest])) {
+                largest = offset + static_cast<int>(k);
+            }
+        }
+        w[largest] = static_cast<std::int16_t>(w[largest] + (1 << precision) - total);
+        table.first[i] = first;
+    }
+
+    return table;
+}
+
+inline unsigned char clampByte(int value)
+{
+    value = (value + rounding) >> precision;
+    return static_cast<unsigned char>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+#ifdef IPK_SSE2
+inline __m128i loadPixel(const unsigned char *p)
+{
+    std::int32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return _mm_cvtsi32_si128(v);
+}
+
+inline __m128i weightPair(const std::int16_t *w)
+{
+    return _mm_set1_epi32((static_cast<std::uint16_t>(w[1]) << 16) | static_cast<std::uint16_t>(w[0]));
+}
+#endif
+
+// horizontal pass over one row
+void horizontalRow(const unsigned char *src, unsigned char *dst, int outWidth, int channels,
+                   const Coefficients &table)
+{
+    for (int x = 0; x < outWidth; ++x) {
+        const std::int16_t *w = &table.weights[static_cast<std::size_t>(x)*table.stride];
+        const unsigned char *p = src + table.first[x]*channels;
+        unsigned char *out = dst + x*channels;
+
+#ifdef IPK_SSE2
+        if (channels == 1) {
+            // 8 taps per madd
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = zero;
+            for (int k = 0; k < table.taps; k += 8) {
+                __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + k)), zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + k))));
+            }
+            acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+            acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+            out[0] = clampByte(_mm_cvtsi128_si32(acc));
+            continue;
+        } else if (channels == 3) {
+            // 2 taps per madd, all 3 channels at once
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = zero;
+            for (int k = 0; k < table.taps; k += 2) {
+                __m128i v = _mm_unpacklo_epi8(loadPixel(p + 3*k), loadPixel(p + 3*k + 3));
+                v = _mm_unpacklo_epi8(v, zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(v, weightPair(w + k)));
+            }
+            acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(rounding)), precision);
+            acc = _mm_packus_epi16(_mm_packs_epi32(acc, zero), zero);
+            std::int32_t rgb = _mm_cvtsi128_si32(acc);
+            std::memcpy(out, &rgb, 3);
+            continue;
+        }
+#endif
+        for (int c = 0; c < channels; ++c) {
+            int acc = 0;
+            for (int k = 0; k < table.taps; ++k) {
+                acc += w[k]*p[k*channels + c];
+            }
+            out[c] = clampByte(acc);
+        }
+    }
+}
+
+// vertical pass, rows are the source rows of the taps
+void verticalRow(const unsigned char *const *rows, const std::int16_t *w, int taps,
+                 unsigned char *dst, int rowSize)
+{
+    int x = 0;
+
+#ifdef IPK_SSE2
+    // 16 samples a time, rows are padded to 64 bytes, so the last load
+    // and store stay inside the row
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(rounding);
+    for (; x < rowSize; x += 16) {
+        __m128i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+        for (int k = 0; k < taps; k += 2) {
+            // pair the last odd tap with itself, its partner weight is zero
+            const unsigned char *r0 = rows[k];
+            const unsigned char *r1 = k + 1 < taps ? rows[k + 1] : rows[k];
+            std::int16_t pair[2] = { w[k], static_cast<std::int16_t>(k + 1 < taps ? w[k + 1] : 0) };
+            __m128i wp = weightPair(pair);
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r0 + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r1 + x));
+            __m128i lo = _mm_unpacklo_epi8(a, b);
+            __m128i hi = _mm_unpackhi_epi8(a, b);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), wp));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), wp));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), wp));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), wp));
+        }
+        acc0 = _mm_srai_epi32(_mm_add_epi32(acc0, round), precision);
+        acc1 = _mm_srai_epi32(_mm_add_epi32(acc1, round), precision);
+        acc2 = _mm_srai_epi32(_mm_add_epi32(acc2, round), precision);
+        acc3 = _mm_srai_epi32(_mm_add_epi32(acc3, round), precision);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc0, acc1), _mm_packs_epi32(acc2, acc3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), packed);
+    }
+#endif
+
+    for (; x < rowSize; ++x) {
+        int acc = 0;
+        for (int k = 0; k < taps; ++k) {
+            acc += w[k]*rows[k][x];
+        }
+        dst[x] = clampByte(acc);
+    }
+}
+
+int minRows(int width)
+{
+    return std::max(1, (1 << 15)/std::max(1, width));
+}
+
+} // namespace
+
+Image resize(const ImageView &src, int width, int height, ResampleFilter filter)
+{
+    return resizeRows(src, width, height, filter, 0, height);
+}
+
+Image resizeRows(const ImageView &src, int width, int height, ResampleFilter filter, int first, int last)
+{
+    first = std::max(0, first);
+    last = std::min(height, last);
+    if (src.isNull() || width <= 0 || height <= 0 || first >= last) {
+        return Image();
+    }
+
+    const int channels = src.channels();
+
+    const bool horizontal = width != src.width();
+    const bool vertical = height != src.height();
+
+    // source rows the vertical pass reads, others need no horizontal pass,
+    // rows [top, bottom) cover them all
+    Coefficients vTable;
+    int top = first;
+    int bottom = last;
+    std::vector<char> needed(src.height(), 1);
+    if (vertical) {
+        vTable = coefficients(src.height(), height, filter);
+        std::fill(needed.begin(), needed.end(), 0);
+        top = src.height();
+        bottom = 0;
+        for (int y = first; y < last; ++y) {
+            const std::int16_t *w = &vTable.weights[static_cast<std::size_t>(y)*vTable.stride];
+            for (int k = 0; k < vTable.taps; ++k) {
+                if (w[k] != 0) {
+                    needed[vTable.first[y] + k] = 1;
+                    top = std::min(top, vTable.first[y] + k);
+                    bottom = std::max(bottom, vTable.first[y] + k + 1);
+                }
+            }
+        }
+    }
+
+    if (!horizontal && !vertical) {
+        return src.cropped(0, first, src.width(), last - first).toImage();
+    }
+
+    // horizontal pass, skipped if width is unchanged
+    // the vertical pass reads whole rows, a mirrored view is copied first then
+    // tmp holds source rows from top on
+    ImageView tmp = src.cropped(0, top, src.width(), bottom - top);
+    if (horizontal) {
+        const Coefficients hTable = coefficients(src.width(), width, filter);
+        Image out(width, bottom - top, channels);
+        parallelFor(top, bottom, [&](int begin, int end) {
+            std::vector<unsigned char> buffer(src.isMirrored() ? src.width()*channels + 64 : 0);
+            for (int y = begin; y < end; ++y) {
+                if (needed[y]) {
+                    horizontalRow(src.readRow(y, buffer.data()), out.scanLine(y - top), width, channels, hTable);
+                }
+            }
+        }, minRows(width));
+        if (!vertical) {
+            return out;
+        }
+        tmp = out;
+    } else if (src.isMirrored()) {
+        tmp = tmp.toImage();
+    }
+
+    // vertical pass
+    // rows with a zero weight are skipped by the horizontal pass,
+    // so they are never read here either
+    Image dst(width, last - first, channels);
+    parallelFor(first, last, [&](int begin, int end) {
+        std::vector<const unsigned char *> rows(vTable.taps);
+        std::vector<std::int16_t> weights(vTable.taps);
+        for (int y = begin; y < end; ++y) {
+            const std::int16_t *w = &vTable.weights[static_cast<std::size_t>(y)*vTable.stride];
+            int taps = 0;
+            for (int k = 0; k < vTable.taps; ++k) {
+                if (w[k] != 0) {
+                    rows[taps] = tmp.scanLine(vTable.first[y] + k - top);
+                    weights[taps] = w[k];
+                    ++taps;
+                }
+            }
+            verticalRow(rows.data(), weights.data(), taps, dst.scanLine(y - first), width*channels);
+        }
+    }, minRows(width));
+
+    return dst;
+}
+
+} // namespace ipk
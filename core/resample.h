@@ -0,0 +1,31 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include "image.h"
+
+namespace ipk {
+
+enum ResampleFilter {
+    ResampleNearest,
+    ResampleBilinear,
+    ResampleBicubic,
+    ResampleLanczos3,
+    // average of the covered source pixels, the right choice for downscale
+    ResampleArea
+};
+
+// resize src to width x height
+// the resampler is separable: per column and per row weight tables are
+// computed once, then a horizontal and a vertical pass run in fixed point
+// when downscaling, bilinear, bicubic and lanczos are widened by the scale
+// factor, so they average instead of aliasing
+// the horizontal pass is rounded and clamped to 8 bits, the overshoot of
+// bicubic and lanczos at sharp edges is cut before the vertical pass
+Image resize(const ImageView &src, int width, int height, ResampleFilter filter);
+// rows [first, last) of resize(src, width, height, filter), made from
+// the source rows they cover only, so the result can be made band by band
+Image resizeRows(const ImageView &src, int width, int height, ResampleFilter filter, int first, int last);
+
+} // namespace ipk
+
+#endif // RESAMPLE_H
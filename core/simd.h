@@ -0,0 +1,117 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// tiny 4 lanes float vector used by the kernels
+// it maps to SSE2 when available, and to plain arrays otherwise,
+// so that every kernel keeps a single copy of its math
+//
+// comparison return a mask, which is only meant to be used by select()
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IPK_SSE2
+#include <emmintrin.h>
+#else
+#include <cmath>
+#endif
+#include <cstring>
+
+namespace ipk {
+namespace simd {
+
+#ifdef IPK_SSE2
+
+struct Float4
+{
+    __m128 v;
+    Float4() {}
+    Float4(__m128 value) : v(value) {}
+    Float4(float value) : v(_mm_set1_ps(value)) {}
+};
+
+inline Float4 load(const float *p) { return _mm_load_ps(p); }
+inline void store(float *p, const Float4 &a) { _mm_store_ps(p, a.v); }
+inline Float4 operator+(const Float4 &a, const Float4 &b) { return _mm_add_ps(a.v, b.v); }
+inline Float4 operator-(const Float4 &a, const Float4 &b) { return _mm_sub_ps(a.v, b.v); }
+inline Float4 operator*(const Float4 &a, const Float4 &b) { return _mm_mul_ps(a.v, b.v); }
+inline Float4 operator/(const Float4 &a, const Float4 &b) { return _mm_div_ps(a.v, b.v); }
+inline Float4 min(const Float4 &a, const Float4 &b) { return _mm_min_ps(a.v, b.v); }
+inline Float4 max(const Float4 &a, const Float4 &b) { return _mm_max_ps(a.v, b.v); }
+inline Float4 equal(const Float4 &a, const Float4 &b) { return _mm_cmpeq_ps(a.v, b.v); }
+inline Float4 less(const Float4 &a, const Float4 &b) { return _mm_cmplt_ps(a.v, b.v); }
+// mask ? a : b
+inline Float4 select(const Float4 &mask, const Float4 &a, const Float4 &b)
+{
+    return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+inline Float4 floor(const Float4 &a)
+{
+    // truncate, then fix negative non-integer values
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f)));
+}
+// horizontal sum of the 4 lanes
+inline float sum(const Float4 &a)
+{
+    __m128 t = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v));
+    t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+    return _mm_cvtss_f32(t);
+}
+// 4 consecutive bytes to 4 lanes
+inline Float4 loadBytes(const unsigned char *p)
+{
+    int v;
+    std::memcpy(&v, p, sizeof(v));
+    __m128i zero = _mm_setzero_si128();
+    __m128i i32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+    return _mm_cvtepi32_ps(i32);
+}
+// round and saturate the first n lanes (n <= 4) to bytes
+inline void storeBytes(unsigned char *p, const Float4 &a, int n)
+{
+    __m128i i32 = _mm_cvtps_epi32(a.v);
+    __m128i u8 = _mm_packus_epi16(_mm_packs_epi32(i32, i32), i32);
+    int v = _mm_cvtsi128_si32(u8);
+    std::memcpy(p, &v, n);
+}
+
+#else
+
+struct Float4
+{
+    float v[4];
+    Float4() {}
+    Float4(float value) { v[0] = v[1] = v[2] = v[3] = value; }
+};
+
+#define IPK_FLOAT4_FOR(expr) Float4 r; for (int i = 0; i < 4; ++i) { r.v[i] = (expr); } return r
+
+inline Float4 load(const float *p) { IPK_FLOAT4_FOR(p[i]); }
+inline void store(float *p, const Float4 &a) { for (int i = 0; i < 4; ++i) { p[i] = a.v[i]; } }
+inline Float4 operator+(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i] + b.v[i]); }
+inline Float4 operator-(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i] - b.v[i]); }
+inline Float4 operator*(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i]*b.v[i]); }
+inline Float4 operator/(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i]/b.v[i]); }
+inline Float4 min(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline Float4 max(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline Float4 equal(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i] == b.v[i] ? 1.0f : 0.0f); }
+inline Float4 less(const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(a.v[i] < b.v[i] ? 1.0f : 0.0f); }
+inline Float4 select(const Float4 &mask, const Float4 &a, const Float4 &b) { IPK_FLOAT4_FOR(mask.v[i] != 0.0f ? a.v[i] : b.v[i]); }
+inline Float4 floor(const Float4 &a) { IPK_FLOAT4_FOR(static_cast<float>(std::floor(a.v[i]))); }
+inline float sum(const Float4 &a) { return a.v[0] + a.v[1] + a.v[2] + a.v[3]; }
+inline Float4 loadBytes(const unsigned char *p) { IPK_FLOAT4_FOR(static_cast<float>(p[i])); }
+inline void storeBytes(unsigned char *p, const Float4 &a, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        float v = a.v[i] < 0.0f ? 0.0f : (a.v[i] > 255.0f ? 255.0f : a.v[i]);
+        p[i] = static_cast<unsigned char>(v + 0.5f);
+    }
+}
+
+#undef IPK_FLOAT4_FOR
+
+#endif
+
+} // namespace simd
+} // namespace ipk
+
+#endif // SIMD_H
@@ -0,0 +1,316 @@
+#include "synthetic.h"
+#include "frequency.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+namespace ipk {
+
+namespace {
+
+const char *const patternNames[] = {
+    "gradient",
+    "checkerboard",
+    "noise",
+    "text",
+    "bars",
+    "impulses",
+    "scene"
+};
+
+const int patternCount = sizeof(patternNames)/sizeof(patternNames[0]);
+
+// an integer hash of the position, so rows can be made in any order
+inline std::uint32_t hash(std::uint32_t x, std::uint32_t y, std::uint32_t c, std::uint32_t seed)
+{
+    std::uint32_t h = x*0x9e3779b1u ^ y*0x85ebca77u ^ c*0xc2b2ae3du ^ seed*0x27d4eb2fu;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+// in [0, 1)
+inline double uniform(std::uint32_t h)
+{
+    return (h >> 8)/16777216.0;
+}
+
+// a row of samples in [0, 1], width*channels of them
+typedef std::function<void(int y, double *out)> RowFunction;
+
+RowFunction gradient(int width, int height, int channels)
+{
+    const double dx = 1.0/std::max(1, width - 1), dy = 1.0/std::max(1, height - 1);
+    const double dxy = 1.0/std::max(1, width + height - 2);
+    return [=](int y, double *out) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                const int k = c % 4;
+                *out++ = k == 0 ? x*dx : (k == 1 ? y*dy : (k == 2 ? (x + y)*dxy : 1 - x*dx));
+            }
+        }
+    };
+}
+
+RowFunction checkerboard(int width, int height, int channels)
+{
+    const int cell = std::max(1, std::min(width, height)/16);
+    return [=](int y, double *out) {
+        for (int x = 0; x < width; ++x) {
+            std::fill(out, out + channels, ((x/cell + y/cell) & 1) ? 1.0 : 0.0);
+            out += channels;
+        }
+    };
+}
+
+RowFunction noise(int width, int channels, std::uint32_t seed)
+{
+    const double twoPi = 2*std::acos(-1.0);
+    return [=](int y, double *out) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                // Box-Muller, from two hashes of the sample
+                const std::uint32_t h = hash(x, y, c, seed);
+                const double u1 = uniform(h) + 0.5/16777216.0, u2 = uniform(hash(h, y, c + 8, seed));
+                const double v = 0.5 + 0.15*std::sqrt(-2*std::log(u1))*std::cos(twoPi*u2);
+                *out++ = std::min(1.0, std::max(0.0, v));
+            }
+        }
+    };
+}
+
+// glyphs of 5x7 blocks in cells of 6x10, a line of them every 10 rows,
+// spaces between words, an empty line now and then, 2 cells of margin
+// cells grow with the image, so a page looks like a page at any size
+RowFunction text(int width, int height, int channels, std::uint32_t seed)
+{
+    const int scale = std::max(1, std::min(width, height)/768);
+    return [=](int y, double *out) {
+        const int gy = y/scale, line = gy/10, glyphRow = gy % 10;
+        const bool blankLine = gy < 20 || glyphRow >= 7 || hash(0, line, 1, seed) % 9 == 0;
+        for (int x = 0; x < width; ++x) {
+            const int gx = x/scale, column = gx/6, glyphColumn = gx % 6;
+            bool ink = false;
+            if (!blankLine && gx >= 12 && glyphColumn < 5 && hash(column, line, 2, seed) % 6 != 0) {
+                // a row of the glyph, a quarter of its blocks inked
+                const std::uint32_t bits = hash(column*8 + glyphRow, line, 3, seed);
+                ink = (bits >> glyphColumn) & (bits >> (glyphColumn + 8)) & 1;
+            }
+            std::fill(out, out + channels, ink ? 0.0 : 1.0);
+            out += channels;
+        }
+    };
+}
+
+// 6 columns of bars, with periods of 64, 32, 16, 8, 4 and 2 pixels
+RowFunction bars(int width, int height, int channels)
+{
+    return [=](int y, double *out) {
+        const bool vertical = y < height/2 || height == 1;
+        for (int x = 0; x < width; ++x) {
+            const int half = std::max(1, 32 >> (static_cast<long long>(x)*6/width));
+            const int position = vertical ? x : y;
+            std::fill(out, out + channels, (position/half) & 1 ? 1.0 : 0.0);
+            out += channels;
+        }
+    };
+}
+
+// a point in every 32x32 cell, where the hash of the cell puts it,
+// convolved with the psf the motion blur dialog uses by default
+RowFunction impulses(int width, int height, int channels, std::uint32_t seed)
+{
+    struct Tap
+    {
+        int dx;
+        int dy;
+        double weight;
+    };
+
+    const Plane psf = motionBlurPsf(10, 30);
+    // brightest where a point is alone
+    const double gain = 1/psf.max();
+    std::vector<Tap> taps;
+    cimg_forXY(psf, u, v) {
+        if (psf(u, v) > 0) {
+            taps.push_back({ u - psf.width()/2, v - psf.height()/2, psf(u, v)*gain });
+        }
+    }
+
+    auto isImpulse = [=](int x, int y) {
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return false;
+        }
+        const std::uint32_t h = hash(x/32, y/32, 4, seed);
+        return x % 32 == static_cast<int>(h % 32) && y % 32 == static_cast<int>((h >> 16) % 32);
+    };
+
+    return [=](int y, double *out) {
+        for (int x = 0; x < width; ++x) {
+            double v = 0;
+            for (const Tap &tap : taps) {
+                if (isImpulse(x - tap.dx, y - tap.dy)) {
+                    v += tap.weight;
+                }
+            }
+            std::fill(out, out + channels, std::min(1.0, v));
+            out += channels;
+        }
+    };
+}
+
+// the image ipkbench always timed, 8-bit values first
+RowFunction scene(int width, int height, int channels, std::uint32_t seed)
+{
+    const double cx = width/2.0, cy = height/2.0, r2 = std::pow(std::min(width, height)/4.0, 2);
+    return [=](int y, double *out) {
+        for (int x = 0; x < width; ++x) {
+            const bool disc = (x - cx)*(x - cx) + (y - cy)*(y - cy) < r2;
+            for (int c = 0; c < channels; ++c) {
+                // a gradient of its own for each channel
+                int v = c == 0 ? x*255/width : (c == 1 ? y*255/height : (x + y)*255/(width + height));
+                v = disc ? 255 - v : v;
+                v += static_cast<int>(hash(x, y, c, seed) & 31) - 16;
+                *out++ = std::max(0, std::min(255, v))/255.0;
+            }
+        }
+    };
+}
+
+RowFunction rowFunction(SyntheticPattern pattern, int width, int height, int channels, std::uint32_t seed)
+{
+    switch (pattern) {
+    case SyntheticGradient:
+        return gradient(width, height, channels);
+    case SyntheticCheckerboard:
+        return checkerboard(width, height, channels);
+    case SyntheticNoise:
+        return noise(width, channels, seed);
+    case SyntheticText:
+        return text(width, height, channels, seed);
+    case SyntheticBars:
+        return bars(width, height, channels);
+    case SyntheticImpulses:
+        return impulses(width, height, channels, seed);
+    case SyntheticScene:
+        return scene(width, height, channels, seed);
+    default:
+        throw std::invalid_argument("unknown synthetic pattern");
+    }
+}
+
+template<typename T>
+T toSample(double v);
+
+template<>
+inline unsigned char toSample<unsigned char>(double v)
+{
+    return static_cast<unsigned char>(v*255 + 0.5);
+}
+
+template<>
+inline std::uint16_t toSample<std::uint16_t>(double v)
+{
+    return static_cast<std::uint16_t>(v*65535 + 0.5);
+}
+
+template<>
+inline std::uint32_t toSample<std::uint32_t>(double v)
+{
+    return static_cast<std::uint32_t>(v*4294967295.0 + 0.5);
+}
+
+template<>
+inline float toSample<float>(double v)
+{
+    return static_cast<float>(v);
+}
+
+template<typename T>
+void fillRows(unsigned char *data, std::ptrdiff_t stride, int width, int height, int channels,
+              const RowFunction &row)
+{
+    const int n = width*channels;
+    parallelFor(0, height, [&](int first, int last) {
+        std::vector<double> values(n);
+        for (int y = first; y < last; ++y) {
+            row(y, values.data());
+            T *out = reinterpret_cast<T *>(data + y*stride);
+            for (int i = 0; i < n; ++i) {
+                out[i] = toSample<T>(values[i]);
+            }
+        }
+    }, std::max(1, (1 << 14)/std::max(1, n)));
+}
+
+} // namespace
+
+const char *syntheticPatternName(SyntheticPattern pattern)
+{
+    if (pattern < 0 || pattern >= patternCount) {
+        throw std::invalid_argument("unknown synthetic pattern");
+    }
+    return patternNames[pattern];
+}
+
+std::vector<std::string> syntheticPatternNames()
+{
+    return std::vector<std::string>(patternNames, patternNames + patternCount);
+}
+
+SyntheticPattern syntheticPattern(const std::string &name)
+{
+    for (int i = 0; i < patternCount; ++i) {
+        if (name == patternNames[i]) {
+            return static_cast<SyntheticPattern>(i);
+        }
+    }
+    throw std::invalid_argument("unknown synthetic pattern " + name);
+}
+
+void fillSynthetic(unsigned char *data, std::ptrdiff_t stride, int width, int height, int channels, SampleType type,
+                   SyntheticPattern pattern, std::uint32_t seed)
+{
+    if (width < 1 || height < 1 || channels < 1) {
+        throw std::invalid_argument("fillSynthetic: empty image");
+    }
+
+    const RowFunction row = rowFunction(pattern, width, height, channels, seed);
+    switch (type) {
+    case SampleUInt8:
+        fillRows<unsigned char>(data, stride, width, height, channels, row);
+        break;
+    case SampleUInt16:
+        fillRows<std::uint16_t>(data, stride, width, height, channels, row);
+        break;
+    case SampleUInt32:
+        fillRows<std::uint32_t>(data, stride, width, height, channels, row);
+        break;
+    default:
+        fillRows<float>(data, stride, width, height, channels, row);
+        break;
+    }
+}
+
+void fillSynthetic(const ImageView &dst, SyntheticPattern pattern, std::uint32_t seed)
+{
+    if (dst.isMirrored()) {
+        // rows go backward there, make them forward and copy
+        copyPixels(syntheticImage(dst.width(), dst.height(), dst.channels(), pattern, seed), dst);
+        return;
+    }
+    fillSynthetic(dst.scanLine(0), dst.rowStride(), dst.width(), dst.height(), dst.channels(), SampleUInt8,
+                  pattern, seed);
+}
+
+Image syntheticImage(int width, int height, int channels, SyntheticPattern pattern, std::uint32_t seed)
+{
+    Image img(width, height, channels);
+    fillSynthetic(img, pattern, seed);
+    return img;
+}
+
+} // namespace ipk
@@ -0,0 +1,57 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include "image.h"
+#include "mappedimage.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ipk {
+
+// test images made from nothing, for benchmarks and checks
+// any size, odd and prime ones included, any number of channels
+// the same pixels for the same arguments on any machine and thread
+// count: every sample is a function of its position and the seed only
+// the seed changes noise, text and impulses, the others don't need one
+
+enum SyntheticPattern {
+    // a smooth ramp per channel, each in its own direction
+    SyntheticGradient,
+    // black and white squares, 16 across the shorter side
+    SyntheticCheckerboard,
+    // gaussian, mean 0.5 and standard deviation 0.15 of the range, clipped
+    SyntheticNoise,
+    // black lines of glyph-like blocks on white, binary
+    SyntheticText,
+    // square wave bars, their period halving from left to right,
+    // vertical bars above and horizontal ones below, for frequency filters
+    SyntheticBars,
+    // sparse points blurred by motionBlurPsf(10, 30), what the inverse
+    // and Wiener filters restore
+    SyntheticImpulses,
+    // gradients, a disc with sharp edges and some noise, every channel
+    // different, so that no kernel gets an easy input
+    SyntheticScene
+};
+
+// gradient, checkerboard, noise, text, bars, impulses and scene
+const char *syntheticPatternName(SyntheticPattern pattern);
+std::vector<std::string> syntheticPatternNames();
+// throws std::invalid_argument for an unknown name
+SyntheticPattern syntheticPattern(const std::string &name);
+
+// width x height pixels of channels samples of type, rows stride bytes
+// apart from data on, negative for bottom up, written in parallel
+// samples span the full range of their type, 0 to 1 for floats, so the
+// same pattern at 16 bits has the 8-bit one in its high bytes, give or
+// take rounding
+void fillSynthetic(unsigned char *data, std::ptrdiff_t stride, int width, int height, int channels, SampleType type,
+                   SyntheticPattern pattern, std::uint32_t seed = 0);
+void fillSynthetic(const ImageView &dst, SyntheticPattern pattern, std::uint32_t seed = 0);
+Image syntheticImage(int width, int height, int channels, SyntheticPattern pattern, std::uint32_t seed = 0);
+
+} // namespace ipk
+
+#endif // SYNTHETIC_H
@@ -0,0 +1,153 @@
+#include "tiled.h"
+#include "parallel.h"
+#include "resample.h"
+#include "trace.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+bool isResample(const OperationStep &step)
+{
+    int width, height;
+    ResampleFilter filter;
+    return resampleTarget(step, ImageView(), width, height, filter);
+}
+
+// about 4 MB of rows, many times the halo, which is done twice
+int bandHeight(int width, int channels, int halo, int bandRows)
+{
+    if (bandRows > 0) {
+        return bandRows;
+    }
+    return std::max(std::max(64, 16*halo), (4 << 20)/std::max(1, width*channels));
+}
+
+Image allocateResult(const TileAllocator &allocate, int width, int height, int channels, bool final)
+{
+    Image dst = allocate(width, height, channels, final);
+    if (dst.isNull() || dst.width() != width || dst.height() != height || dst.channels() != channels) {
+        throw std::runtime_error("runTiled: can't make an image of " + std::to_string(width) + " x "
+                                 + std::to_string(height) + " x " + std::to_string(channels));
+    }
+    return dst;
+}
+
+// local steps [first, last), each band with halo rows above and below
+Image runLocal(const std::vector<OperationStep> &steps, std::size_t first, std::size_t last,
+               const ImageView &src, const TileAllocator &allocate, bool final, int bandRows)
+{
+    int halo = 0;
+    for (std::size_t i = first; i < last; ++i) {
+        halo += steps[i].operation->radius(steps[i].parameters);
+    }
+
+    // the channels of the result, from a single pixel
+    Image probe = src.cropped(0, 0, 1, 1).toImage();
+    for (std::size_t i = first; i < last; ++i) {
+        probe = steps[i].apply(probe);
+    }
+
+    Image dst = allocateResult(allocate, src.width(), src.height(), probe.channels(), final);
+    const int rows = bandHeight(src.width(), src.channels(), halo, bandRows);
+    const int bands = (src.height() + rows - 1)/rows;
+
+    parallelFor(0, bands, [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            TraceScope trace("band", "worker");
+            const int y0 = b*rows;
+            const int y1 = std::min(src.height(), y0 + rows);
+            const int top = std::max(0, y0 - halo);
+            const int bottom = std::min(src.height(), y1 + halo);
+
+            Image band;
+            ImageView current = src.cropped(0, top, src.width(), bottom - top);
+            for (std::size_t i = first; i < last; ++i) {
+                band = steps[i].apply(current);
+                current = band;
+            }
+            copyPixels(current.cropped(0, y0 - top, current.width(), y1 - y0),
+                       ImageView(dst).cropped(0, y0, dst.width(), y1 - y0));
+        }
+    });
+
+    return dst;
+}
+
+// resize or scale, band by band of the result
+Image runResample(const OperationStep &step, const ImageView &src, const TileAllocator &allocate,
+                  bool final, int bandRows)
+{
+    int width, height;
+    ResampleFilter filter;
+    resampleTarget(step, src, width, height, filter);
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument(std::string(step.operation->name) + ": the size must be positive");
+    }
+
+    Image dst = allocateResult(allocate, width, height, src.channels(), final);
+    const int rows = bandHeight(width, src.channels(), 0, bandRows);
+    const int bands = (height + rows - 1)/rows;
+
+    parallelFor(0, bands, [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            TraceScope trace("band", "worker");
+            const int y0 = b*rows;
+            const int y1 = std::min(height, y0 + rows);
+            copyPixels(resizeRows(src, width, height, filter, y0, y1),
+                       ImageView(dst).cropped(0, y0, width, y1 - y0));
+        }
+    });
+
+    return dst;
+}
+
+} // namespace
+
+bool isTileable(const OperationStep &step)
+{
+    return step.operation->radius || isResample(step);
+}
+
+Image runTiled(const Pipeline &pipeline, const ImageView &src, const TileAllocator &allocate, int bandRows)
+{
+    const std::vector<OperationStep> &steps = pipeline.steps();
+
+    for (const OperationStep &step : steps) {
+        if (!isTileable(step)) {
+            throw std::invalid_argument(std::string(step.operation->name) + " needs the whole image, it can't run band by band");
+        }
+    }
+
+    if (steps.empty()) {
+        Image dst = allocateResult(allocate, src.width(), src.height(), src.channels(), true);
+        copyPixels(src, dst);
+        return dst;
+    }
+
+    // every pass reads the result of the one before, which is dropped then
+    Image result;
+    ImageView current = src;
+    for (std::size_t i = 0; i < steps.size();) {
+        if (isResample(steps[i])) {
+            result = runResample(steps[i], current, allocate, i + 1 == steps.size(), bandRows);
+            ++i;
+        } else {
+            std::size_t j = i;
+            while (j < steps.size() && !isResample(steps[j])) {
+                ++j;
+            }
+            result = runLocal(steps, i, j, current, allocate, j == steps.size(), bandRows);
+            i = j;
+        }
+        current = result;
+    }
+
+    return result;
+}
+
+} // namespace ipk
@@ -0,0 +1,36 @@
+#ifndef TILED_H
+#define TILED_H
+
+#include "image.h"
+#include "pipeline.h"
+#include <functional>
+
+namespace ipk {
+
+// out-of-core run of a pipeline
+//
+// the steps run band by band, each band the full width of the image,
+// from a source to a result that may both be mapped files (see
+// mappedimage.h), so only the bands in flight, one per worker thread,
+// are in memory at any time, the system pages the rest in and out
+//
+// runs of local operations (those with a radius) are done together,
+// every band extended above and below by the sum of their radii,
+// resize and scale make every band of their result from the source
+// rows it covers, either way the result is the same as from run()
+// anything else needs the whole image
+
+// makes the image a pass writes into, the result of the pipeline if
+// final, the input of the next pass otherwise
+typedef std::function<Image(int width, int height, int channels, bool final)> TileAllocator;
+
+// whether runTiled() can run step
+bool isTileable(const OperationStep &step);
+// bandRows 0 picks bands of about 4 MB
+// throws std::invalid_argument for steps that aren't tileable, and
+// std::runtime_error if allocate returns a null image
+Image runTiled(const Pipeline &pipeline, const ImageView &src, const TileAllocator &allocate, int bandRows = 0);
+
+} // namespace ipk
+
+#endif // TILED_H
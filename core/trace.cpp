@@ -0,0 +1,164 @@
+#include "trace.h"
+#include <QFile>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace ipk {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Event
+{
+    std::string name;
+    const char *category;
+    // 'B' or 'E'
+    char phase;
+    // microseconds since startTracing()
+    double timestamp;
+    int thread;
+};
+
+std::atomic<bool> tracing(false);
+std::atomic<int> nextThread(1);
+thread_local int threadId = 0;
+
+// events of all threads, in the order they were recorded
+std::mutex mutex;
+std::vector<Event> events;
+std::map<int, std::string> threadNames;
+Clock::time_point start;
+
+int currentThread()
+{
+    if (threadId == 0) {
+        threadId = nextThread++;
+    }
+    return threadId;
+}
+
+void record(const char *name, const char *category, char phase)
+{
+    const int thread = currentThread();
+    std::lock_guard<std::mutex> lock(mutex);
+    // tracing may have stopped while waiting
+    if (!tracing.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const double timestamp = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    events.push_back({ name, category, phase, timestamp, thread });
+}
+
+// JSON string, quotes included
+QByteArray quoted(const std::string &text)
+{
+    QByteArray result = "\"";
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            result += '\\';
+            result += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            result += QByteArray("\\u00") + QByteArray::number(static_cast<unsigned char>(ch), 16).rightJustified(2, '0');
+        } else {
+            result += ch;
+        }
+    }
+    result += '"';
+
+    return result;
+}
+
+} // namespace
+
+void startTracing()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    events.clear();
+    threadNames.clear();
+    start = Clock::now();
+    tracing = true;
+}
+
+bool isTracing()
+{
+    return tracing.load(std::memory_order_relaxed);
+}
+
+bool stopTracing(const QString &fileName)
+{
+    std::vector<Event> recorded;
+    std::map<int, std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tracing = false;
+        recorded.swap(events);
+        names.swap(threadNames);
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    // a line per event, written as it goes, traces get long
+    bool ok = file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n") > 0;
+    const char *separator = "";
+    for (const auto &name : names) {
+        QByteArray line = separator;
+        line += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(name.first)
+                + ",\"args\":{\"name\":" + quoted(name.second) + "}}";
+        ok = ok && file.write(line) == line.size();
+        separator = ",\n";
+    }
+    for (const Event &event : recorded) {
+        QByteArray line = separator;
+        line += "{\"name\":" + quoted(event.name) + ",\"cat\":\"" + event.category + "\",\"ph\":\"" + event.phase
+                + "\",\"ts\":" + QByteArray::number(event.timestamp, 'f', 3)
+                + ",\"pid\":1,\"tid\":" + QByteArray::number(event.thread) + "}";
+        ok = ok && file.write(line) == line.size();
+        separator = ",\n";
+    }
+    ok = ok && file.write("\n]}\n") > 0;
+
+    return ok;
+}
+
+void setTraceThreadName(const std::string &name)
+{
+    if (!isTracing()) {
+        return;
+    }
+
+    const int thread = currentThread();
+    std::lock_guard<std::mutex> lock(mutex);
+    threadNames[thread] = name;
+}
+
+TraceScope::TraceScope(const char *name, const char *category) :
+    begun(isTracing())
+{
+    if (begun) {
+        record(name, category, 'B');
+    }
+}
+
+TraceScope::TraceScope(const std::string &name, const char *category) :
+    begun(isTracing())
+{
+    if (begun) {
+        record(name.c_str(), category, 'B');
+    }
+}
+
+TraceScope::~TraceScope()
+{
+    if (begun) {
+        record("", "", 'E');
+    }
+}
+
+} // namespace ipk
@@ -0,0 +1,42 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <string>
+
+namespace ipk {
+
+// a trace of what every thread did, written as Chrome trace event JSON
+// for chrome://tracing or Perfetto
+//
+// it's off until startTracing(), a TraceScope then records a begin and
+// an end event on its thread, ScopedTimer and OperationTimer (see
+// profiler.h) included, so phases and operations show up as well
+// while off, a TraceScope reads an atomic flag and that's all
+
+void startTracing();
+bool isTracing();
+// stop, and write the events recorded since startTracing() to fileName
+// returns false if the file can't be written, the events are gone anyway
+bool stopTracing(const QString &fileName);
+// the name of the calling thread in the trace, kept only while tracing
+void setTraceThreadName(const std::string &name);
+
+class TraceScope
+{
+public:
+    // category groups events in the viewer, a string literal
+    explicit TraceScope(const char *name, const char *category = "kernel");
+    explicit TraceScope(const std::string &name, const char *category = "kernel");
+    ~TraceScope();
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    // the end is recorded only if the begin was
+    bool begun;
+};
+
+} // namespace ipk
+
+#endif // TRACE_H
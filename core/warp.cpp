@@ -0,0 +1,664 @@
+#include "warp.h"
+#include "parallel.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+
+namespace ipk {
+
+using namespace simd;
+
+Transform::Transform()
+{
+    for (int i = 0; i < 9; ++i) {
+        m[i] = (i % 4 == 0) ? 1.0 : 0.0;
+    }
+}
+
+Transform::Transform(double a, double b, double c, double d, double e, double f,
+                     double g, double h, double i)
+{
+    m[0] = a; m[1] = b; m[2] = c;
+    m[3] = d; m[4] = e; m[5] = f;
+    m[6] = g; m[7] = h; m[8] = i;
+}
+
+Transform Transform::translation(double dx, double dy)
+{
+    return Transform(1, 0, dx, 0, 1, dy);
+}
+
+Transform Transform::rotation(double degree, double cx, double cy)
+{
+    // y axis points down, so counterclockwise on screen
+    // is clockwise in the usual math convention
+    double rad = degree*3.14159265358979323846/180.0;
+    double c = std::cos(rad), s = std::sin(rad);
+
+    return translation(cx, cy)*Transform(c, s, 0, -s, c, 0)*translation(-cx, -cy);
+}
+
+Transform Transform::quadToQuad(const double from[8], const double to[8])
+{
+    // u = (a*x + b*y + c)/(g*x + h*y + 1)
+    // v = (d*x + e*y + f)/(g*x + h*y + 1)
+    // two linear equations per point in (a, b, c, d, e, f, g, h)
+    double A[8][9];
+    for (int i = 0; i < 4; ++i) {
+        double x = from[2*i], y = from[2*i + 1], u = to[2*i], v = to[2*i + 1];
+        double r0[9] = { x, y, 1, 0, 0, 0, -x*u, -y*u, u };
+        double r1[9] = { 0, 0, 0, x, y, 1, -x*v, -y*v, v };
+        std::copy(r0, r0 + 9, A[2*i]);
+        std::copy(r1, r1 + 9, A[2*i + 1]);
+    }
+
+    // gaussian elimination with partial pivoting
+    for (int col = 0; col < 8; ++col) {
+        int pivot = col;
+        for (int row = col + 1; row < 8; ++row) {
+            if (std::fabs(A[row][col]) > std::fabs(A[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (std::fabs(A[pivot][col]) < 1e-12) {
+            throw std::invalid_argument("quadToQuad: degenerate quadrilateral");
+        }
+        std::swap(A[col], A[pivot]);
+        for (int row = 0; row < 8; ++row) {
+            if (row != col) {
+                double k = A[row][col]/A[col][col];
+                for (int j = col; j < 9; ++j) {
+                    A[row][j] -= k*A[col][j];
+                }
+            }
+        }
+    }
+
+    double p[8];
+    for (int i = 0; i < 8; ++i) {
+        p[i] = A[i][8]/A[i][i];
+    }
+
+    return Transform(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], 1.0);
+}
+
+bool Transform::isAffine() const
+{
+    return m[6] == 0.0 && m[7] == 0.0 && m[8] == 1.0;
+}
+
+Transform Transform::inverted() const
+{
+    // adjugate over determinant
+    double a = m[4]*m[8] - m[5]*m[7];
+    double b = m[2]*m[7] - m[1]*m[8];
+    double c = m[1]*m[5] - m[2]*m[4];
+    double d = m[5]*m[6] - m[3]*m[8];
+    double e = m[0]*m[8] - m[2]*m[6];
+    double f = m[2]*m[3] - m[0]*m[5];
+    double g = m[3]*m[7] - m[4]*m[6];
+    double h = m[1]*m[6] - m[0]*m[7];
+    double i = m[0]*m[4] - m[1]*m[3];
+    double det = m[0]*a + m[1]*d + m[2]*g;
+
+    if (std::fabs(det) < 1e-12) {
+        throw std::invalid_argument("Transform::inverted: singular transform");
+    }
+
+    Transform result(a/det, b/det, c/det, d/det, e/det, f/det, g/det, h/det, i/det);
+    if (isAffine()) {
+        // keep it exactly affine
+        result.m[6] = result.m[7] = 0.0;
+        result.m[8] = 1.0;
+    }
+
+    return result;
+}
+
+void Transform::map(double x, double y, double &mx, double &my) const
+{
+    double w = m[6]*x + m[7]*y + m[8];
+    mx = (m[0]*x + m[1]*y + m[2])/w;
+    my = (m[3]*x + m[4]*y + m[5])/w;
+}
+
+bool Transform::operator==(const Transform &other) const
+{
+    return std::equal(m, m + 9, other.m);
+}
+
+Transform operator*(const Transform &a, const Transform &b)
+{
+    Transform result;
+
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            double v = 0.0;
+            for (int k = 0; k < 3; ++k) {
+                v += a.m[row*3 + k]*b.m[k*3 + col];
+            }
+            result.m[row*3 + col] = v;
+        }
+    }
+
+    return result;
+}
+
+namespace {
+
+// taps of the interpolation kernel around floor(s) are [floor(s) - before, floor(s) + after]
+void kernelExtent(WarpInterpolation interpolation, int &before, int &after)
+{
+    switch (interpolation) {
+    case WarpBicubic:
+        before = 1;
+        after = 2;
+        break;
+    case WarpBilinear:
+        before = 0;
+        after = 1;
+        break;
+    default:
+        before = after = 0;
+        break;
+    }
+}
+
+// Keys cubic convolution weights, a = -0.5, for fraction t
+inline void cubicWeights(float t, float w[4])
+{
+    float t2 = t*t, t3 = t2*t;
+    w[0] = -0.5f*t3 + t2 - 0.5f*t;
+    w[1] = 1.5f*t3 - 2.5f*t2 + 1.0f;
+    w[2] = -1.5f*t3 + 2.0f*t2 + 0.5f*t;
+    w[3] = 0.5f*t3 - 0.5f*t2;
+}
+
+// integer part for the taps of the kernel, nearest rounds instead
+inline int tapBase(float s, WarpInterpolation interpolation)
+{
+    return static_cast<int>(std::floor(interpolation == WarpNearest ? s + 0.5f : s));
+}
+
+// grow or shrink [begin, end) inside [x0, x1) so that its ends agree with inside(),
+// the estimate is off by a pixel at most
+template <typename Inside>
+void fixInterval(int x0, int x1, int &begin, int &end, Inside inside)
+{
+    if (begin < end) {
+        while (begin > x0 && inside(begin - 1)) {
+            --begin;
+        }
+        while (begin < end && !inside(begin)) {
+            ++begin;
+        }
+        while (end < x1 && inside(end)) {
+            ++end;
+        }
+        while (end > begin && !inside(end - 1)) {
+            --end;
+        }
+    } else {
+        // empty estimate, only the pixels next to it can be inside
+        for (int x = std::max(x0, begin - 1); x < std::min(x1, begin + 1); ++x) {
+            if (inside(x)) {
+                begin = x;
+                end = x + 1;
+                while (end < x1 && inside(end)) {
+                    ++end;
+                }
+                return;
+            }
+        }
+    }
+}
+
+} // namespace
+
+WarpMap::WarpMap(const Transform &transform, int srcWidth, int srcHeight,
+                 int width, int height, WarpInterpolation interpolation) :
+    t(transform), srcW(srcWidth), srcH(srcHeight), w(width), h(height), interp(interpolation)
+{
+    const Transform inverse = transform.inverted();
+
+    // affine maps are linear along a row, a single segment is exact
+    // perspective maps are approximated by 8 pixels linear segments,
+    // within a few hundredths of a pixel for usual transforms
+    segmentSize = inverse.isAffine() ? std::max(1, w) : 8;
+    nodesPerRow = (w + segmentSize - 1)/segmentSize;
+    nodes.resize(static_cast<std::size_t>(nodesPerRow)*h*4);
+    spans.resize(h);
+
+    int before, after;
+    kernelExtent(interpolation, before, after);
+
+    // pixels where w' of the inverse is 0 or less are beyond the horizon
+    // of a perspective transform, they map to no point of the source,
+    // and close to it to points ever further away, so w' must be above
+    // a tiny fraction of what it is at its largest
+    const double *m = inverse.m;
+    const double horizon = 1e-9*(std::fabs(m[6])*w + std::fabs(m[7])*h + std::fabs(m[8]));
+    auto weight = [m](int x, int y) { return m[6]*(x + 0.5) + m[7]*(y + 0.5) + m[8]; };
+
+    parallelFor(0, h, [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            // w' is linear along the row, so the pixels in front of the
+            // horizon are an interval too, solved then fixed for rounding
+            auto visible = [&](int x) { return weight(x, y) > horizon; };
+            int visibleBegin = 0, visibleEnd = w;
+            if (m[6] != 0.0) {
+                const double edge = (horizon - m[7]*(y + 0.5) - m[8])/m[6] - 0.5;
+                const double clamped = std::max(-1.0, std::min(static_cast<double>(w), edge));
+                if (m[6] > 0.0) {
+                    visibleBegin = static_cast<int>(std::ceil(clamped));
+                } else {
+                    visibleEnd = static_cast<int>(std::floor(clamped)) + 1;
+                }
+                visibleBegin = std::max(0, std::min(w, visibleBegin));
+                visibleEnd = std::max(visibleBegin, std::min(w, visibleEnd));
+            } else if (!visible(0)) {
+                visibleEnd = 0;
+            }
+            fixInterval(0, w, visibleBegin, visibleEnd, visible);
+
+            float *n = &nodes[static_cast<std::size_t>(y)*nodesPerRow*4];
+            // node j holds x, y at the segment start, and the step per pixel
+            // output pixel centers map to source pixel index space
+            // they're taken from the visible pixels of the segment only,
+            // the others are left out of the spans below
+            for (int j = 0; j < nodesPerRow; ++j) {
+                int x0 = j*segmentSize;
+                int x1 = std::min(w, x0 + segmentSize);
+                int a = std::max(x0, visibleBegin), b = std::min(x1, visibleEnd);
+                if (a >= b) {
+                    std::fill(n + 4*j, n + 4*j + 4, 0.0f);
+                    continue;
+                }
+                // the start of the next segment, if it's visible too
+                if (b < x1 || !visible(x1)) {
+                    --b;
+                }
+                double ax, ay, bx, by;
+                inverse.map(a + 0.5, y + 0.5, ax, ay);
+                inverse.map(b + 0.5, y + 0.5, bx, by);
+                const double dx = b > a ? (bx - ax)/(b - a) : 0.0;
+                const double dy = b > a ? (by - ay)/(b - a) : 0.0;
+                n[4*j] = static_cast<float>(ax - (a - x0)*dx - 0.5);
+                n[4*j + 1] = static_cast<float>(ay - (a - x0)*dy - 0.5);
+                n[4*j + 2] = static_cast<float>(dx);
+                n[4*j + 3] = static_cast<float>(dy);
+            }
+
+            // a row maps to a straight line in the source, so both sets of
+            // pixels are intervals, they are solved per segment from the
+            // linear coordinates, then fixed for rounding with the exact test
+            Span span = { w, 0, w, 0 };
+            for (int j = 0; j < nodesPerRow; ++j) {
+                const int x0 = std::max(j*segmentSize, visibleBegin);
+                const int x1 = std::min(std::min(w, j*segmentSize + segmentSize), visibleEnd);
+                if (x0 >= x1) {
+                    continue;
+                }
+                int begin, end;
+                clip(n + 4*j, j*segmentSize, x0, x1, -after, srcW + before, -after, srcH + before, begin, end);
+                fixInterval(x0, x1, begin, end, [&](int x) { return isInside(x, y, false); });
+                if (begin < end) {
+                    span.begin = std::min(span.begin, begin);
+                    span.end = std::max(span.end, end);
+                }
+                clip(n + 4*j, j*segmentSize, x0, x1, before, srcW - after, before, srcH - after, begin, end);
+                fixInterval(x0, x1, begin, end, [&](int x) { return isInside(x, y, true); });
+                if (begin < end) {
+                    span.safeBegin = std::min(span.safeBegin, begin);
+                    span.safeEnd = std::max(span.safeEnd, end);
+                }
+            }
+            if (span.begin >= span.end) {
+                span.begin = span.end = 0;
+            }
+            if (span.safeBegin >= span.safeEnd) {
+                span.safeBegin = span.safeEnd = span.begin;
+            }
+            spans[y] = span;
+        }
+    }, std::max(1, (1 << 14)/std::max(1, w)));
+}
+
+void WarpMap::clip(const float *node, int start, int x0, int x1, float loX, float hiX, float loY, float hiY,
+                   int &begin, int &end) const
+{
+    // nearest rounds the coordinate before taking the integer part
+    const float shift = interp == WarpNearest ? -0.5f : 0.0f;
+    double t0 = x0 - start, t1 = x1 - start;
+    const float lo[2] = { loX + shift, loY + shift }, hi[2] = { hiX + shift, hiY + shift };
+
+    // lo <= node + t*step < hi on both axes
+    for (int axis = 0; axis < 2; ++axis) {
+        double a = node[axis], d = node[axis + 2];
+        if (d == 0.0) {
+            if (a < lo[axis] || a >= hi[axis]) {
+                t1 = t0;
+            }
+        } else {
+            double ta = (lo[axis] - a)/d, tb = (hi[axis] - a)/d;
+            t0 = std::max(t0, std::min(ta, tb));
+            t1 = std::min(t1, std::max(ta, tb));
+        }
+    }
+
+    if (t1 <= t0) {
+        begin = end = x0;
+        return;
+    }
+    begin = start + static_cast<int>(std::ceil(t0));
+    end = std::min(x1, start + static_cast<int>(std::ceil(t1)));
+    begin = std::min(begin, end);
+}
+
+bool WarpMap::isInside(int x, int y, bool allTaps) const
+{
+    int before, after;
+    kernelExtent(interp, before, after);
+    float sx, sy;
+    source(x, y, sx, sy);
+    // far outside, or not a number, before any conversion to int
+    if (!(sx > -after - 2 && sx < srcW + before + 2 && sy > -after - 2 && sy < srcH + before + 2)) {
+        return false;
+    }
+    int ix = tapBase(sx, interp), iy = tapBase(sy, interp);
+
+    if (allTaps) {
+        return ix - before >= 0 && ix + after < srcW && iy - before >= 0 && iy + after < srcH;
+    }
+    return ix + after >= 0 && ix - before < srcW && iy + after >= 0 && iy - before < srcH;
+}
+
+void WarpMap::source(int x, int y, float &sx, float &sy) const
+{
+    const float *n = node(x, y);
+    float t = static_cast<float>(x % segmentSize);
+
+    sx = n[0] + t*n[2];
+    sy = n[1] + t*n[3];
+}
+
+bool WarpMap::matches(const Transform &transform, int srcWidth, int srcHeight,
+                      int width, int height, WarpInterpolation interpolation) const
+{
+    return t == transform && srcW == srcWidth && srcH == srcHeight
+            && w == width && h == height && interp == interpolation;
+}
+
+std::shared_ptr<const WarpMap> warpMap(const Transform &transform, int srcWidth, int srcHeight,
+                                       int width, int height, WarpInterpolation interpolation)
+{
+    static std::mutex mutex;
+    static std::list<std::shared_ptr<const WarpMap> > cache;
+    const std::size_t cacheSize = 8;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if ((*it)->matches(transform, srcWidth, srcHeight, width, height, interpolation)) {
+                // move to front, most recently used
+                cache.splice(cache.begin(), cache, it);
+                return cache.front();
+            }
+        }
+    }
+
+    // build outside the lock, two threads might build the same map, that's fine
+    std::shared_ptr<const WarpMap> map = std::make_shared<WarpMap>(
+                transform, srcWidth, srcHeight, width, height, interpolation);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    cache.push_front(map);
+    if (cache.size() > cacheSize) {
+        cache.pop_back();
+    }
+
+    return map;
+}
+
+namespace {
+
+// output tiles, a tile reads a compact area of the source
+const int tileSize = 64;
+
+// sample with bound check, taps outside src count as background
+void sampleChecked(const ImageView &src, float sx, float sy, WarpInterpolation interpolation,
+                   unsigned char background, unsigned char *out)
+{
+    const int c = src.channels();
+    int before, after;
+    kernelExtent(interpolation, before, after);
+    int ix = tapBase(sx, interpolation), iy = tapBase(sy, interpolation);
+
+    float wx[4] = { 1.0f, 0.0f, 0.0f, 0.0f }, wy[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    if (interpolation == WarpBilinear) {
+        float fx = sx - ix, fy = sy - iy;
+        wx[0] = 1.0f - fx; wx[1] = fx;
+        wy[0] = 1.0f - fy; wy[1] = fy;
+    } else if (interpolation == WarpBicubic) {
+        cubicWeights(sx - ix, wx);
+        cubicWeights(sy - iy, wy);
+    }
+
+    for (int ch = 0; ch < c; ++ch) {
+        float acc = 0.0f;
+        for (int j = 0; j <= before + after; ++j) {
+            int yy = iy - before + j;
+            for (int k = 0; k <= before + after; ++k) {
+                int xx = ix - before + k;
+                float v = background;
+                if (xx >= 0 && xx < src.width() && yy >= 0 && yy < src.height()) {
+                    v = src.scanLine(yy)[xx*c + ch];
+                }
+                acc += wx[k]*wy[j]*v;
+            }
+        }
+        acc = std::min(255.0f, std::max(0.0f, acc));
+        out[ch] = static_cast<unsigned char>(acc + 0.5f);
+    }
+}
+
+// sample with all taps inside src, for C channels
+template <int C, WarpInterpolation I>
+inline void sampleSafe(const ImageView &src, float sx, float sy, unsigned char *out)
+{
+    if (I == WarpNearest) {
+        const unsigned char *p = src.scanLine(tapBase(sy, I)) + tapBase(sx, I)*C;
+        for (int ch = 0; ch < C; ++ch) {
+            out[ch] = p[ch];
+        }
+        return;
+    }
+
+    int ix = static_cast<int>(std::floor(sx)), iy = static_cast<int>(std::floor(sy));
+    float fx = sx - ix, fy = sy - iy;
+
+    // loads read up to 3 bytes past the last tap, rows have room for it
+    if (I == WarpBilinear) {
+        const unsigned char *r0 = src.scanLine(iy) + ix*C;
+        const unsigned char *r1 = src.scanLine(iy + 1) + ix*C;
+        if (C == 1) {
+            // both taps of a row in one load, the 2 other lanes get a zero weight
+            alignas(16) float wv[4] = { 1.0f - fx, fx, 0.0f, 0.0f };
+            Float4 weights = load(wv);
+            Float4 acc = loadBytes(r0)*weights*Float4(1.0f - fy) + loadBytes(r1)*weights*Float4(fy);
+            storeBytes(out, Float4(sum(acc)), 1);
+            return;
+        }
+        // one lane per channel
+        Float4 p00 = loadBytes(r0), p10 = loadBytes(r1);
+        Float4 top = p00 + (loadBytes(r0 + C) - p00)*Float4(fx);
+        Float4 bottom = p10 + (loadBytes(r1 + C) - p10)*Float4(fx);
+        storeBytes(out, top + (bottom - top)*Float4(fy), C);
+        return;
+    }
+
+    float wx[4], wy[4];
+    cubicWeights(fx, wx);
+    cubicWeights(fy, wy);
+
+    if (C == 1) {
+        // the 4 taps of a row in one load
+        Float4 acc(0.0f);
+        alignas(16) float wv[4] = { wx[0], wx[1], wx[2], wx[3] };
+        Float4 weights = load(wv);
+        for (int j = 0; j < 4; ++j) {
+            acc = acc + loadBytes(src.scanLine(iy - 1 + j) + ix - 1)*Float4(wy[j]);
+        }
+        storeBytes(out, Float4(sum(acc*weights)), 1);
+        return;
+    }
+
+    // one lane per channel
+    Float4 acc(0.0f);
+    for (int j = 0; j < 4; ++j) {
+        const unsigned char *row = src.scanLine(iy - 1 + j) + (ix - 1)*C;
+        Float4 r = loadBytes(row)*Float4(wx[0]) + loadBytes(row + C)*Float4(wx[1])
+                + loadBytes(row + 2*C)*Float4(wx[2]) + loadBytes(row + 3*C)*Float4(wx[3]);
+        acc = acc + r*Float4(wy[j]);
+    }
+    storeBytes(out, acc, C);
+}
+
+// output pixels [begin, end) of row y, all of them in the safe span
+template <int C, WarpInterpolation I>
+void safeRun(const ImageView &src, const WarpMap &map, int y, int begin, int end, unsigned char *out)
+{
+    // coordinates are linear inside a segment, no lookup per pixel
+    const int segment = map.segment();
+    for (int x = begin; x < end;) {
+        int start = x/segment*segment;
+        int last = std::min(end, start + segment);
+        const float *n = map.node(x, y);
+        for (; x < last; ++x) {
+            float t = static_cast<float>(x - start);
+            sampleSafe<C, I>(src, n[0] + t*n[2], n[1] + t*n[3], out + x*C);
+        }
+    }
+}
+
+typedef void (*SafeRun)(const ImageView &, const WarpMap &, int, int, int, unsigned char *);
+
+template <WarpInterpolation I>
+SafeRun safeRunFor(int channels)
+{
+    switch (channels) {
+    case 1:
+        return safeRun<1, I>;
+    case 2:
+        return safeRun<2, I>;
+    case 3:
+        return safeRun<3, I>;
+    default:
+        return safeRun<4, I>;
+    }
+}
+
+} // namespace
+
+Image warp(const ImageView &src, const WarpMap &map, unsigned char background)
+{
+    if (src.isNull() || src.channels() > 4) {
+        throw std::invalid_argument("warp: unsupported image");
+    }
+    if (src.isMirrored()) {
+        // samplers load consecutive pixels, the map is fixed, so copy
+        return warp(src.toImage(), map, background);
+    }
+    if (src.width() != map.srcWidth() || src.height() != map.srcHeight()) {
+        throw std::invalid_argument("warp: the map was built for another source size");
+    }
+
+    const int c = src.channels();
+    const WarpInterpolation interpolation = map.interpolation();
+    SafeRun run = interpolation == WarpNearest ? safeRunFor<WarpNearest>(c)
+                : interpolation == WarpBilinear ? safeRunFor<WarpBilinear>(c)
+                : safeRunFor<WarpBicubic>(c);
+
+    Image dst(map.width(), map.height(), c);
+    const int tilesX = (map.width() + tileSize - 1)/tileSize;
+    const int tilesY = (map.height() + tileSize - 1)/tileSize;
+
+    parallelFor(0, tilesX*tilesY, [&](int first, int last) {
+        for (int tile = first; tile < last; ++tile) {
+            int x0 = (tile % tilesX)*tileSize, x1 = std::min(map.width(), x0 + tileSize);
+            int y0 = (tile/tilesX)*tileSize, y1 = std::min(map.height(), y0 + tileSize);
+            for (int y = y0; y < y1; ++y) {
+                unsigned char *out = dst.scanLine(y);
+                const WarpMap::Span &span = map.span(y);
+                // background | checked | safe | checked | background
+                int begin = std::max(x0, std::min(x1, span.begin));
+                int end = std::max(begin, std::min(x1, span.end));
+                int safeBegin = std::max(begin, std::min(end, span.safeBegin));
+                int safeEnd = std::max(safeBegin, std::min(end, span.safeEnd));
+                std::memset(out + x0*c, background, (begin - x0)*c);
+                std::memset(out + end*c, background, (x1 - end)*c);
+                for (int x = begin; x < end; ++x) {
+                    if (x == safeBegin && safeBegin < safeEnd) {
+                        run(src, map, y, safeBegin, safeEnd, out);
+                        x = safeEnd - 1;
+                        continue;
+                    }
+                    float sx, sy;
+                    map.source(x, y, sx, sy);
+                    sampleChecked(src, sx, sy, interpolation, background, out + x*c);
+                }
+            }
+        }
+    });
+
+    return dst;
+}
+
+Image warp(const ImageView &src, const Transform &transform, int width, int height,
+           WarpInterpolation interpolation, unsigned char background)
+{
+    if (src.isMirrored()) {
+        // warp the unmirrored pixels instead, x -> width - x goes into the transform
+        Transform mirror(-1, 0, src.width(), 0, 1, 0);
+        return warp(src.mirrored(), transform*mirror, width, height, interpolation, background);
+    }
+
+    std::shared_ptr<const WarpMap> map = warpMap(transform, src.width(), src.height(),
+                                                 width, height, interpolation);
+    return warp(src, *map, background);
+}
+
+Image rotate(const ImageView &src, double degree, WarpInterpolation interpolation,
+             bool expand, unsigned char background)
+{
+    int width = src.width(), height = src.height();
+    Transform r = Transform::rotation(degree, 0.0, 0.0);
+
+    if (expand) {
+        // bounding box of the rotated corners
+        double minX = 0, maxX = 0, minY = 0, maxY = 0;
+        double corners[4][2] = { { -0.5, -0.5 }, { 0.5, -0.5 }, { -0.5, 0.5 }, { 0.5, 0.5 } };
+        for (auto &corner : corners) {
+            double x, y;
+            r.map(corner[0]*src.width(), corner[1]*src.height(), x, y);
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+        // avoid an extra row or column from rounding errors
+        width = static_cast<int>(std::ceil(maxX - minX - 1e-6));
+        height = static_cast<int>(std::ceil(maxY - minY - 1e-6));
+    }
+
+    Transform t = Transform::translation(width/2.0, height/2.0)*r
+            *Transform::translation(-src.width()/2.0, -src.height()/2.0);
+
+    return warp(src, t, width, height, interpolation, background);
+}
+
+} // namespace ipk
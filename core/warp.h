@@ -0,0 +1,119 @@
+#ifndef WARP_H
+#define WARP_H
+
+#include "image.h"
+#include <memory>
+#include <vector>
+
+namespace ipk {
+
+// 3x3 projective transform, row major
+// (x', y', w') = m*(x, y, 1), and the point is (x'/w', y'/w')
+// the last row is (0, 0, 1) for affine transform
+struct Transform
+{
+    double m[9];
+
+    Transform();
+    Transform(double a, double b, double c, double d, double e, double f,
+              double g = 0.0, double h = 0.0, double i = 1.0);
+
+    static Transform translation(double dx, double dy);
+    // rotate counterclockwise by degree around (cx, cy)
+    // y axis points down, like image rows
+    static Transform rotation(double degree, double cx, double cy);
+    // perspective transform mapping the 4 points from onto the 4 points to
+    // points are given as x0, y0, x1, y1, ...
+    static Transform quadToQuad(const double from[8], const double to[8]);
+
+    bool isAffine() const;
+    Transform inverted() const;
+    // infinite or not a number where w' is 0, beyond the horizon of
+    // a perspective transform, WarpMap leaves those points out
+    void map(double x, double y, double &mx, double &my) const;
+    bool operator==(const Transform &other) const;
+};
+
+// a * b, apply b first
+Transform operator*(const Transform &a, const Transform &b);
+
+enum WarpInterpolation {
+    WarpNearest,
+    WarpBilinear,
+    WarpBicubic
+};
+
+// precomputed source coordinates of every output row
+// coordinates are exact at nodes every segment pixels and linear in between,
+// affine transforms need a single segment per row
+// spans tell where all the taps of the interpolation kernel are inside
+// the source, so that the sampling loop needs no bound check there
+class WarpMap
+{
+public:
+    WarpMap(const Transform &transform, int srcWidth, int srcHeight,
+            int width, int height, WarpInterpolation interpolation);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int srcWidth() const { return srcW; }
+    int srcHeight() const { return srcH; }
+    WarpInterpolation interpolation() const { return interp; }
+    int segment() const { return segmentSize; }
+    // source coordinate of output pixel (x, y), in pixel index space
+    void source(int x, int y, float &sx, float &sy) const;
+    // x, y and per pixel step at the start of the segment holding (x, y)
+    const float *node(int x, int y) const
+    {
+        return &nodes[(static_cast<std::size_t>(y)*nodesPerRow + x/segmentSize)*4];
+    }
+
+    struct Span
+    {
+        // pixels outside [begin, end) are background
+        int begin, end;
+        // pixels in [safeBegin, safeEnd) need no bound check
+        int safeBegin, safeEnd;
+    };
+    const Span &span(int y) const { return spans[y]; }
+
+    bool matches(const Transform &transform, int srcWidth, int srcHeight,
+                 int width, int height, WarpInterpolation interpolation) const;
+
+private:
+    // estimate of the pixels of [x0, x1) whose coordinate is in [lo, hi),
+    // node is the one of the segment starting at start
+    void clip(const float *node, int start, int x0, int x1, float loX, float hiX, float loY, float hiY,
+              int &begin, int &end) const;
+    // taps of the kernel at (x, y), any or all of them, inside the source
+    bool isInside(int x, int y, bool allTaps) const;
+
+    Transform t;
+    int srcW, srcH, w, h;
+    WarpInterpolation interp;
+    int segmentSize;
+    int nodesPerRow;
+    // x, y and per pixel step at the start of every segment, row by row
+    std::vector<float> nodes;
+    std::vector<Span> spans;
+};
+
+// map for the given geometry, taken from a small cache of recently used maps,
+// so a batch of images of the same size only pays for it once
+std::shared_ptr<const WarpMap> warpMap(const Transform &transform, int srcWidth, int srcHeight,
+                                       int width, int height, WarpInterpolation interpolation);
+
+// warp src into a width x height image, transform maps src coordinates
+// to output coordinates, pixels mapped from outside src are set to background
+Image warp(const ImageView &src, const Transform &transform, int width, int height,
+           WarpInterpolation interpolation, unsigned char background = 0);
+Image warp(const ImageView &src, const WarpMap &map, unsigned char background = 0);
+
+// rotate counterclockwise by degree around the image center
+// the output is enlarged to hold the whole rotated image if expand is true
+Image rotate(const ImageView &src, double degree, WarpInterpolation interpolation,
+             bool expand = true, unsigned char background = 0);
+
+} // namespace ipk
+
+#endif // WARP_H